@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Read-only asset pack in the "assets" data partition, memory-mapped once at boot so every
+// asset is a plain pointer into flash (no copies, no heap). Built on the host with
+// tools/mkassets.py. Layout (little-endian):
+//   asset_pack_hdr_t, asset_entry_t[count], then the data of each entry (4-byte aligned).
+
+#define ASSET_PACK_MAGIC 0x4B50414Cu // "LAPK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_NAME_LEN 24            // NUL-padded; names are at most 23 chars
+
+typedef enum {
+    ASSET_ANY = 0,
+    ASSET_FONT = 1,  // LVGL binary font (lv_font_conv --format bin)
+    ASSET_IMAGE = 2, // LVGL image: lv_img_header_t followed by the pixel data
+    ASSET_CLIP = 3,  // sound: payload in `codec` (audio_codec_t), `param` = sample rate
+} asset_type_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;      // ASSET_PACK_MAGIC
+    uint16_t version;    // ASSET_PACK_VERSION
+    uint16_t count;      // entries in the index
+    uint32_t total_size; // bytes of the whole pack, header included
+} asset_pack_hdr_t;
+
+typedef struct __attribute__((packed)) {
+    char name[ASSET_NAME_LEN];
+    uint8_t type;    // asset_type_t
+    uint8_t codec;   // clips: audio_codec_t
+    uint16_t reserved;
+    uint32_t offset; // from the start of the pack
+    uint32_t size;
+    uint32_t param;  // clips: sample rate in Hz
+} asset_entry_t;
+
+typedef struct {
+    const char *name;
+    asset_type_t type;
+    uint8_t codec;
+    uint32_t param;
+    const void *data; // mapped flash, valid for the lifetime of the app
+    size_t size;
+} asset_t;
+
+// Map the pack. ESP_ERR_NOT_FOUND without an "assets" partition, ESP_ERR_INVALID_VERSION /
+// ESP_ERR_INVALID_SIZE if the partition holds no valid pack (e.g. it was never flashed).
+esp_err_t assets_mount(void);
+
+// Entries in the mounted pack (0 if none).
+int assets_count(void);
+
+bool assets_get(int index, asset_t *out);
+
+// Look up by name; `type` ASSET_ANY matches any type.
+bool assets_find(const char *name, asset_type_t type, asset_t *out);
+
+const char *asset_type_name(asset_type_t type);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,9 +2,12 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "esp_err.h"
 
+#include "audio_codec.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -12,17 +15,135 @@ extern "C" {
 typedef struct {
     int sample_rate_hz;   // e.g. 16000
     int volume_percent;   // 0..100
+    // Optional: called from the writer task when lip-sync levels start flowing (wake the renderer).
+    void (*on_lipsync_start)(void);
 } audio_config_t;
 
 // Initialize ES8311 + I2S speaker output.
 esp_err_t audio_init(const audio_config_t *cfg);
 
-// Play 16-bit signed little-endian mono PCM at the configured sample rate.
+typedef struct {
+    uint32_t queued_samples; // samples waiting in the playback queue
+    uint32_t queued_ms;      // same, in milliseconds at the output rate
+    uint32_t capacity_ms;    // approximate queue capacity
+    uint32_t underruns;      // times the queue ran dry mid-stream
+    uint32_t late_chunks;    // timed chunks that missed their playout deadline (or arrived out of order)
+    uint32_t dropped_chunks; // duplicate chunks, or chunks rejected because the queue was full
+    uint32_t concealed_ms;   // silence/fade inserted for underruns and timestamp gaps
+} audio_stats_t;
+
+// Jitter buffer tuning for timed streams.
+typedef struct {
+    uint16_t target_ms; // buffer this much before a new stream starts (0 = start immediately)
+    uint16_t fade_ms;   // underrun concealment: fade the last sample to silence over this long
+    uint16_t hold_ms;   // keep a starved stream alive this long before treating it as ended
+} audio_jitter_config_t;
+
+#define AUDIO_CHUNK_F_TIMED (1u << 0) // seq/ts_ms are valid: dedupe and schedule against ts_ms
+#define AUDIO_CHUNK_F_END   (1u << 1) // last chunk of the stream (may carry no samples)
+// More payload of the chunk queued by the previous call (same stream_id/seq), e.g. a large
+// frame received in slices. Pass the chunk's own ts_ms; timed parts skip the duplicate check,
+// are scheduled after the samples already queued, and are dropped (*dropped) if the chunk
+// they continue was not accepted.
+#define AUDIO_CHUNK_F_CONT  (1u << 2)
+
+typedef struct {
+    uint16_t stream_id; // chunks of one utterance share an id; a new id starts a new stream
+    uint16_t flags;     // AUDIO_CHUNK_F_*
+    uint32_t seq;       // increments per chunk
+    uint32_t ts_ms;     // stream time of the first sample in this chunk
+    uint8_t codec;      // audio_codec_t of the payload (0 = PCM16)
+    uint32_t sample_rate; // PCM16/ADPCM source rate in Hz (8000..48000), resampled on playout;
+                          // 0 = output rate. Opus always decodes at the output rate.
+} audio_chunk_info_t;
+
+// Queue one chunk of a (possibly timed) speech stream: `len` bytes of payload in info->codec
+// format, decoded (and resampled to the output rate) by the writer task. Duplicate/reordered timed chunks are discarded and
+// reported through *dropped (may be NULL); that still returns ESP_OK.
+// ESP_ERR_NOT_SUPPORTED for a codec not built in, ESP_ERR_INVALID_ARG for a malformed payload.
+esp_err_t audio_enqueue_chunk(const audio_chunk_info_t *info, const void *data, size_t len,
+                              uint32_t timeout_ms, bool *dropped);
+
+// Queue 16-bit signed little-endian mono PCM (configured sample rate) for playback.
+// Returns as soon as the samples are copied into the queue; a dedicated writer task feeds I2S.
+// ESP_ERR_TIMEOUT if the queue stayed full for timeout_ms (UINT32_MAX waits forever).
+esp_err_t audio_enqueue_pcm16_mono(const int16_t *samples, size_t sample_count, uint32_t timeout_ms);
+
+// Same as audio_enqueue_pcm16_mono(), waiting as long as needed for queue space.
 esp_err_t audio_play_pcm16_mono(const int16_t *samples, size_t sample_count);
 
-// Convenience test sound.
+// Drop everything queued and stop the chunk currently playing (clip and tone voices too).
+void audio_flush(void);
+
+// Queue fill level and jitter buffer counters.
+esp_err_t audio_get_stats(audio_stats_t *out);
+void audio_reset_stats(void);
+
+void audio_get_jitter_config(audio_jitter_config_t *out);
+esp_err_t audio_set_jitter_config(const audio_jitter_config_t *cfg);
+
+// Speaker volume 0..100 (ES8311 DAC volume). Safe at run time: the register write is
+// arbitrated with touch reads on the shared I2C bus.
+esp_err_t audio_set_volume(int percent);
+int audio_get_volume(void);
+
+// Output sample rate (Hz) that PCM payloads are expected in.
+int audio_get_sample_rate(void);
+
+// On-device lip sync: an envelope follower over the speech sent to I2S, time-stamped with
+// when each block is actually heard. Clips and tones on the mixer voices are ignored.
+typedef struct {
+    bool enabled;        // drive mouth_open from the speech envelope
+    uint16_t attack_ms;  // envelope rise time constant
+    uint16_t release_ms; // envelope fall time constant
+    uint16_t full_scale; // RMS (PCM16 units) that opens the mouth fully
+} audio_lipsync_config_t;
+
+void audio_get_lipsync_config(audio_lipsync_config_t *out);
+esp_err_t audio_set_lipsync_config(const audio_lipsync_config_t *cfg);
+
+// Mouth openness (0..1) for what the speaker is playing right now. Returns true while lip
+// sync is enabled and speech is (or is about to be) audible; *open is 0 otherwise.
+bool audio_lipsync_level(float *open);
+
+// Mixer: the speech queue above, one sound clip and one tone generator play at the same time,
+// each with its own gain, summed with saturation by the writer task.
+typedef enum {
+    AUDIO_VOICE_SPEECH = 0,
+    AUDIO_VOICE_CLIP,
+    AUDIO_VOICE_TONE,
+    AUDIO_VOICE_COUNT,
+} audio_voice_t;
+
+const char *audio_voice_name(audio_voice_t voice);
+
+// Per-voice gain 0..100 (100 = unity), applied before the ES8311 volume.
+esp_err_t audio_set_voice_gain(audio_voice_t voice, int percent);
+int audio_get_voice_gain(audio_voice_t voice);
+
+// Play a sound clip over whatever is playing, replacing the clip currently on the clip voice.
+// `data` is read in place while it plays, so it must stay valid (e.g. mapped flash): PCM16
+// (2-byte aligned) or IMA-ADPCM at the output rate. Returns immediately.
+esp_err_t audio_play_clip(const void *data, size_t len, audio_codec_t codec);
+
+// Tone on the tone voice (wavetable generator), mixed over speech; replaces a running tone.
+// Returns immediately.
 esp_err_t audio_beep(int freq_hz, int duration_ms);
 
+// Output stage benchmark: CPU cycles per second of audio spent turning speech into I2S frames
+// and copying them into DMA memory (what i2s_channel_write does). Runs each case on the calling
+// task over synthetic audio (best of three); the speaker is not touched.
+typedef struct {
+    uint32_t audio_ms;    // audio per case
+    uint32_t stereo_copy; // software mono-to-stereo duplication, 4 bytes/frame to DMA
+    uint32_t mono;        // mono slot: speech straight to the driver, 2 bytes/frame
+    uint32_t mono_mixed;  // mono slot with a clip and a tone mixed over speech
+    uint32_t cpu_mhz;
+    bool mono_slot;       // this build plays through the mono slot path
+} audio_bench_t;
+
+esp_err_t audio_bench(uint32_t audio_ms, audio_bench_t *out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Speech payload codecs accepted by the playback queue. Values are on the wire
+// (binary speak frame header `codec` byte), so don't renumber.
+typedef enum {
+    AUDIO_CODEC_PCM16 = 0,     // PCM16 LE mono
+    AUDIO_CODEC_IMA_ADPCM = 1, // IMA-ADPCM blocks (4:1), see below
+    AUDIO_CODEC_OPUS = 2,      // sequence of [u16 LE length][Opus packet]; needs CONFIG_LITTLEAI_AUDIO_OPUS
+} audio_codec_t;
+
+// IMA-ADPCM payload = back-to-back blocks of IMA_ADPCM_BLOCK_BYTES (the last one may be shorter).
+// Block: int16 LE first sample, u8 step index (0..88), u8 reserved, then 4-bit codes, low nibble
+// first. A block of N bytes decodes to 1 + 2*(N-4) samples. Every block is self-contained, so
+// a lost chunk never corrupts the next one.
+#define IMA_ADPCM_BLOCK_BYTES 256
+#define IMA_ADPCM_BLOCK_SAMPLES (1 + 2 * (IMA_ADPCM_BLOCK_BYTES - 4))
+
+// Largest unit audio_codec_decode_next() produces (120 ms Opus frame @ 16 kHz).
+#define AUDIO_CODEC_MAX_FRAME_SAMPLES 1920
+
+bool audio_codec_supported(audio_codec_t codec);
+const char *audio_codec_name(audio_codec_t codec);
+bool audio_codec_from_name(const char *name, audio_codec_t *out);
+
+// Number of samples `len` bytes of payload decode to, or -1 if malformed/unsupported.
+int audio_codec_decoded_samples(audio_codec_t codec, const uint8_t *data, size_t len, int sample_rate);
+
+// Length of the longest prefix of `len` bytes (<= max_len) that ends on a decode unit boundary.
+// Used to split large chunks; returns 0 if the first unit alone exceeds max_len.
+size_t audio_codec_split_point(audio_codec_t codec, const uint8_t *data, size_t len, size_t max_len);
+
+// Length of the longest prefix of `len` bytes made of complete decode units only (a partial
+// trailing ADPCM block / Opus packet is left out). Used when a payload arrives in pieces.
+size_t audio_codec_unit_prefix(audio_codec_t codec, const uint8_t *data, size_t len);
+
+// Walks a compressed payload one decode unit (ADPCM block / Opus packet) at a time.
+typedef struct {
+    audio_codec_t codec;
+    const uint8_t *p;
+    size_t left;
+} audio_codec_cursor_t;
+
+// Decode the next unit into out[AUDIO_CODEC_MAX_FRAME_SAMPLES].
+// Returns samples produced, 0 at the end of the payload, or -1 on a decode error.
+int audio_codec_decode_next(audio_codec_cursor_t *c, int16_t *out, int sample_rate);
+
+// Reset inter-packet decoder state (Opus) at the start of a new stream.
+void audio_codec_reset(void);
+
+size_t ima_adpcm_decode_block(const uint8_t *block, size_t len, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
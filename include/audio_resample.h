@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fixed-point polyphase resampler for mono PCM16: a Blackman-windowed sinc with
+// AUDIO_RESAMPLE_TAPS taps in AUDIO_RESAMPLE_PHASES phases (Q15), cut off below the lower of
+// the two Nyquist rates. Streaming: state (history, fractional position) carries across calls,
+// so a stream can be fed in pieces of any size. Adds AUDIO_RESAMPLE_TAPS / 2 input samples of delay.
+
+#define AUDIO_RESAMPLE_TAPS 32
+#define AUDIO_RESAMPLE_PHASE_BITS 5
+#define AUDIO_RESAMPLE_PHASES (1 << AUDIO_RESAMPLE_PHASE_BITS)
+#define AUDIO_RESAMPLE_MIN_RATE 8000
+#define AUDIO_RESAMPLE_MAX_RATE 48000
+
+typedef struct {
+    int in_rate;
+    int out_rate;
+    uint32_t step;     // input samples per output sample, Q16 (truncated)...
+    uint32_t step_rem; // ...plus step_rem / out_rate, carried in pos_rem so the rate is exact
+    uint32_t pos;      // Q16 position of the next output, relative to the newest input sample
+    uint32_t pos_rem;
+    uint16_t head;
+    int16_t hist[2 * AUDIO_RESAMPLE_TAPS];                     // doubled so the window is contiguous
+    int16_t coef[AUDIO_RESAMPLE_PHASES][AUDIO_RESAMPLE_TAPS];
+} audio_resampler_t;
+
+// Build the filter for in_rate -> out_rate (floating point, once per rate change) and reset.
+// ESP_ERR_INVALID_ARG for a rate outside AUDIO_RESAMPLE_MIN_RATE..AUDIO_RESAMPLE_MAX_RATE.
+esp_err_t audio_resampler_init(audio_resampler_t *r, int in_rate, int out_rate);
+
+// Forget the history (start of a new stream); keeps the filter.
+void audio_resampler_reset(audio_resampler_t *r);
+
+// Resample in[n_in] into out[cap]. Stops when the input is used up or out is full; *used is
+// the input consumed. Returns the samples written.
+size_t audio_resample(audio_resampler_t *r, const int16_t *in, size_t n_in, size_t *used, int16_t *out, size_t cap);
+
+// Output samples `n_in` input samples produce (rounded; a stream's pieces may differ by one).
+size_t audio_resample_out_len(int in_rate, int out_rate, size_t n_in);
+
+#ifdef __cplusplus
+}
+#endif
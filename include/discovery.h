@@ -0,0 +1,20 @@
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// mDNS/DNS-SD advertisement, so hosts find devices on the LAN without knowing their IPs.
+// The device answers as <name>-<mac6>.local and offers one "_littleai._tcp" service on the
+// /ws port, named `instance_name`. Its TXT records describe what the firmware offers
+// (see README "Discovery"), so fleet tools can pick devices without connecting first.
+//
+// Call once after Wi-Fi is started; mDNS follows the STA and SoftAP interfaces by itself.
+// ESP_ERR_NOT_SUPPORTED when built without CONFIG_LITTLEAI_MDNS.
+esp_err_t discovery_start(const char *instance_name);
+
+#ifdef __cplusplus
+}
+#endif
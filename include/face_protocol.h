@@ -17,6 +17,40 @@ typedef enum {
     EXPR_SLEEPING,
 } expression_t;
 
+// Channels the on-device animator can drive.
+typedef enum {
+    FACE_CH_GAZE_X = 0,
+    FACE_CH_GAZE_Y,
+    FACE_CH_EYE_OPEN,
+    FACE_CH_MOUTH_OPEN,
+    FACE_CH_COUNT,
+} face_channel_t;
+
+typedef enum {
+    FACE_EASE_LINEAR = 0,
+    FACE_EASE_IN,     // quadratic
+    FACE_EASE_OUT,    // quadratic
+    FACE_EASE_IN_OUT, // smoothstep
+    FACE_EASE_STEP,   // hold, then jump at the end of the segment
+} face_ease_t;
+
+#define FACE_ANIM_MAX_KEYS 4
+
+// One keyframe segment: move to `value` over `duration_ms`.
+typedef struct {
+    float value;
+    uint16_t duration_ms;
+    uint8_t ease; // face_ease_t
+} face_anim_key_t;
+
+// Keyframe track for one channel; the renderer interpolates it at frame rate.
+typedef struct {
+    uint32_t start_ms; // 0 = no track
+    float from;        // channel value when the track started
+    uint8_t nkeys;
+    face_anim_key_t keys[FACE_ANIM_MAX_KEYS];
+} face_anim_t;
+
 typedef struct {
     expression_t expression;
     float intensity;     // 0..1
@@ -39,10 +73,56 @@ typedef struct {
     uint32_t viseme_until_ms;
 
     uint32_t blink_until_ms;
+
+    // Per-channel tracks (face_channel_t). The plain fields above already hold each track's
+    // final value; readers get the in-between values from face_state_animate().
+    face_anim_t anim[FACE_CH_COUNT];
+
+    // Bumped only when the writer publishes a change (WS commands); lets observers detect updates.
+    // TTL expiry and animation progress are not published: each reader derives them from its own
+    // snapshot (face_state_expire(), face_state_animate()), so they never bump this.
+    uint32_t version;
 } face_state_t;
 
 void face_state_init(face_state_t *s);
 
+// TTL-bound fields of face_state_t (face_state_expire() result bits).
+#define FACE_TTL_CAPTION 0x01
+#define FACE_TTL_VISEME 0x02
+#define FACE_TTL_BLINK 0x04
+
+// Clear the fields of *s whose TTL has run out at now_ms (caption -> "", viseme -> rest,
+// blink off) and return the FACE_TTL_* bits that expired. Meant for a private snapshot:
+// expiry is derived by each reader and never written back to the shared state.
+uint8_t face_state_expire(face_state_t *s, uint32_t now_ms);
+
+// Start a track on `ch` from the channel's current value (mid-animation if one is running).
+// The plain field is set to the last key straight away, and eye/mouth tracks turn the rig
+// override on. Returns false if nkeys is 0 or more than FACE_ANIM_MAX_KEYS.
+bool face_anim_start(face_state_t *s, face_channel_t ch, const face_anim_key_t *keys, int nkeys, uint32_t now_ms);
+
+// Drop the track on `ch` (a direct set of the channel wins over a running animation).
+static inline void face_anim_cancel(face_state_t *s, face_channel_t ch) {
+    s->anim[ch].start_ms = 0;
+}
+
+// Replace each animated channel of *s with its value at now_ms and drop finished tracks.
+// Like face_state_expire(), meant for a private snapshot. Returns true while a track runs.
+bool face_state_animate(face_state_t *s, uint32_t now_ms);
+
+// Face state shared between one writer task and any number of readers (seqlock).
+// The writer keeps its own working copy and publishes complete snapshots; readers copy the
+// latest consistent snapshot and never block (a read that races a publish just retries, and
+// a publish is one sizeof(face_state_t) copy inside a critical section).
+typedef struct {
+    uint32_t seq; // odd while a publish is in progress
+    face_state_t state;
+} face_store_t;
+
+void face_store_init(face_store_t *s, const face_state_t *initial);
+void face_store_publish(face_store_t *s, const face_state_t *src);
+void face_store_read(const face_store_t *s, face_state_t *dst);
+
 #ifdef __cplusplus
 }
 #endif
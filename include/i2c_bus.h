@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "driver/i2c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Owner of the shared I2C bus (I2C_NUM_0): touch controller, ES8311 codec and the TCA9554
+// IO expander. Every transaction goes through i2c_bus_run() or i2c_bus_xfer(), which serialize
+// access with a priority-inheriting mutex and keep per-device counters. Keep
+// each run short (one register write, one touch read) so no device waits behind another for
+// more than a single transfer.
+
+typedef enum {
+    I2C_DEV_TOUCH = 0,
+    I2C_DEV_CODEC,
+    I2C_DEV_EXPANDER,
+    I2C_DEV_SCAN,      // bring-up bus scan
+    I2C_DEV_COUNT,
+} i2c_bus_dev_t;
+
+typedef struct {
+    uint32_t ok;            // transactions that succeeded (possibly after retries)
+    uint32_t errors;        // transactions that failed after all retries
+    uint32_t retries;       // extra attempts made
+    uint32_t lock_timeouts; // gave up waiting for the bus
+    uint32_t max_wait_us;   // longest wait for the bus
+} i2c_bus_stats_t;
+
+// Install the bus at CONFIG_LITTLEAI_I2C_CLK_HZ. Call once before any device is created.
+esp_err_t i2c_bus_init(void);
+
+i2c_port_t i2c_bus_port(void);
+uint32_t i2c_bus_clk_hz(void);
+
+// Run fn(ctx) once with the bus held. For sequences that allocate or change device state part
+// way through (driver creation, codec setup) and so must not simply be run again.
+// ESP_ERR_TIMEOUT if the bus stayed busy for timeout_ms; otherwise fn's result.
+esp_err_t i2c_bus_run(i2c_bus_dev_t dev, esp_err_t (*fn)(void *ctx), void *ctx, uint32_t timeout_ms);
+
+// Like i2c_bus_run, but retries fn up to 2 more times if it fails. Only for a single register
+// transfer (one read or one write), which is safe to repeat.
+esp_err_t i2c_bus_xfer(i2c_bus_dev_t dev, esp_err_t (*fn)(void *ctx), void *ctx, uint32_t timeout_ms);
+
+void i2c_bus_get_stats(i2c_bus_dev_t dev, i2c_bus_stats_t *out);
+void i2c_bus_reset_stats(void);
+const char *i2c_bus_dev_name(i2c_bus_dev_t dev);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Streaming firmware update into the inactive OTA slot. Image bytes go straight to flash as
+// they arrive (nothing is buffered beyond the caller's slice) while a running SHA-256 is kept.
+// ota_begin/write/finish/abort keep one session in RAM and must be called from a single task
+// (the WS server's), which also lets a transfer resume after its connection dropped.
+
+typedef enum {
+    OTA_IDLE = 0,
+    OTA_RECEIVING, // session open, waiting for image bytes
+    OTA_READY,     // verified and set as boot partition; runs after the next restart
+} ota_phase_t;
+
+typedef struct {
+    ota_phase_t phase;
+    uint32_t size;        // image size of the session (0 when idle)
+    uint32_t written;     // bytes written so far: where the next ota_write must start
+    const char *target;   // label of the slot being written ("" when idle)
+    const char *running;  // label of the running slot
+    bool pending_verify;  // running image is a fresh update not yet confirmed (see ota_confirm_tick)
+    const char *version;  // running app version (esp_app_desc_t)
+} ota_status_t;
+
+// Start an update of `size` bytes whose SHA-256 is `sha256`, or resume a session already open
+// for the same image (*offset = bytes already written). Any other session is aborted first.
+// ESP_ERR_NOT_FOUND if the partition table has no OTA slot, ESP_ERR_INVALID_SIZE if the image
+// does not fit.
+esp_err_t ota_begin(uint32_t size, const uint8_t sha256[32], uint32_t *offset);
+
+// Write `len` image bytes at `offset`, which must be the current resume point
+// (ESP_ERR_INVALID_ARG otherwise, or if it runs past the image size).
+// ESP_ERR_INVALID_STATE without an open session.
+esp_err_t ota_write(uint32_t offset, const void *data, size_t len);
+
+// After the last byte: check the SHA-256 and the image, then make it the boot partition.
+// ESP_ERR_INVALID_CRC on a hash mismatch; the session is dropped on any failure.
+esp_err_t ota_finish(void);
+
+// Drop the session; if it was already READY the running slot boots again.
+void ota_abort(void);
+
+void ota_get_status(ota_status_t *out);
+const char *ota_phase_name(ota_phase_t phase);
+
+// Restart in `delay_ms` (lets a reply go out first).
+void ota_restart_after(uint32_t delay_ms);
+
+// Call about once a second. A freshly updated image (rollback pending) is marked valid once
+// Wi-Fi is connected; if that takes longer than CONFIG_LITTLEAI_OTA_CONFIRM_TIMEOUT_S, the
+// device rolls back to the previous image and restarts.
+void ota_confirm_tick(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Lightweight runtime counters for the render, flush, WS and audio paths.
+// Recording is a short critical section, so it is fine on hot paths and from ISRs.
+
+typedef enum {
+    PERF_FRAME = 0,     // lv_timer_handler() calls that rendered and flushed something (us)
+    PERF_APPLY_FACE,    // apply_face_state() (us)
+    PERF_LVGL_LOCK,     // time spent waiting for the LVGL mutex (us)
+    PERF_FLUSH_DMA,     // flush_cb -> panel transfer done (us)
+    PERF_FLUSH_BYTES,   // bytes sent to the panel per frame
+    PERF_FLUSH_AREAS,   // flush_cb calls per frame
+    PERF_WS_HANDLER,    // WS frame receive + dispatch + reply on /ws (us)
+    PERF_WS_AUDIO,      // the same on /ws/audio (us)
+    PERF_AUDIO_WRITE,   // one i2s_channel_write() block (us)
+    PERF_ID_COUNT,
+} perf_id_t;
+
+// Histogram bucket upper bounds (exclusive, microseconds); the last bucket is open-ended.
+#define PERF_HIST_BUCKETS 9
+extern const uint32_t perf_hist_bounds_us[PERF_HIST_BUCKETS - 1];
+
+typedef struct {
+    uint32_t count;
+    uint32_t max;
+    uint64_t total;
+    uint32_t hist[PERF_HIST_BUCKETS]; // only filled for time ids (see perf_is_time)
+} perf_stat_t;
+
+void perf_record(perf_id_t id, uint32_t value);
+
+// Record the time elapsed since `start_us` (an esp_timer_get_time() value).
+static inline void perf_record_since(perf_id_t id, int64_t start_us)
+{
+    perf_record(id, (uint32_t)(esp_timer_get_time() - start_us));
+}
+
+void perf_get(perf_id_t id, perf_stat_t *out);
+void perf_reset(void);
+
+const char *perf_name(perf_id_t id);
+bool perf_is_time(perf_id_t id);
+
+#ifdef __cplusplus
+}
+#endif
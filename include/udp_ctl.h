@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Optional low-latency face channel on UDP port CONFIG_LITTLEAI_UDP_PORT, for streams where
+// only the newest value matters (gaze tracking, mouth from a host-side lip sync). There is no
+// ack or retransmit: a lost packet is simply superseded by the next one, and one arriving
+// after a newer packet from the same stream is dropped. Everything else stays on /ws.
+//
+// Datagram: [udp_ctl_hdr_t][float32 LE values, one group per set UDP_CTL_F_* bit, in bit order]
+// hdr_len is the value offset, so newer hosts can append header fields.
+#define UDP_CTL_MAGIC 0x55 // 'U'
+#define UDP_CTL_HDR_LEN 12
+
+#define UDP_CTL_F_GAZE 0x01  // x, y (-1..1), like {"type":"gaze"}
+#define UDP_CTL_F_MOUTH 0x02 // open (0..1), like {"type":"mouth","open":...}
+#define UDP_CTL_F_EYES 0x04  // open (0..1), like {"type":"eyes","open":...}
+
+typedef struct __attribute__((packed)) {
+    uint8_t magic;      // UDP_CTL_MAGIC
+    uint8_t hdr_len;    // bytes from start of datagram to the values (>= UDP_CTL_HDR_LEN)
+    uint8_t fields;     // UDP_CTL_F_*
+    uint8_t reserved;
+    uint16_t stream_id; // host-chosen; sequence numbers are tracked per (sender, stream_id)
+    uint16_t reserved2;
+    uint32_t seq;       // increments per datagram; <= the newest seen (mod 2^32) is stale
+} udp_ctl_hdr_t;
+
+typedef struct {
+    bool running;
+    uint16_t port;
+    uint32_t rx;        // datagrams received
+    uint32_t applied;   // handed to the face state
+    uint32_t stale;     // dropped: older than (or a repeat of) one already applied
+    uint32_t malformed; // dropped: bad magic/length/values
+    uint32_t coalesced; // applied, but merged with a newer one before the WS task ran
+    uint32_t busy;      // dropped: the WS task's work queue was full
+    uint8_t streams;    // (sender, stream_id) pairs heard from recently
+} udp_ctl_stats_t;
+
+// Bind the port and start the receiver task. Call after ws_server_start(), which applies the
+// updates. ESP_ERR_NOT_SUPPORTED when built without CONFIG_LITTLEAI_UDP_CONTROL.
+esp_err_t udp_ctl_start(void);
+
+// Bound port, or 0 if the channel is not running.
+uint16_t udp_ctl_port(void);
+
+void udp_ctl_get_stats(udp_ctl_stats_t *out);
+void udp_ctl_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,6 +21,38 @@ bool wifi_manager_is_connected(void);
 // Get current STA IP as string (pointer valid until next call). Returns NULL if not connected.
 const char* wifi_manager_get_ip_str(void);
 
+// Connection profile: trades incoming-frame latency against radio power.
+typedef enum {
+    WIFI_PROFILE_REALTIME = 0, // modem power save off: no beacon-interval wakeup delay on RX
+    WIFI_PROFILE_BALANCED,     // WIFI_PS_MIN_MODEM (IDF default): wake every DTIM
+    WIFI_PROFILE_BATTERY,      // WIFI_PS_MAX_MODEM with a long listen interval
+    WIFI_PROFILE_COUNT,
+} wifi_profile_t;
+
+const char *wifi_profile_name(wifi_profile_t p);
+bool wifi_profile_from_name(const char *name, wifi_profile_t *out);
+
+// Switch profile and save it to NVS. Power save changes immediately; the listen interval
+// takes effect on the next association.
+esp_err_t wifi_manager_set_profile(wifi_profile_t p);
+wifi_profile_t wifi_manager_get_profile(void);
+
+typedef struct {
+    bool connected;
+    int8_t rssi;              // dBm of the current AP (0 if not connected)
+    uint8_t channel;
+    uint8_t bssid[6];
+    uint16_t last_reason;     // wifi_err_reason_t of the last disconnect (0 = none yet)
+    uint32_t connects;        // times an IP was obtained
+    uint32_t disconnects;
+    uint32_t fast_connects;   // connects that used the cached BSSID/channel instead of a full scan
+    uint32_t roam_queries;    // 802.11v BSS transition queries sent on low RSSI
+    uint32_t last_connect_ms; // connect attempt to IP, for the last connect
+    uint32_t uptime_ms;       // how long the current connection has been up
+} wifi_stats_t;
+
+void wifi_manager_get_stats(wifi_stats_t *out);
+
 #ifdef __cplusplus
 }
 #endif
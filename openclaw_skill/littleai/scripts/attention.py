@@ -19,6 +19,7 @@ Modes:
 import argparse
 import asyncio
 import base64
+import json
 import os
 import subprocess
 import tempfile
@@ -27,6 +28,8 @@ import array
 
 import websockets
 
+from pacing import pace
+
 SAMPLE_RATE = 16000
 CHUNK_SAMPLES = 800  # 50ms @ 16kHz
 
@@ -91,6 +94,7 @@ async def stream_wav(ws, wav_path: str):
             rep = await ws.recv()
             if '"ok":true' not in rep:
                 print(rep)
+            await pace(rep)
 
     await ws_send(ws, {"type": "mouth", "open": 0.0})
     await ws_send(ws, {"type": "rig_clear"})
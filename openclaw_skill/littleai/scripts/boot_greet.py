@@ -15,6 +15,7 @@ Notes:
 import argparse
 import asyncio
 import base64
+import json
 import os
 import random
 import subprocess
@@ -24,9 +25,12 @@ import array
 
 import websockets
 
+from pacing import pace
+
 SAMPLE_RATE = 16000
 CHUNK_SAMPLES = 800  # 50ms @ 16kHz
 
+
 GREETINGS = [
     "Howdy!",
     "Hey there!",
@@ -126,6 +130,7 @@ async def stream_wav(ws, wav_path: str):
             rep = await ws.recv()
             if '"ok":true' not in rep:
                 print(rep)
+            await pace(rep)
 
     await ws_send(ws, {"type": "mouth", "open": 0.0})
     await ws_send(ws, {"type": "rig_clear"})
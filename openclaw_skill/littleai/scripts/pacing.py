@@ -0,0 +1,29 @@
+"""Speech pacing shared by the helper scripts.
+
+The device acks a speech chunk as soon as it is queued, with "queued_ms" = audio buffered
+ahead of playout. Hosts sleep on each ack so they stay at most MAX_LEAD_MS ahead: the mouth
+animation they send then stays roughly in sync with what is audible, and a cancel
+(audio_flush) cuts off at most that much audio.
+"""
+
+import asyncio
+import json
+
+MAX_LEAD_MS = 400
+
+
+def lead_delay_s(queued_ms: float, max_lead_ms: float = MAX_LEAD_MS) -> float:
+    """Seconds to wait before sending the next chunk."""
+    return max(0.0, (queued_ms - max_lead_ms) / 1000.0)
+
+
+async def pace(rep) -> None:
+    """Sleep according to a chunk ack, given as the raw reply text or a parsed dict."""
+    if isinstance(rep, (str, bytes)):
+        try:
+            rep = json.loads(rep)
+        except ValueError:
+            return
+    delay = lead_delay_s(rep.get("queued_ms", 0) if isinstance(rep, dict) else 0)
+    if delay:
+        await asyncio.sleep(delay)
@@ -1,20 +1,26 @@
 #!/usr/bin/env python3
-"""Generate TTS on macOS using `say` and stream PCM chunks to littleAI over WebSocket.
+"""Generate TTS on macOS using `say` and stream speech chunks to littleAI over WebSocket.
 
 Usage:
   python3 {baseDir}/scripts/speak_ws.py --ip DEVICE_IP --text "Hello Dave"
 
 Notes:
 - WS: ws://<ip>:8080/ws
-- Command: {"type":"speak_pcm","data_b64":"..."}
-- Audio format: PCM16 little-endian, mono, 16000 Hz.
+- Default transport: binary WS frames, 16-byte header + encoded speech (see references/ws-api.md).
+- Fallback (--transport json): {"type":"speak","codec":"adpcm","data_b64":"..."}
+- Default codec: IMA-ADPCM (64 kbit/s instead of 256 for PCM16). --codec opus needs `pip install opuslib`
+  and a device built with CONFIG_LITTLEAI_AUDIO_OPUS; --codec pcm16 sends raw samples.
+- Source audio: PCM16 little-endian, mono, 16000 Hz.
 - Animates mouth openness from RMS by default. Use --no-face to disable.
 """
 
 import argparse
 import asyncio
 import base64
+import json
 import os
+import random
+import struct
 import subprocess
 import tempfile
 import wave
@@ -22,8 +28,144 @@ import array
 
 import websockets
 
+from pacing import pace
+
 SAMPLE_RATE = 16000
 CHUNK_SAMPLES = 800  # 50ms @ 16kHz
+# Per codec: chunk on whole decode units (two ADPCM blocks, three 20ms Opus frames).
+CODEC_CHUNK_SAMPLES = {"pcm16": CHUNK_SAMPLES, "adpcm": 1010, "opus": 960}
+
+# Binary speech frame header (little-endian):
+#   magic, hdr_len, codec, flags, stream_id, reserved, seq, ts_ms
+SPEAK_FRAME_MAGIC = 0x53
+SPEAK_HDR = struct.Struct("<BBBBHHII")
+CODECS = {"pcm16": 0, "adpcm": 1, "opus": 2}
+FLAG_END = 0x01
+
+
+def speak_frame(stream_id: int, seq: int, ts_ms: int, payload: bytes, end: bool = False,
+                codec: str = "pcm16") -> bytes:
+    flags = FLAG_END if end else 0
+    return SPEAK_HDR.pack(SPEAK_FRAME_MAGIC, SPEAK_HDR.size, CODECS[codec], flags, stream_id, 0, seq, ts_ms) + payload
+
+
+def speak_json(stream_id: int, seq: int, ts_ms: int, payload: bytes, end: bool = False,
+               codec: str = "pcm16") -> str:
+    return json.dumps({
+        "type": "speak",
+        "codec": codec,
+        "stream": stream_id,
+        "seq": seq,
+        "ts_ms": ts_ms,
+        "end": end,
+        "data_b64": base64.b64encode(payload).decode("ascii"),
+    })
+
+
+# IMA-ADPCM, same block layout the device decodes (include/audio_codec.h):
+#   int16 first sample, u8 step index, u8 reserved, then 4-bit codes (low nibble first).
+IMA_BLOCK_SAMPLES = 505  # 256-byte blocks
+IMA_STEP = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+]
+IMA_INDEX = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+OPUS_FRAME_SAMPLES = 320  # 20ms @ 16kHz
+
+
+class AdpcmEncoder:
+    # Blocks are self-contained on the device side; only the step index carries over.
+    def __init__(self):
+        self.index = 0
+
+    def encode_block(self, samples) -> bytes:
+        if len(samples) % 2 == 0:
+            samples = list(samples) + [samples[-1]]  # 1 + 2*N samples per block
+        pred = samples[0]
+        index = self.index
+        out = bytearray(struct.pack("<hBB", pred, index, 0))
+        for i in range(1, len(samples), 2):
+            byte = 0
+            for shift, s in ((0, samples[i]), (4, samples[i + 1])):
+                step = IMA_STEP[index]
+                diff = s - pred
+                code = 0
+                if diff < 0:
+                    code = 8
+                    diff = -diff
+                if diff >= step:
+                    code |= 4
+                    diff -= step
+                if diff >= step >> 1:
+                    code |= 2
+                    diff -= step >> 1
+                if diff >= step >> 2:
+                    code |= 1
+                # Track the decoder's reconstruction, not the input, so errors don't accumulate.
+                delta = step >> 3
+                if code & 4:
+                    delta += step
+                if code & 2:
+                    delta += step >> 1
+                if code & 1:
+                    delta += step >> 2
+                pred = pred - delta if code & 8 else pred + delta
+                pred = max(-32768, min(32767, pred))
+                index = max(0, min(88, index + IMA_INDEX[code & 7]))
+                byte |= code << shift
+            out.append(byte)
+        self.index = index
+        return bytes(out)
+
+    def encode(self, pcm: bytes) -> bytes:
+        a = array.array('h')
+        a.frombytes(pcm)
+        return b"".join(self.encode_block(a[i:i + IMA_BLOCK_SAMPLES]) for i in range(0, len(a), IMA_BLOCK_SAMPLES))
+
+
+class OpusEncoder:
+    # Needs `pip install opuslib` (and libopus); the device needs CONFIG_LITTLEAI_AUDIO_OPUS.
+    def __init__(self, bitrate: int):
+        import opuslib
+        self.enc = opuslib.Encoder(SAMPLE_RATE, 1, opuslib.APPLICATION_VOIP)
+        self.enc.bitrate = bitrate
+
+    def encode(self, pcm: bytes) -> bytes:
+        frame_bytes = OPUS_FRAME_SAMPLES * 2
+        if len(pcm) % frame_bytes:
+            pcm += b"\x00" * (frame_bytes - len(pcm) % frame_bytes)
+        out = bytearray()
+        for i in range(0, len(pcm), frame_bytes):
+            pkt = self.enc.encode(pcm[i:i + frame_bytes], OPUS_FRAME_SAMPLES)
+            out += struct.pack("<H", len(pkt)) + pkt
+        return bytes(out)
+
+
+class Pcm16Encoder:
+    def encode(self, pcm: bytes) -> bytes:
+        return pcm
+
+
+def make_encoder(codec: str, bitrate: int):
+    if codec == "adpcm":
+        return AdpcmEncoder()
+    if codec == "opus":
+        return OpusEncoder(bitrate)
+    return Pcm16Encoder()
+
+
+async def recv_speak_ack(ws) -> str:
+    # Skip replies to fire-and-forget commands (only sent when one of them failed).
+    while True:
+        rep = await ws.recv()
+        if '"cmd":"speak' in rep:
+            return rep
+        print(rep)
 
 
 def rms_open(frames: bytes, prev: float) -> float:
@@ -57,7 +199,8 @@ def gen_wav_say(text: str, out_wav: str) -> None:
     subprocess.check_call(cmd)
 
 
-async def stream_wav(ip: str, wav_path: str, drive_face: bool = True) -> None:
+async def stream_wav(ip: str, wav_path: str, drive_face: bool = True, transport: str = "binary",
+                     codec: str = "pcm16", bitrate: int = 16000) -> None:
     uri = f"ws://{ip}:8080/ws"
     async with websockets.connect(uri, max_size=2**20) as ws:
         if drive_face:
@@ -65,27 +208,41 @@ async def stream_wav(ip: str, wav_path: str, drive_face: bool = True) -> None:
             await ws.recv()
 
         mouth_prev = 0.0
+        stream_id = random.randrange(1, 0x10000)
+        seq = 0
+        sent_samples = 0
+        encoder = make_encoder(codec, bitrate)
+        chunk_samples = CODEC_CHUNK_SAMPLES[codec]
 
         with wave.open(wav_path, "rb") as w:
             assert w.getnchannels() == 1
             assert w.getsampwidth() == 2
             assert w.getframerate() == SAMPLE_RATE
 
-            while True:
-                frames = w.readframes(CHUNK_SAMPLES)
-                if not frames:
-                    break
+            # Read one chunk ahead so the last chunk can carry the end-of-stream flag.
+            frames = w.readframes(chunk_samples)
+            while frames:
+                nxt = w.readframes(chunk_samples)
+                end = not nxt
+                ts_ms = (sent_samples * 1000) // SAMPLE_RATE
+                payload = encoder.encode(frames)
 
                 if drive_face:
                     mouth_prev = rms_open(frames, mouth_prev)
-                    await ws.send('{"type":"mouth","open":' + f"{mouth_prev:.3f}" + '}')
-                    await ws.recv()
+                    # Fire-and-forget: no ack round trip per mouth update.
+                    await ws.send('{"type":"mouth","open":' + f"{mouth_prev:.3f}" + ',"ack":false}')
 
-                b64 = base64.b64encode(frames).decode("ascii")
-                await ws.send('{"type":"speak_pcm","data_b64":"' + b64 + '"}')
-                rep = await ws.recv()
+                if transport == "binary":
+                    await ws.send(speak_frame(stream_id, seq, ts_ms, payload, end, codec))
+                else:
+                    await ws.send(speak_json(stream_id, seq, ts_ms, payload, end, codec))
+                seq += 1
+                sent_samples += len(frames) // 2
+                frames = nxt
+                rep = await recv_speak_ack(ws)
                 if '"ok":true' not in rep:
                     print(rep)
+                await pace(rep)
 
         if drive_face:
             await ws.send('{"type":"mouth","open":0.00}')
@@ -102,12 +259,18 @@ def main():
     ap.add_argument("--ip", required=True)
     ap.add_argument("--text", required=True)
     ap.add_argument("--no-face", action="store_true")
+    ap.add_argument("--transport", choices=["binary", "json"], default="binary",
+                    help="binary WS frames (default) or base64 JSON speak messages")
+    ap.add_argument("--codec", choices=list(CODECS), default="adpcm",
+                    help="adpcm (default, 4:1), opus (needs opuslib + device Opus build) or raw pcm16")
+    ap.add_argument("--bitrate", type=int, default=16000, help="Opus bitrate in bit/s")
     args = ap.parse_args()
 
     with tempfile.TemporaryDirectory() as td:
         wav_path = os.path.join(td, "tts.wav")
         gen_wav_say(args.text, wav_path)
-        asyncio.run(stream_wav(args.ip, wav_path, drive_face=(not args.no_face)))
+        asyncio.run(stream_wav(args.ip, wav_path, drive_face=(not args.no_face), transport=args.transport,
+                                codec=args.codec, bitrate=args.bitrate))
 
 
 if __name__ == "__main__":
@@ -0,0 +1,93 @@
+#include "assets.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_partition.h"
+
+static const char *TAG = "assets";
+
+#define ASSETS_PARTITION_LABEL "assets"
+
+static const uint8_t *s_pack = NULL;
+static const asset_entry_t *s_index = NULL;
+static int s_count = 0;
+
+const char *asset_type_name(asset_type_t type)
+{
+    switch (type) {
+        case ASSET_FONT: return "font";
+        case ASSET_IMAGE: return "image";
+        case ASSET_CLIP: return "clip";
+        default: return "unknown";
+    }
+}
+
+esp_err_t assets_mount(void)
+{
+    if (s_pack) return ESP_OK;
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                           ASSETS_PARTITION_LABEL);
+    if (!part) return ESP_ERR_NOT_FOUND;
+
+    asset_pack_hdr_t hdr;
+    ESP_RETURN_ON_ERROR(esp_partition_read(part, 0, &hdr, sizeof(hdr)), TAG, "read header");
+    if (hdr.magic != ASSET_PACK_MAGIC || hdr.version != ASSET_PACK_VERSION) return ESP_ERR_INVALID_VERSION;
+    const size_t index_end = sizeof(hdr) + (size_t)hdr.count * sizeof(asset_entry_t);
+    if (hdr.total_size > part->size || hdr.total_size < index_end) return ESP_ERR_INVALID_SIZE;
+
+    // One mapping for the whole pack; the MMU keeps it for the life of the app.
+    const void *base = NULL;
+    esp_partition_mmap_handle_t handle;
+    ESP_RETURN_ON_ERROR(esp_partition_mmap(part, 0, hdr.total_size, ESP_PARTITION_MMAP_DATA, &base, &handle),
+                        TAG, "mmap %u bytes", (unsigned)hdr.total_size);
+
+    const asset_entry_t *index = (const asset_entry_t *)((const uint8_t *)base + sizeof(hdr));
+    for (int i = 0; i < hdr.count; i++) {
+        const asset_entry_t *e = &index[i];
+        if (e->name[ASSET_NAME_LEN - 1] != 0 || e->offset < index_end || e->offset > hdr.total_size ||
+            e->size > hdr.total_size - e->offset) {
+            ESP_LOGE(TAG, "entry %d is corrupt", i);
+            esp_partition_munmap(handle);
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+
+    s_pack = (const uint8_t *)base;
+    s_index = index;
+    s_count = hdr.count;
+    ESP_LOGI(TAG, "%d assets, %u bytes mapped", s_count, (unsigned)hdr.total_size);
+    return ESP_OK;
+}
+
+int assets_count(void)
+{
+    return s_count;
+}
+
+bool assets_get(int index, asset_t *out)
+{
+    if (index < 0 || index >= s_count || !out) return false;
+    const asset_entry_t *e = &s_index[index];
+    out->name = e->name;
+    out->type = (asset_type_t)e->type;
+    out->codec = e->codec;
+    out->param = e->param;
+    out->data = s_pack + e->offset;
+    out->size = e->size;
+    return true;
+}
+
+bool assets_find(const char *name, asset_type_t type, asset_t *out)
+{
+    if (!name) return false;
+    for (int i = 0; i < s_count; i++) {
+        const asset_entry_t *e = &s_index[i];
+        if ((type == ASSET_ANY || e->type == type) && strncmp(e->name, name, ASSET_NAME_LEN) == 0) {
+            return assets_get(i, out);
+        }
+    }
+    return false;
+}
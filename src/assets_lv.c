@@ -0,0 +1,100 @@
+#include "assets_lv.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "assets.h"
+
+// One drive per asset type, so a lookup only matches what LVGL is about to parse.
+#define ASSETS_LV_FONT_LETTER 'F'
+#define ASSETS_LV_IMG_LETTER 'I'
+
+typedef struct {
+    const uint8_t *data;
+    uint32_t size;
+    uint32_t pos;
+} asset_file_t;
+
+static lv_fs_drv_t s_font_drv;
+static lv_fs_drv_t s_img_drv;
+
+static void *fs_open(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode)
+{
+    asset_t a;
+    const asset_type_t type = (asset_type_t)(uintptr_t)drv->user_data;
+    if ((mode & LV_FS_MODE_WR) || !assets_find(path, type, &a)) return NULL;
+    asset_file_t *f = malloc(sizeof(*f));
+    if (!f) return NULL;
+    f->data = a.data;
+    f->size = a.size;
+    f->pos = 0;
+    return f;
+}
+
+static lv_fs_res_t fs_close(lv_fs_drv_t *drv, void *file)
+{
+    (void)drv;
+    free(file);
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_read(lv_fs_drv_t *drv, void *file, void *buf, uint32_t btr, uint32_t *br)
+{
+    (void)drv;
+    asset_file_t *f = file;
+    uint32_t n = f->size - f->pos;
+    if (n > btr) n = btr;
+    memcpy(buf, f->data + f->pos, n);
+    f->pos += n;
+    *br = n;
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_seek(lv_fs_drv_t *drv, void *file, uint32_t pos, lv_fs_whence_t whence)
+{
+    (void)drv;
+    asset_file_t *f = file;
+    int64_t p = pos;
+    if (whence == LV_FS_SEEK_CUR) p += f->pos;
+    else if (whence == LV_FS_SEEK_END) p += f->size;
+    if (p > f->size) return LV_FS_RES_INV_PARAM;
+    f->pos = (uint32_t)p;
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_tell(lv_fs_drv_t *drv, void *file, uint32_t *pos)
+{
+    (void)drv;
+    *pos = ((asset_file_t *)file)->pos;
+    return LV_FS_RES_OK;
+}
+
+static void register_drive(lv_fs_drv_t *drv, char letter, asset_type_t type)
+{
+    lv_fs_drv_init(drv);
+    drv->letter = letter;
+    drv->user_data = (void *)(uintptr_t)type;
+    drv->open_cb = fs_open;
+    drv->close_cb = fs_close;
+    drv->read_cb = fs_read;
+    drv->seek_cb = fs_seek;
+    drv->tell_cb = fs_tell;
+    lv_fs_drv_register(drv);
+}
+
+void assets_lv_init(void)
+{
+    register_drive(&s_font_drv, ASSETS_LV_FONT_LETTER, ASSET_FONT);
+    register_drive(&s_img_drv, ASSETS_LV_IMG_LETTER, ASSET_IMAGE);
+}
+
+lv_font_t *assets_lv_font(const char *name)
+{
+    asset_t a;
+    if (!assets_find(name, ASSET_FONT, &a)) return NULL;
+    char path[ASSET_NAME_LEN + 2];
+    snprintf(path, sizeof(path), "%c:%s", ASSETS_LV_FONT_LETTER, name);
+    return lv_font_load(path);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LVGL access to the mapped asset pack (see assets.h). Call with the LVGL lock held.
+
+// Register drive letters 'F' (fonts) and 'I' (images) so LVGL can open assets by name:
+// lv_img_set_src(img, "I:logo"). Each drive only finds assets of its own type.
+void assets_lv_init(void);
+
+// Load a font asset through LVGL's binary font loader (the glyph tables are copied into the
+// LVGL heap). NULL if the pack has no such font.
+lv_font_t *assets_lv_font(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,13 +1,21 @@
 #include "audio.h"
+#include "audio_codec.h"
+#include "audio_resample.h"
+#include "perf.h"
 
 #include <string.h>
 #include <math.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include "freertos/semphr.h"
 
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
 
 #include "driver/gpio.h"
 #include "driver/i2c.h"
@@ -16,12 +24,722 @@
 #include "es8311.h"
 
 #include "pin_config.h"
+#include "i2c_bus.h"
 
 static const char *TAG = "audio";
 
 static i2s_chan_handle_t s_tx = NULL;
 static es8311_handle_t s_es = NULL;
 static int s_sample_rate = 16000;
+static int s_volume = 75;
+
+// Playback queue: speech chunks (PCM or compressed) go into a PSRAM ring buffer and a pinned writer task drains
+// them into I2S, so callers (the WS server) never block on i2s_channel_write.
+//
+// On top of the queue sits a small jitter buffer: timed streams (chunks carrying seq + ts_ms)
+// buffer target_ms before playout starts, are scheduled against their timestamp (late chunks
+// are dropped, gaps are filled with silence) and underruns fade to silence instead of clicking.
+// Compressed chunks stay compressed in the ring and are decoded by the writer right before I2S.
+#define AUDIO_QUEUE_BYTES (256 * 1024)
+#define AUDIO_BLOCK_SAMPLES 256
+#if CONFIG_LITTLEAI_AUDIO_OPUS
+#define AUDIO_TASK_STACK (24 * 1024) // the Opus decoder keeps its scratch on the stack
+#else
+#define AUDIO_TASK_STACK 4096
+#endif
+#ifndef CONFIG_LITTLEAI_AUDIO_TASK_PRIORITY
+#define CONFIG_LITTLEAI_AUDIO_TASK_PRIORITY 6
+#endif
+#ifndef CONFIG_LITTLEAI_AUDIO_TASK_CORE
+#define CONFIG_LITTLEAI_AUDIO_TASK_CORE 1
+#endif
+#define AUDIO_TASK_PRIORITY CONFIG_LITTLEAI_AUDIO_TASK_PRIORITY
+#define AUDIO_TASK_CORE (CONFIG_LITTLEAI_AUDIO_TASK_CORE < 0 ? tskNO_AFFINITY : CONFIG_LITTLEAI_AUDIO_TASK_CORE)
+// Untimed (legacy) chunks: a gap shorter than this between two chunks counts as an underrun;
+// a longer silence is treated as the end of one utterance and the start of the next.
+#define AUDIO_UNDERRUN_GAP_MS 1000
+// Short ramp applied when audio resumes after concealment.
+#define AUDIO_FADE_IN_SAMPLES 32
+// Timed chunks starting this close to where the previous one ended are treated as contiguous:
+// ts_ms has 1 ms resolution and resampled chunks can come out a sample long or short.
+#define AUDIO_SYNC_SLACK_MS 1
+// Mono slot mode: the I2S peripheral sends each sample on both slots, so DMA carries 2 bytes
+// per frame and speech goes to the driver without a copy. Stereo: L+R built in software.
+#define AUDIO_OUT_CHANNELS (CONFIG_LITTLEAI_AUDIO_I2S_MONO ? 1 : 2)
+
+// Mixer (see audio_voice_t): gains are Q15 with 1 << 15 = unity.
+#define MIX_Q15_ONE (1 << 15)
+#define TONE_TABLE_BITS 8
+#define TONE_TABLE_LEN (1 << TONE_TABLE_BITS)
+#define TONE_AMPLITUDE 8191       // -12 dBFS at unity gain; keep it gentle
+#define TONE_RAMP_SAMPLES 64      // attack/release so tones start and stop without a click
+
+#ifndef CONFIG_LITTLEAI_AUDIO_JITTER_TARGET_MS
+#define CONFIG_LITTLEAI_AUDIO_JITTER_TARGET_MS 120
+#endif
+#ifndef CONFIG_LITTLEAI_AUDIO_CONCEAL_FADE_MS
+#define CONFIG_LITTLEAI_AUDIO_CONCEAL_FADE_MS 8
+#endif
+#ifndef CONFIG_LITTLEAI_AUDIO_STREAM_HOLD_MS
+#define CONFIG_LITTLEAI_AUDIO_STREAM_HOLD_MS 600
+#endif
+#ifndef CONFIG_LITTLEAI_AUDIO_I2S_MONO
+#define CONFIG_LITTLEAI_AUDIO_I2S_MONO 0
+#endif
+#ifndef CONFIG_LITTLEAI_LIPSYNC
+#define CONFIG_LITTLEAI_LIPSYNC 0
+#endif
+#ifndef CONFIG_LITTLEAI_LIPSYNC_ATTACK_MS
+#define CONFIG_LITTLEAI_LIPSYNC_ATTACK_MS 15
+#endif
+#ifndef CONFIG_LITTLEAI_LIPSYNC_RELEASE_MS
+#define CONFIG_LITTLEAI_LIPSYNC_RELEASE_MS 90
+#endif
+
+// Ring buffer item: header followed by `bytes` of payload in `codec` format.
+typedef struct {
+    uint32_t seq;
+    uint32_t ts_ms;
+    uint16_t stream_id;
+    uint16_t flags;    // AUDIO_CHUNK_F_*
+    uint32_t samples;  // decoded length at the output rate
+    uint32_t bytes;
+    uint8_t codec;     // audio_codec_t
+    uint8_t reserved;
+    uint16_t rate_hz;  // payload sample rate when it needs resampling, else 0
+} audio_rec_t;
+
+static RingbufHandle_t s_queue = NULL;
+static size_t s_queue_bytes = 0;
+static TaskHandle_t s_writer_task = NULL;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_queued_samples = 0;
+static uint32_t s_end_marks = 0; // END chunks currently queued
+static volatile uint32_t s_flush_gen = 0;
+
+static uint32_t s_underruns = 0;
+static uint32_t s_late_chunks = 0;
+static uint32_t s_dropped_chunks = 0;
+static uint32_t s_concealed_samples = 0;
+
+static audio_jitter_config_t s_jcfg = {
+    .target_ms = CONFIG_LITTLEAI_AUDIO_JITTER_TARGET_MS,
+    .fade_ms = CONFIG_LITTLEAI_AUDIO_CONCEAL_FADE_MS,
+    .hold_ms = CONFIG_LITTLEAI_AUDIO_STREAM_HOLD_MS,
+};
+
+// Lip sync: the writer feeds an envelope follower with every block it sends to I2S and
+// stamps the result with the time the block will be heard (write return + DMA queue depth),
+// so the mouth follows the speaker rather than packet arrival.
+#define LIPSYNC_POINTS 16                // 16 blocks of 256 samples: more than the DMA queue holds
+#define LIPSYNC_HOLD_US (120 * 1000)     // stay live this long after the last block is heard
+#define LIPSYNC_FLOOR_RMS 200.0f         // background noise: mouth stays closed
+#define LIPSYNC_FULL_SCALE 7000          // same mapping tools/speak_ws.py used host-side
+
+typedef struct {
+    int64_t play_us;
+    float level;
+} lipsync_point_t;
+
+static audio_lipsync_config_t s_lcfg = {
+    .enabled = CONFIG_LITTLEAI_LIPSYNC,
+    .attack_ms = CONFIG_LITTLEAI_LIPSYNC_ATTACK_MS,
+    .release_ms = CONFIG_LITTLEAI_LIPSYNC_RELEASE_MS,
+    .full_scale = LIPSYNC_FULL_SCALE,
+};
+static portMUX_TYPE s_lip_lock = portMUX_INITIALIZER_UNLOCKED;
+static lipsync_point_t s_lip[LIPSYNC_POINTS];
+static uint32_t s_lip_count = 0;  // points pushed so far (ring index = count % LIPSYNC_POINTS)
+static float s_lip_env = 0.0f;    // writer task only
+static int64_t s_dma_latency_us = 0;
+static void (*s_on_lipsync_start)(void) = NULL;
+
+// Clip/tone requests from API callers; the writer picks up a new `seq` at its next block.
+// Zero length = stop.
+typedef struct {
+    uint32_t seq;
+    const uint8_t *data;
+    size_t len;
+    audio_codec_t codec;
+} clip_req_t;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t phase_inc; // Q32 cycles per sample
+    uint32_t samples;
+} tone_req_t;
+
+static portMUX_TYPE s_mix_lock = portMUX_INITIALIZER_UNLOCKED;
+static clip_req_t s_clip_req;
+static tone_req_t s_tone_req;
+static volatile int32_t s_gain[AUDIO_VOICE_COUNT] = {MIX_Q15_ONE, MIX_Q15_ONE, MIX_Q15_ONE};
+static int16_t s_tone_table[TONE_TABLE_LEN]; // one sine period, built once
+
+// Writer-task view of the clip and tone voices.
+typedef struct {
+    uint32_t clip_seq;
+    bool clip_on;
+    audio_codec_cursor_t clip;  // payload not yet rendered
+    const int16_t *clip_src;    // rendered samples ready to mix (flash for PCM16, s_clip_dec for ADPCM)
+    size_t clip_avail;
+
+    uint32_t tone_seq;
+    bool tone_on;
+    uint32_t phase;
+    uint32_t phase_inc;
+    uint32_t tone_pos;
+    uint32_t tone_len;
+} mixer_t;
+
+static mixer_t s_mix;
+static int32_t s_mix_acc[AUDIO_BLOCK_SAMPLES];
+static int16_t s_mix_out[AUDIO_BLOCK_SAMPLES * AUDIO_OUT_CHANNELS];
+static int16_t s_clip_dec[IMA_ADPCM_BLOCK_SAMPLES];
+
+// Enqueue-side duplicate / reorder detection (caller side, guarded by s_in_mux).
+static SemaphoreHandle_t s_in_mux = NULL;
+static bool s_in_valid = false;
+static uint16_t s_in_stream = 0;
+static uint32_t s_in_seq = 0;
+static uint64_t s_in_part_samples = 0; // payload samples of s_in_seq passed in so far (AUDIO_CHUNK_F_CONT)
+// A chunk the queue had no room for is accepted again when the host resends it; the records of
+// it that did make it into the ring (payload samples [0, s_in_queued_samples)) are not queued twice.
+static bool s_in_retry = false;
+static uint64_t s_in_queued_samples = 0;
+
+static void queued_sub(size_t n)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    s_queued_samples = (n > s_queued_samples) ? 0 : (s_queued_samples - (uint32_t)n);
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+static void stat_add(uint32_t *counter, uint32_t n)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    *counter += n;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+// Release a record: drop its samples from the fill level and its END mark, if any.
+static void rec_release(audio_rec_t *rec, size_t unplayed)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    s_queued_samples = (unplayed > s_queued_samples) ? 0 : (s_queued_samples - (uint32_t)unplayed);
+    if ((rec->flags & AUDIO_CHUNK_F_END) && s_end_marks) s_end_marks--;
+    portEXIT_CRITICAL(&s_stats_lock);
+    vRingbufferReturnItem(s_queue, rec);
+}
+
+static uint32_t queued_ms(void)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    const uint32_t q = s_queued_samples;
+    portEXIT_CRITICAL(&s_stats_lock);
+    return (uint32_t)(((uint64_t)q * 1000) / (uint32_t)s_sample_rate);
+}
+
+static uint64_t ms_to_samples(uint32_t ms)
+{
+    return ((uint64_t)ms * (uint32_t)s_sample_rate) / 1000;
+}
+
+// Feed one block that was just written to I2S (NULL = silence). Writer task only.
+static void lipsync_feed(const int16_t *samples, size_t n)
+{
+    if (!s_lcfg.enabled || n == 0) return;
+
+    const int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lip_lock);
+    const bool start = s_lip_count == 0 ||
+                       now > s_lip[(s_lip_count - 1) % LIPSYNC_POINTS].play_us + LIPSYNC_HOLD_US;
+    portEXIT_CRITICAL(&s_lip_lock);
+    if (start) s_lip_env = 0.0f;
+
+    float rms = 0.0f;
+    if (samples) {
+        int64_t acc = 0;
+        for (size_t i = 0; i < n; i++) acc += (int32_t)samples[i] * samples[i];
+        rms = sqrtf((float)acc / (float)n);
+    }
+    float target = (rms - LIPSYNC_FLOOR_RMS) / ((float)s_lcfg.full_scale - LIPSYNC_FLOOR_RMS);
+    if (target < 0.0f) target = 0.0f;
+    if (target > 1.0f) target = 1.0f;
+
+    const float dt_ms = (float)n * 1000.0f / (float)s_sample_rate;
+    const float tau = (float)(target > s_lip_env ? s_lcfg.attack_ms : s_lcfg.release_ms);
+    s_lip_env += (target - s_lip_env) * (tau > 0.0f ? 1.0f - expf(-dt_ms / tau) : 1.0f);
+
+    // The block just queued sits behind a full DMA queue; stamp its middle.
+    const lipsync_point_t pt = {
+        .play_us = now + s_dma_latency_us - (int64_t)n * 500000 / s_sample_rate,
+        .level = s_lip_env,
+    };
+    portENTER_CRITICAL(&s_lip_lock);
+    s_lip[s_lip_count % LIPSYNC_POINTS] = pt;
+    s_lip_count++;
+    portEXIT_CRITICAL(&s_lip_lock);
+
+    if (start && s_on_lipsync_start) s_on_lipsync_start();
+}
+
+// Pick up clip/tone requests made since the last block. Writer task only.
+static void mixer_sync(void)
+{
+    portENTER_CRITICAL(&s_mix_lock);
+    if (s_clip_req.seq != s_mix.clip_seq) {
+        s_mix.clip_seq = s_clip_req.seq;
+        s_mix.clip = (audio_codec_cursor_t){.codec = s_clip_req.codec, .p = s_clip_req.data, .left = s_clip_req.len};
+        s_mix.clip_avail = 0;
+        s_mix.clip_on = s_clip_req.len > 0;
+    }
+    if (s_tone_req.seq != s_mix.tone_seq) {
+        s_mix.tone_seq = s_tone_req.seq;
+        s_mix.phase = 0;
+        s_mix.phase_inc = s_tone_req.phase_inc;
+        s_mix.tone_pos = 0;
+        s_mix.tone_len = s_tone_req.samples;
+        s_mix.tone_on = s_tone_req.samples > 0;
+    }
+    portEXIT_CRITICAL(&s_mix_lock);
+}
+
+// Clip or tone voice still has something to play.
+static bool mixer_busy(void)
+{
+    mixer_sync();
+    return s_mix.clip_on || s_mix.tone_on;
+}
+
+// ADPCM clips decode into s_clip_dec: only the writer's mixer may play them.
+static bool clip_refill(mixer_t *m)
+{
+    audio_codec_cursor_t *c = &m->clip;
+    if (c->left == 0) return false;
+    if (c->codec == AUDIO_CODEC_PCM16) {
+        // Mixed straight from where the clip lives.
+        m->clip_src = (const int16_t *)c->p;
+        m->clip_avail = c->left / sizeof(int16_t);
+        c->left = 0;
+    } else {
+        const size_t n = c->left > IMA_ADPCM_BLOCK_BYTES ? IMA_ADPCM_BLOCK_BYTES : c->left;
+        m->clip_src = s_clip_dec;
+        m->clip_avail = ima_adpcm_decode_block(c->p, n, s_clip_dec);
+        c->p += n;
+        c->left -= n;
+    }
+    return m->clip_avail > 0;
+}
+
+static void mix_clip(mixer_t *m, int32_t *acc, size_t n)
+{
+    const int32_t g = s_gain[AUDIO_VOICE_CLIP];
+    size_t i = 0;
+    while (i < n) {
+        if (m->clip_avail == 0 && !clip_refill(m)) {
+            m->clip_on = false;
+            return;
+        }
+        const size_t k = (n - i) < m->clip_avail ? (n - i) : m->clip_avail;
+        const int16_t *src = m->clip_src;
+        for (size_t j = 0; j < k; j++) acc[i + j] += (src[j] * g) >> 15;
+        m->clip_src += k;
+        m->clip_avail -= k;
+        i += k;
+    }
+}
+
+// Phase-accumulator oscillator over s_tone_table with linear interpolation.
+static void mix_tone(mixer_t *m, int32_t *acc, size_t n)
+{
+    const int32_t g = s_gain[AUDIO_VOICE_TONE];
+    uint32_t phase = m->phase;
+    const uint32_t inc = m->phase_inc;
+    for (size_t i = 0; i < n && m->tone_pos < m->tone_len; i++, m->tone_pos++) {
+        const uint32_t idx = phase >> (32 - TONE_TABLE_BITS);
+        const int32_t frac = (int32_t)((phase >> (16 - TONE_TABLE_BITS)) & 0xFFFF);
+        const int32_t a = s_tone_table[idx];
+        const int32_t b = s_tone_table[(idx + 1) & (TONE_TABLE_LEN - 1)];
+        int32_t s = a + (((b - a) * frac) >> 16);
+
+        const uint32_t left = m->tone_len - m->tone_pos;
+        const uint32_t edge = m->tone_pos < left ? m->tone_pos : left;
+        if (edge < TONE_RAMP_SAMPLES) s = (s * (int32_t)edge) / TONE_RAMP_SAMPLES;
+
+        acc[i] += (s * g) >> 15;
+        phase += inc;
+    }
+    m->phase = phase;
+    if (m->tone_pos >= m->tone_len) m->tone_on = false;
+}
+
+static inline int16_t sat16(int32_t v)
+{
+    // MIN/MAX on the LX7: branch-free.
+    return (int16_t)(v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v));
+}
+
+// Output frames from mono speech scaled by `gain` (Q15); `channels` 2 duplicates into L+R.
+static inline void frames_from_pcm(int16_t *dst, const int16_t *src, size_t n, int32_t gain, int channels)
+{
+    for (size_t i = 0; i < n; i++) {
+        const int16_t s = src ? (int16_t)((src[i] * gain) >> 15) : 0;
+        dst[i * channels] = s;
+        if (channels == 2) dst[i * 2 + 1] = s;
+    }
+}
+
+// Output frames from a mix accumulator, saturated to int16.
+static inline void frames_from_acc(int16_t *dst, const int32_t *acc, size_t n, int channels)
+{
+    for (size_t i = 0; i < n; i++) {
+        const int16_t s = sat16(acc[i]);
+        dst[i * channels] = s;
+        if (channels == 2) dst[i * 2 + 1] = s;
+    }
+}
+
+// Sum speech (NULL = silence, scaled by `gain`) and the clip/tone voices of `m` into acc[n].
+static void mix_voices(mixer_t *m, int32_t *acc, const int16_t *speech, size_t n, int32_t gain)
+{
+    if (speech) {
+        for (size_t i = 0; i < n; i++) acc[i] = (speech[i] * gain) >> 15;
+    } else {
+        memset(acc, 0, n * sizeof(acc[0]));
+    }
+    if (m->clip_on) mix_clip(m, acc, n);
+    if (m->tone_on) mix_tone(m, acc, n);
+}
+
+// Mix `n` speech samples (NULL = silence) with the clip and tone voices and write the result
+// to I2S as AUDIO_OUT_CHANNELS-channel frames. Writer task only.
+static esp_err_t mix_write(const int16_t *speech, size_t n)
+{
+    const int16_t *out = s_mix_out;
+    const int32_t gs = s_gain[AUDIO_VOICE_SPEECH];
+
+    if (mixer_busy()) {
+        mix_voices(&s_mix, s_mix_acc, speech, n, gs);
+        frames_from_acc(s_mix_out, s_mix_acc, n, AUDIO_OUT_CHANNELS);
+    } else if (AUDIO_OUT_CHANNELS == 1 && speech && gs == MIX_Q15_ONE) {
+        out = speech; // speech alone at unity: hand the ring's samples to the driver as they are
+    } else {
+        frames_from_pcm(s_mix_out, speech, n, gs, AUDIO_OUT_CHANNELS);
+    }
+
+    size_t bytes_written = 0;
+    const int64_t t0 = esp_timer_get_time();
+    esp_err_t err = i2s_channel_write(s_tx, out, n * AUDIO_OUT_CHANNELS * sizeof(int16_t), &bytes_written,
+                                      portMAX_DELAY);
+    perf_record_since(PERF_AUDIO_WRITE, t0);
+    return err;
+}
+
+// Writer-task playout state for the stream currently on the speaker.
+typedef struct {
+    bool active;
+    bool timed;
+    bool starved;
+    uint16_t stream_id;
+    uint64_t cursor;         // stream position (samples) of the next sample sent to I2S
+    uint64_t starved_at;     // cursor when the current starvation episode began
+    int64_t untimed_end_us;  // when the last untimed stream ran dry
+    int16_t last;            // last sample written (fade-out starting point)
+    int fade_in;             // samples of fade-in still to apply
+    uint32_t gen;
+} playout_t;
+
+// Write `n` samples of concealment: a linear fade from the last output sample to zero,
+// then silence. Used for underruns and for timestamp gaps (lost chunks).
+static void write_concealment(playout_t *p, size_t n)
+{
+    int16_t block[AUDIO_BLOCK_SAMPLES];
+    const int fade_len = (int)ms_to_samples(s_jcfg.fade_ms);
+
+    while (n > 0) {
+        size_t k = n > AUDIO_BLOCK_SAMPLES ? AUDIO_BLOCK_SAMPLES : n;
+        int32_t last = p->last;
+        int fade_left = (last != 0 && fade_len > 0) ? fade_len : 0;
+        for (size_t i = 0; i < k; i++) {
+            if (fade_left > 0) {
+                block[i] = (int16_t)((last * fade_left) / (fade_len + 1));
+                fade_left--;
+            } else {
+                block[i] = 0;
+            }
+        }
+        p->last = 0;
+        if (mix_write(block, k) != ESP_OK) return;
+        lipsync_feed(NULL, k);
+        p->cursor += k;
+        stat_add(&s_concealed_samples, (uint32_t)k);
+        n -= k;
+    }
+    p->fade_in = AUDIO_FADE_IN_SAMPLES;
+}
+
+static void play_samples(playout_t *p, const int16_t *samples, size_t count, size_t *played)
+{
+    int16_t block[AUDIO_BLOCK_SAMPLES];
+    size_t idx = 0;
+    while (idx < count && p->gen == s_flush_gen) {
+        size_t n = count - idx;
+        if (n > AUDIO_BLOCK_SAMPLES) n = AUDIO_BLOCK_SAMPLES;
+
+        const int16_t *src = samples + idx;
+        if (p->fade_in > 0) {
+            // Ramp in after concealment so resuming doesn't click either.
+            memcpy(block, src, n * sizeof(int16_t));
+            for (size_t i = 0; i < n && p->fade_in > 0; i++, p->fade_in--) {
+                int32_t step = AUDIO_FADE_IN_SAMPLES - p->fade_in;
+                block[i] = (int16_t)((block[i] * step) / AUDIO_FADE_IN_SAMPLES);
+            }
+            src = block;
+        }
+
+        esp_err_t e = mix_write(src, n);
+        if (e != ESP_OK) {
+            ESP_LOGW(TAG, "i2s write failed: %s", esp_err_to_name(e));
+            break;
+        }
+        lipsync_feed(src, n);
+        p->last = src[n - 1];
+        p->cursor += n;
+        queued_sub(n);
+        idx += n;
+    }
+    *played = idx;
+}
+
+// Start-on-threshold: hold a new timed stream back until target_ms is buffered, the host
+// marked its end, or we've waited twice the target (short utterance / slow host).
+static void wait_for_start_threshold(const audio_rec_t *first, uint32_t gen)
+{
+    const uint32_t target = s_jcfg.target_ms;
+    if (target == 0 || (first->flags & AUDIO_CHUNK_F_END)) return;
+
+    const int64_t deadline_us = esp_timer_get_time() + (int64_t)target * 2000;
+    while (gen == s_flush_gen) {
+        portENTER_CRITICAL(&s_stats_lock);
+        const bool ended = s_end_marks > 0;
+        portEXIT_CRITICAL(&s_stats_lock);
+        if (ended || queued_ms() >= target || esp_timer_get_time() >= deadline_us) return;
+        // Clips and tones keep playing while speech buffers up.
+        if (mixer_busy()) mix_write(NULL, AUDIO_BLOCK_SAMPLES);
+        else ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5));
+    }
+}
+
+// Records at another rate go through this resampler (writer task only).
+static audio_resampler_t s_rs;
+static int16_t s_rs_out[AUDIO_BLOCK_SAMPLES];
+
+static void start_stream(playout_t *p, const audio_rec_t *rec)
+{
+    p->timed = (rec->flags & AUDIO_CHUNK_F_TIMED) != 0;
+    if (p->timed) {
+        wait_for_start_threshold(rec, p->gen);
+    } else if (p->untimed_end_us &&
+               esp_timer_get_time() - p->untimed_end_us < (int64_t)AUDIO_UNDERRUN_GAP_MS * 1000) {
+        stat_add(&s_underruns, 1);
+    }
+    p->untimed_end_us = 0;
+    p->active = true;
+    p->starved = false;
+    p->stream_id = rec->stream_id;
+    p->cursor = p->timed ? ms_to_samples(rec->ts_ms) : 0;
+    audio_codec_reset();
+    audio_resampler_reset(&s_rs);
+}
+
+// Decode scratch for compressed records (writer task only).
+static int16_t s_dec[AUDIO_CODEC_MAX_FRAME_SAMPLES];
+
+// Play `n` decoded samples of `rec` (at its own rate), dropping the first *skip output-rate
+// samples. Returns false if playout stopped early (flush or I2S error).
+static bool play_decoded(playout_t *p, const audio_rec_t *rec, const int16_t *src, size_t n, size_t *skip,
+                         size_t *played)
+{
+    size_t done = 0;
+    if (!rec->rate_hz) {
+        if (*skip >= n) {
+            *skip -= n;
+            return true;
+        }
+        play_samples(p, src + *skip, n - *skip, &done);
+        *played += done;
+        const bool all = done == n - *skip;
+        *skip = 0;
+        return all;
+    }
+
+    while (n > 0) {
+        size_t used = 0;
+        const size_t k = audio_resample(&s_rs, src, n, &used, s_rs_out, AUDIO_BLOCK_SAMPLES);
+        src += used;
+        n -= used;
+        const size_t off = *skip < k ? *skip : k;
+        *skip -= off;
+        if (k > off) {
+            play_samples(p, s_rs_out + off, k - off, &done);
+            *played += done;
+            if (done < k - off) return false;
+        }
+    }
+    return true;
+}
+
+// Play a record's payload, dropping the first `skip` output samples. Returns samples played.
+static size_t play_payload(playout_t *p, const audio_rec_t *rec, size_t skip)
+{
+    const uint8_t *payload = (const uint8_t *)(rec + 1);
+    size_t played = 0;
+
+    if (rec->rate_hz && (s_rs.in_rate != rec->rate_hz || s_rs.out_rate != s_sample_rate)) {
+        audio_resampler_init(&s_rs, rec->rate_hz, s_sample_rate);
+    }
+
+    if (rec->codec == AUDIO_CODEC_PCM16) {
+        play_decoded(p, rec, (const int16_t *)payload, rec->bytes / sizeof(int16_t), &skip, &played);
+        return played;
+    }
+
+    audio_codec_cursor_t c = {.codec = (audio_codec_t)rec->codec, .p = payload, .left = rec->bytes};
+    while (p->gen == s_flush_gen) {
+        const int n = audio_codec_decode_next(&c, s_dec, s_sample_rate);
+        if (n < 0) {
+            ESP_LOGW(TAG, "%s decode failed (stream %u seq %u)", audio_codec_name((audio_codec_t)rec->codec),
+                     (unsigned)rec->stream_id, (unsigned)rec->seq);
+            break;
+        }
+        if (n == 0) break;
+        // Skipped units are still decoded so stateful codecs stay in sync.
+        if (!play_decoded(p, rec, s_dec, (size_t)n, &skip, &played)) break;
+    }
+    return played;
+}
+
+static void play_record(playout_t *p, audio_rec_t *rec)
+{
+    size_t count = rec->samples;
+    size_t skipped = 0;
+
+    if (p->timed && (rec->flags & AUDIO_CHUNK_F_TIMED)) {
+        // Playout-deadline scheduling against the stream timeline.
+        const uint64_t start = ms_to_samples(rec->ts_ms);
+        if (count > 0 && start + count <= p->cursor) {
+            stat_add(&s_late_chunks, 1);
+            rec_release(rec, count);
+            return;
+        }
+        const uint64_t slack = ms_to_samples(AUDIO_SYNC_SLACK_MS);
+        if (start + slack >= p->cursor && start <= p->cursor + slack) {
+            p->cursor = start; // contiguous: play it whole, no skip or concealment
+        } else if (start < p->cursor) {
+            skipped = (size_t)(p->cursor - start);
+        } else if (start > p->cursor) {
+            const uint64_t gap = start - p->cursor;
+            if (gap > ms_to_samples(s_jcfg.hold_ms)) {
+                p->cursor = start; // host jumped its timeline; re-anchor rather than stall
+            } else {
+                write_concealment(p, (size_t)gap);
+            }
+        }
+    }
+
+    size_t played = 0;
+    if (count > skipped) played = play_payload(p, rec, skipped);
+    rec_release(rec, count > played ? count - played : 0);
+}
+
+static void end_stream(playout_t *p)
+{
+    if (!p->timed) p->untimed_end_us = esp_timer_get_time();
+    p->active = false;
+    p->starved = false;
+    p->last = 0;
+    p->fade_in = 0;
+}
+
+static void audio_writer_task(void *arg)
+{
+    playout_t p = {0};
+    p.gen = s_flush_gen;
+
+    while (1) {
+        // Every producer (enqueue, flush, clip, tone) notifies this task, so an idle writer
+        // sleeps on its notification rather than in the ring.
+        size_t len = 0;
+        audio_rec_t *rec = (audio_rec_t *)xRingbufferReceive(s_queue, &len, 0);
+
+        if (p.gen != s_flush_gen) {
+            // Flushed: whatever was playing is gone; anything received now is new audio.
+            p.gen = s_flush_gen;
+            end_stream(&p);
+            p.untimed_end_us = 0;
+        }
+
+        if (!rec) {
+            if (!p.active) {
+                if (mixer_busy()) mix_write(NULL, AUDIO_BLOCK_SAMPLES);
+                else ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                continue;
+            }
+            if (!p.timed) {
+                // Legacy stream ran dry: fade out and stop (the next chunk restarts it).
+                write_concealment(&p, AUDIO_BLOCK_SAMPLES);
+                end_stream(&p);
+                continue;
+            }
+            if (!p.starved) {
+                p.starved = true;
+                p.starved_at = p.cursor;
+            }
+            write_concealment(&p, AUDIO_BLOCK_SAMPLES);
+            if (p.cursor - p.starved_at >= ms_to_samples(s_jcfg.hold_ms)) {
+                end_stream(&p);
+            }
+            continue;
+        }
+
+        if (!p.active || rec->stream_id != p.stream_id) {
+            start_stream(&p, rec);
+        } else if (p.starved) {
+            p.starved = false;
+            stat_add(&s_underruns, 1);
+        }
+
+        const bool end = (rec->flags & AUDIO_CHUNK_F_END) != 0;
+        play_record(&p, rec);
+        if (end) end_stream(&p);
+    }
+}
+
+static esp_err_t audio_queue_init(void)
+{
+    if (s_queue) return ESP_OK;
+
+    s_in_mux = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(s_in_mux, ESP_ERR_NO_MEM, TAG, "audio mutex alloc failed");
+
+    s_queue_bytes = AUDIO_QUEUE_BYTES;
+    s_queue = xRingbufferCreateWithCaps(s_queue_bytes, RINGBUF_TYPE_NOSPLIT, MALLOC_CAP_SPIRAM);
+    if (!s_queue) {
+        ESP_LOGW(TAG, "PSRAM audio queue alloc failed; falling back to internal RAM");
+        s_queue_bytes = AUDIO_QUEUE_BYTES / 8;
+        s_queue = xRingbufferCreate(s_queue_bytes, RINGBUF_TYPE_NOSPLIT);
+    }
+    ESP_RETURN_ON_FALSE(s_queue, ESP_ERR_NO_MEM, TAG, "audio queue alloc failed");
+
+    for (int i = 0; i < TONE_TABLE_LEN; i++) {
+        s_tone_table[i] = (int16_t)lrintf(TONE_AMPLITUDE * sinf(2.0f * (float)M_PI * (float)i / TONE_TABLE_LEN));
+    }
+
+    BaseType_t ok = xTaskCreatePinnedToCore(audio_writer_task, "audio_wr", AUDIO_TASK_STACK, NULL,
+                                            AUDIO_TASK_PRIORITY, &s_writer_task, AUDIO_TASK_CORE);
+    ESP_RETURN_ON_FALSE(ok == pdPASS, ESP_ERR_NO_MEM, TAG, "audio writer task create failed");
+    return ESP_OK;
+}
 
 static esp_err_t pa_enable(bool on)
 {
@@ -37,15 +755,40 @@ static esp_err_t pa_enable(bool on)
     return ESP_OK;
 }
 
+// ES8311 register sequences, run under the I2C bus lock (see i2c_bus_run / i2c_bus_xfer).
+static esp_err_t codec_setup(void *arg)
+{
+    const es8311_clock_config_t es_clk = {
+        .mclk_inverted = false,
+        .sclk_inverted = false,
+        .mclk_from_mclk_pin = true,
+        .mclk_frequency = s_sample_rate * 256,
+        .sample_frequency = s_sample_rate,
+    };
+
+    ESP_RETURN_ON_ERROR(es8311_init(s_es, &es_clk, ES8311_RESOLUTION_16, ES8311_RESOLUTION_16), TAG, "es8311_init failed");
+    ESP_RETURN_ON_ERROR(es8311_sample_frequency_config(s_es, s_sample_rate * 256, s_sample_rate), TAG, "es8311_sample_frequency_config failed");
+    ESP_RETURN_ON_ERROR(es8311_voice_volume_set(s_es, s_volume, NULL), TAG, "es8311_voice_volume_set failed");
+    ESP_RETURN_ON_ERROR(es8311_microphone_config(s_es, false), TAG, "es8311_microphone_config failed");
+    return ESP_OK;
+}
+
+static esp_err_t codec_set_volume(void *arg)
+{
+    return es8311_voice_volume_set(s_es, *(const int *)arg, NULL);
+}
+
 esp_err_t audio_init(const audio_config_t *cfg)
 {
     int volume = 75;
     if (cfg) {
         if (cfg->sample_rate_hz > 0) s_sample_rate = cfg->sample_rate_hz;
         if (cfg->volume_percent >= 0) volume = cfg->volume_percent;
+        s_on_lipsync_start = cfg->on_lipsync_start;
     }
     if (volume < 0) volume = 0;
     if (volume > 100) volume = 100;
+    s_volume = volume;
 
     ESP_RETURN_ON_ERROR(pa_enable(true), TAG, "PA enable failed");
 
@@ -54,11 +797,13 @@ esp_err_t audio_init(const audio_config_t *cfg)
         i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
         chan_cfg.auto_clear = true;
         ESP_RETURN_ON_ERROR(i2s_new_channel(&chan_cfg, &s_tx, NULL), TAG, "i2s_new_channel failed");
+        s_dma_latency_us = (int64_t)chan_cfg.dma_desc_num * chan_cfg.dma_frame_num * 1000000 / s_sample_rate;
 
         i2s_std_config_t std_cfg = {
             .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(s_sample_rate),
-            // ES8311 example uses stereo slots; we'll duplicate mono samples into L+R.
-            .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO),
+            // The ES8311 expects a stereo frame; in mono slot mode the peripheral fills both slots.
+            .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, AUDIO_OUT_CHANNELS == 1
+                                                            ? I2S_SLOT_MODE_MONO : I2S_SLOT_MODE_STEREO),
             .gpio_cfg = {
                 .mclk = I2S_MCK_IO,
                 .bclk = I2S_BCK_IO,
@@ -74,87 +819,453 @@ esp_err_t audio_init(const audio_config_t *cfg)
         };
         // Common multiple for audio codecs
         std_cfg.clk_cfg.mclk_multiple = I2S_MCLK_MULTIPLE_256;
+        std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_BOTH;
 
         ESP_RETURN_ON_ERROR(i2s_channel_init_std_mode(s_tx, &std_cfg), TAG, "i2s_channel_init_std_mode failed");
         ESP_RETURN_ON_ERROR(i2s_channel_enable(s_tx), TAG, "i2s_channel_enable failed");
     }
 
+    ESP_RETURN_ON_ERROR(audio_queue_init(), TAG, "audio queue init failed");
+
     // ---- ES8311 ----
     if (!s_es) {
         // ES8311 address: CE low -> 0x18. Your I2C scan shows 0x18 present.
-        // Uses I2C_NUM_0 (same bus as touch).
-        s_es = es8311_create(I2C_NUM_0, ES8311_ADDRRES_0);
+        // Shares the I2C bus with touch; i2c_bus owns the port.
+        s_es = es8311_create(i2c_bus_port(), ES8311_ADDRRES_0);
         ESP_RETURN_ON_FALSE(s_es, ESP_FAIL, TAG, "es8311_create failed");
+        ESP_RETURN_ON_ERROR(i2c_bus_run(I2C_DEV_CODEC, codec_setup, NULL, 1000), TAG, "ES8311 setup failed");
 
-        const es8311_clock_config_t es_clk = {
-            .mclk_inverted = false,
-            .sclk_inverted = false,
-            .mclk_from_mclk_pin = true,
-            .mclk_frequency = s_sample_rate * 256,
-            .sample_frequency = s_sample_rate,
-        };
+        ESP_LOGI(TAG, "Audio init OK (sr=%d, vol=%d%%)", s_sample_rate, volume);
+    }
+
+    return ESP_OK;
+}
 
-        ESP_RETURN_ON_ERROR(es8311_init(s_es, &es_clk, ES8311_RESOLUTION_16, ES8311_RESOLUTION_16), TAG, "es8311_init failed");
-        ESP_RETURN_ON_ERROR(es8311_sample_frequency_config(s_es, s_sample_rate * 256, s_sample_rate), TAG, "es8311_sample_frequency_config failed");
-        ESP_RETURN_ON_ERROR(es8311_voice_volume_set(s_es, volume, NULL), TAG, "es8311_voice_volume_set failed");
-        ESP_RETURN_ON_ERROR(es8311_microphone_config(s_es, false), TAG, "es8311_microphone_config failed");
+static esp_err_t enqueue_record(const audio_chunk_info_t *info, uint32_t ts_ms, uint16_t flags, uint16_t rate_hz,
+                                const uint8_t *data, size_t len, size_t n, TickType_t ticks)
+{
+    void *slot = NULL;
+    if (xRingbufferSendAcquire(s_queue, &slot, sizeof(audio_rec_t) + len, ticks) != pdTRUE) return ESP_ERR_TIMEOUT;
 
-        ESP_LOGI(TAG, "Audio init OK (sr=%d, vol=%d%%)", s_sample_rate, volume);
+    audio_rec_t *rec = (audio_rec_t *)slot;
+    rec->seq = info->seq;
+    rec->ts_ms = ts_ms;
+    rec->stream_id = info->stream_id;
+    rec->flags = flags;
+    rec->samples = (uint32_t)n;
+    rec->bytes = (uint32_t)len;
+    rec->codec = info->codec;
+    rec->reserved = 0;
+    rec->rate_hz = rate_hz;
+    if (len) memcpy(rec + 1, data, len);
+
+    // Count before publishing so the writer can never decrement below what it sees.
+    portENTER_CRITICAL(&s_stats_lock);
+    s_queued_samples += (uint32_t)n;
+    if (flags & AUDIO_CHUNK_F_END) s_end_marks++;
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    xRingbufferSendComplete(s_queue, slot);
+    xTaskNotifyGive(s_writer_task);
+    return ESP_OK;
+}
+
+// The newest chunk timed out after payload samples [0, queued) made it into the ring:
+// let a resend of it through, and have it skip what is already queued.
+static void in_mark_retry(const audio_chunk_info_t *info, uint64_t queued)
+{
+    xSemaphoreTake(s_in_mux, portMAX_DELAY);
+    if (s_in_valid && s_in_stream == info->stream_id && s_in_seq == info->seq) {
+        s_in_retry = true;
+        if (queued > s_in_queued_samples) s_in_queued_samples = queued;
+    }
+    xSemaphoreGive(s_in_mux);
+}
+
+esp_err_t audio_enqueue_chunk(const audio_chunk_info_t *info, const void *data, size_t len,
+                              uint32_t timeout_ms, bool *dropped)
+{
+    if (dropped) *dropped = false;
+    if (!s_tx || !s_queue || !info) return ESP_ERR_INVALID_STATE;
+    if (!audio_codec_supported((audio_codec_t)info->codec)) return ESP_ERR_NOT_SUPPORTED;
+    if (len > 0 && !data) return ESP_ERR_INVALID_ARG;
+
+    const uint8_t *bytes = (const uint8_t *)data;
+    if (info->codec == AUDIO_CODEC_PCM16) len &= ~((size_t)1);
+    if (len == 0 && !(info->flags & AUDIO_CHUNK_F_END)) return ESP_ERR_INVALID_ARG;
+    if (len > 0 && audio_codec_decoded_samples((audio_codec_t)info->codec, bytes, len, s_sample_rate) < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Opus decodes at the output rate whatever it was encoded at.
+    const uint32_t src_rate = (info->sample_rate && info->codec != AUDIO_CODEC_OPUS)
+                              ? info->sample_rate : (uint32_t)s_sample_rate;
+    if (src_rate < AUDIO_RESAMPLE_MIN_RATE || src_rate > AUDIO_RESAMPLE_MAX_RATE) return ESP_ERR_INVALID_ARG;
+    const uint16_t rate_hz = src_rate == (uint32_t)s_sample_rate ? 0 : (uint16_t)src_rate;
+
+    const TickType_t ticks = (timeout_ms == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+
+    const bool timed = info->flags & AUDIO_CHUNK_F_TIMED;
+    uint64_t done_samples = 0;
+    uint64_t skip_samples = 0; // records ending at or before this were queued by an earlier try
+    if (timed && (info->flags & AUDIO_CHUNK_F_CONT)) {
+        xSemaphoreTake(s_in_mux, portMAX_DELAY);
+        const bool ok = s_in_valid && info->stream_id == s_in_stream && info->seq == s_in_seq;
+        done_samples = s_in_part_samples;
+        skip_samples = s_in_queued_samples;
+        xSemaphoreGive(s_in_mux);
+        if (!ok) {
+            if (dropped) *dropped = true;
+            return ESP_OK;
+        }
+    } else if (timed) {
+        // Duplicates and reordered chunks never reach the ring; a resend of a chunk that was
+        // rejected for lack of room picks up where it stopped.
+        xSemaphoreTake(s_in_mux, portMAX_DELAY);
+        bool drop = false;
+        const bool same = s_in_valid && info->stream_id == s_in_stream;
+        if (same && info->seq == s_in_seq && s_in_retry) {
+            s_in_retry = false;
+            s_in_part_samples = 0;
+            skip_samples = s_in_queued_samples;
+        } else if (same && info->seq <= s_in_seq) {
+            drop = true;
+            stat_add(info->seq == s_in_seq ? &s_dropped_chunks : &s_late_chunks, 1);
+        } else {
+            s_in_valid = true;
+            s_in_stream = info->stream_id;
+            s_in_seq = info->seq;
+            s_in_part_samples = 0;
+            s_in_queued_samples = 0;
+            s_in_retry = false;
+        }
+        xSemaphoreGive(s_in_mux);
+        if (drop) {
+            if (dropped) *dropped = true;
+            return ESP_OK;
+        }
+    }
+
+    // done_samples counts payload (source rate) samples.
+    if (len == 0) {
+        const uint32_t ts = info->ts_ms + (uint32_t)((done_samples * 1000) / src_rate);
+        esp_err_t e = enqueue_record(info, ts, info->flags, rate_hz, NULL, 0, 0, ticks);
+        if (e != ESP_OK) {
+            stat_add(&s_dropped_chunks, 1);
+            if (timed) in_mark_retry(info, done_samples);
+        }
+        return e;
+    }
+
+    // NOSPLIT items must fit in half the ring; split big chunks on decode unit boundaries
+    // (timestamps follow along).
+    const size_t max_bytes = (xRingbufferGetMaxItemSize(s_queue) - sizeof(audio_rec_t))
+                             & ~((size_t)AUDIO_BLOCK_SAMPLES * sizeof(int16_t) - 1);
+
+    const uint64_t first_samples = done_samples;
+    size_t off = 0;
+    while (off < len) {
+        const size_t n = audio_codec_split_point((audio_codec_t)info->codec, bytes + off, len - off, max_bytes);
+        if (n == 0) return ESP_ERR_INVALID_SIZE;
+        const int samples = audio_codec_decoded_samples((audio_codec_t)info->codec, bytes + off, n, s_sample_rate);
+        const bool last = (off + n) >= len;
+        const uint32_t ts = info->ts_ms + (uint32_t)((done_samples * 1000) / src_rate);
+        const uint16_t flags = last ? info->flags : (info->flags & ~AUDIO_CHUNK_F_END);
+        const size_t out = rate_hz ? audio_resample_out_len((int)src_rate, s_sample_rate, (size_t)samples)
+                                   : (size_t)samples;
+
+        // The split is deterministic, so a resent chunk lines up with the records already queued.
+        if (done_samples + (uint64_t)samples > skip_samples) {
+            esp_err_t e = enqueue_record(info, ts, flags, rate_hz, bytes + off, n, out, ticks);
+            if (e != ESP_OK) {
+                stat_add(&s_dropped_chunks, 1);
+                if (timed) in_mark_retry(info, done_samples);
+                return e;
+            }
+        }
+        off += n;
+        done_samples += (uint64_t)samples;
     }
 
+    if (timed) {
+        xSemaphoreTake(s_in_mux, portMAX_DELAY);
+        if (s_in_stream == info->stream_id && s_in_seq == info->seq) {
+            s_in_part_samples += done_samples - first_samples;
+            if (done_samples > s_in_queued_samples) s_in_queued_samples = done_samples;
+        }
+        xSemaphoreGive(s_in_mux);
+    }
     return ESP_OK;
 }
 
+esp_err_t audio_enqueue_pcm16_mono(const int16_t *samples, size_t sample_count, uint32_t timeout_ms)
+{
+    if (!samples || sample_count == 0) return ESP_ERR_INVALID_STATE;
+    const audio_chunk_info_t info = {0};
+    return audio_enqueue_chunk(&info, samples, sample_count * sizeof(int16_t), timeout_ms, NULL);
+}
+
 esp_err_t audio_play_pcm16_mono(const int16_t *samples, size_t sample_count)
 {
-    if (!s_tx || !samples || sample_count == 0) return ESP_ERR_INVALID_STATE;
+    return audio_enqueue_pcm16_mono(samples, sample_count, UINT32_MAX);
+}
 
-    // Duplicate mono into stereo in small chunks to keep RAM low.
-    int16_t stereo[256 * 2];
-    size_t idx = 0;
-    while (idx < sample_count) {
-        size_t n = sample_count - idx;
-        if (n > 256) n = 256;
-        for (size_t i = 0; i < n; i++) {
-            int16_t s = samples[idx + i];
-            stereo[i * 2 + 0] = s;
-            stereo[i * 2 + 1] = s;
+void audio_flush(void)
+{
+    if (!s_queue) return;
+
+    // Abort whatever the writer is in the middle of, then drop everything still queued.
+    s_flush_gen++;
+
+    size_t len = 0;
+    audio_rec_t *rec;
+    while ((rec = (audio_rec_t *)xRingbufferReceive(s_queue, &len, 0)) != NULL) {
+        rec_release(rec, rec->samples);
+    }
+
+    xSemaphoreTake(s_in_mux, portMAX_DELAY);
+    s_in_valid = false;
+    xSemaphoreGive(s_in_mux);
+
+    portENTER_CRITICAL(&s_mix_lock);
+    s_clip_req = (clip_req_t){.seq = s_clip_req.seq + 1};
+    s_tone_req = (tone_req_t){.seq = s_tone_req.seq + 1};
+    portEXIT_CRITICAL(&s_mix_lock);
+    xTaskNotifyGive(s_writer_task);
+}
+
+esp_err_t audio_get_stats(audio_stats_t *out)
+{
+    if (!out) return ESP_ERR_INVALID_ARG;
+    if (!s_queue) return ESP_ERR_INVALID_STATE;
+
+    portENTER_CRITICAL(&s_stats_lock);
+    const uint32_t queued = s_queued_samples;
+    out->underruns = s_underruns;
+    out->late_chunks = s_late_chunks;
+    out->dropped_chunks = s_dropped_chunks;
+    const uint32_t concealed = s_concealed_samples;
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    out->queued_samples = queued;
+    out->queued_ms = (uint32_t)(((uint64_t)queued * 1000) / (uint32_t)s_sample_rate);
+    out->capacity_ms = (uint32_t)(((uint64_t)(s_queue_bytes / sizeof(int16_t)) * 1000) / (uint32_t)s_sample_rate);
+    out->concealed_ms = (uint32_t)(((uint64_t)concealed * 1000) / (uint32_t)s_sample_rate);
+    return ESP_OK;
+}
+
+void audio_reset_stats(void)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    s_underruns = 0;
+    s_late_chunks = 0;
+    s_dropped_chunks = 0;
+    s_concealed_samples = 0;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+void audio_get_jitter_config(audio_jitter_config_t *out)
+{
+    if (out) *out = s_jcfg;
+}
+
+esp_err_t audio_set_jitter_config(const audio_jitter_config_t *cfg)
+{
+    if (!cfg || cfg->target_ms > 2000 || cfg->fade_ms > 100 || cfg->hold_ms > 5000) return ESP_ERR_INVALID_ARG;
+    s_jcfg = *cfg;
+    return ESP_OK;
+}
+
+esp_err_t audio_set_volume(int percent)
+{
+    if (!s_es) return ESP_ERR_INVALID_STATE;
+    if (percent < 0) percent = 0;
+    if (percent > 100) percent = 100;
+    // One register write: a touch read waits for at most this transfer.
+    esp_err_t err = i2c_bus_xfer(I2C_DEV_CODEC, codec_set_volume, &percent, 50);
+    if (err == ESP_OK) s_volume = percent;
+    return err;
+}
+
+int audio_get_volume(void)
+{
+    return s_volume;
+}
+
+int audio_get_sample_rate(void)
+{
+    return s_sample_rate;
+}
+
+void audio_get_lipsync_config(audio_lipsync_config_t *out)
+{
+    if (out) *out = s_lcfg;
+}
+
+esp_err_t audio_set_lipsync_config(const audio_lipsync_config_t *cfg)
+{
+    if (!cfg || cfg->attack_ms > 500 || cfg->release_ms > 2000 || cfg->full_scale <= LIPSYNC_FLOOR_RMS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_lcfg = *cfg;
+    return ESP_OK;
+}
+
+bool audio_lipsync_level(float *open)
+{
+    *open = 0.0f;
+    if (!s_lcfg.enabled) return false;
+
+    const int64_t now = esp_timer_get_time();
+    bool live = false;
+    portENTER_CRITICAL(&s_lip_lock);
+    const uint32_t n = s_lip_count < LIPSYNC_POINTS ? s_lip_count : LIPSYNC_POINTS;
+    if (n > 0) {
+        live = now <= s_lip[(s_lip_count - 1) % LIPSYNC_POINTS].play_us + LIPSYNC_HOLD_US;
+        // Newest block that is already audible; blocks still in the DMA queue are in the future.
+        for (uint32_t i = 1; i <= n; i++) {
+            const lipsync_point_t *pt = &s_lip[(s_lip_count - i) % LIPSYNC_POINTS];
+            if (pt->play_us <= now) {
+                *open = pt->level;
+                break;
+            }
         }
+    }
+    portEXIT_CRITICAL(&s_lip_lock);
+    return live;
+}
 
-        size_t bytes_written = 0;
-        esp_err_t e = i2s_channel_write(s_tx, stereo, n * 2 * sizeof(int16_t), &bytes_written, pdMS_TO_TICKS(2000));
-        if (e != ESP_OK) return e;
-        idx += n;
+const char *audio_voice_name(audio_voice_t voice)
+{
+    switch (voice) {
+        case AUDIO_VOICE_SPEECH: return "speech";
+        case AUDIO_VOICE_CLIP: return "clip";
+        case AUDIO_VOICE_TONE: return "tone";
+        default: return "unknown";
     }
+}
+
+esp_err_t audio_set_voice_gain(audio_voice_t voice, int percent)
+{
+    if ((unsigned)voice >= AUDIO_VOICE_COUNT) return ESP_ERR_INVALID_ARG;
+    if (percent < 0) percent = 0;
+    if (percent > 100) percent = 100;
+    s_gain[voice] = (percent * MIX_Q15_ONE + 50) / 100;
+    return ESP_OK;
+}
+
+int audio_get_voice_gain(audio_voice_t voice)
+{
+    if ((unsigned)voice >= AUDIO_VOICE_COUNT) return 0;
+    return (s_gain[voice] * 100 + MIX_Q15_ONE / 2) / MIX_Q15_ONE;
+}
 
+esp_err_t audio_play_clip(const void *data, size_t len, audio_codec_t codec)
+{
+    if (!s_tx || !s_writer_task) return ESP_ERR_INVALID_STATE;
+    // Only stateless codecs: the clip decodes beside a speech stream that may be using Opus.
+    if (codec != AUDIO_CODEC_PCM16 && codec != AUDIO_CODEC_IMA_ADPCM) return ESP_ERR_NOT_SUPPORTED;
+    if (!data || len == 0) return ESP_ERR_INVALID_ARG;
+    if (codec == AUDIO_CODEC_PCM16 && ((uintptr_t)data & 1)) return ESP_ERR_INVALID_ARG;
+    if (audio_codec_decoded_samples(codec, data, len, s_sample_rate) <= 0) return ESP_ERR_INVALID_ARG;
+
+    portENTER_CRITICAL(&s_mix_lock);
+    s_clip_req = (clip_req_t){.seq = s_clip_req.seq + 1, .data = data, .len = len, .codec = codec};
+    portEXIT_CRITICAL(&s_mix_lock);
+    xTaskNotifyGive(s_writer_task);
     return ESP_OK;
 }
 
 esp_err_t audio_beep(int freq_hz, int duration_ms)
 {
+    if (!s_tx || !s_writer_task) return ESP_ERR_INVALID_STATE;
     if (freq_hz <= 0) freq_hz = 880;
+    if (freq_hz >= s_sample_rate / 2) freq_hz = s_sample_rate / 2 - 1;
     if (duration_ms <= 0) duration_ms = 120;
     if (duration_ms > 2000) duration_ms = 2000;
 
-    const float amp = 0.25f; // keep it gentle
-    const int total = (s_sample_rate * duration_ms) / 1000;
+    const tone_req_t tone = {
+        .phase_inc = (uint32_t)(((uint64_t)freq_hz << 32) / (uint32_t)s_sample_rate),
+        .samples = (uint32_t)((s_sample_rate * duration_ms) / 1000),
+    };
+    portENTER_CRITICAL(&s_mix_lock);
+    s_tone_req = (tone_req_t){.seq = s_tone_req.seq + 1, .phase_inc = tone.phase_inc, .samples = tone.samples};
+    portEXIT_CRITICAL(&s_mix_lock);
+    xTaskNotifyGive(s_writer_task);
+    return ESP_OK;
+}
+
+static uint32_t bench_case(int mode, const int16_t *speech, const int16_t *clip, int16_t *frames, int16_t *dma,
+                           int32_t *acc, uint32_t blocks)
+{
+    const size_t n = AUDIO_BLOCK_SAMPLES;
+    mixer_t m = {.tone_on = true, .phase_inc = 0x0E000000u, .tone_len = UINT32_MAX};
+    const uint32_t t0 = esp_cpu_get_cycle_count();
+    for (uint32_t b = 0; b < blocks; b++) {
+        switch (mode) {
+            case 0:
+                frames_from_pcm(frames, speech, n, MIX_Q15_ONE, 2);
+                memcpy(dma, frames, n * 2 * sizeof(int16_t));
+                break;
+            case 1:
+                memcpy(dma, speech, n * sizeof(int16_t));
+                break;
+            default:
+                m.clip = (audio_codec_cursor_t){.codec = AUDIO_CODEC_PCM16, .p = (const uint8_t *)clip,
+                                                .left = n * sizeof(int16_t)};
+                m.clip_avail = 0;
+                m.clip_on = true;
+                mix_voices(&m, acc, speech, n, MIX_Q15_ONE);
+                frames_from_acc(frames, acc, n, 1);
+                memcpy(dma, frames, n * sizeof(int16_t));
+                break;
+        }
+        __asm__ volatile("" ::: "memory"); // keep every block's copy
+    }
+    return esp_cpu_get_cycle_count() - t0;
+}
+
+esp_err_t audio_bench(uint32_t audio_ms, audio_bench_t *out)
+{
+    if (!out || audio_ms == 0 || audio_ms > 10000) return ESP_ERR_INVALID_ARG;
+    if (!s_queue) return ESP_ERR_INVALID_STATE; // tone table not built yet
 
-    int16_t buf[256];
-    int produced = 0;
-    while (produced < total) {
-        int n = total - produced;
-        if (n > (int)(sizeof(buf)/sizeof(buf[0]))) n = (int)(sizeof(buf)/sizeof(buf[0]));
+    const size_t n = AUDIO_BLOCK_SAMPLES;
+    int16_t *speech = heap_caps_malloc(n * sizeof(int16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    int16_t *clip = heap_caps_malloc(n * sizeof(int16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    int16_t *frames = heap_caps_malloc(n * 2 * sizeof(int16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    int16_t *dma = heap_caps_malloc(n * 2 * sizeof(int16_t), MALLOC_CAP_DMA);
+    int32_t *acc = heap_caps_malloc(n * sizeof(int32_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    esp_err_t err = ESP_ERR_NO_MEM;
+    if (speech && clip && frames && dma && acc) {
+        for (size_t i = 0; i < n; i++) {
+            speech[i] = (int16_t)(s_tone_table[(i * 3) & (TONE_TABLE_LEN - 1)] * 3);
+            clip[i] = s_tone_table[(i * 11) & (TONE_TABLE_LEN - 1)];
+        }
+        uint32_t blocks = (uint32_t)(ms_to_samples(audio_ms) / n);
+        if (blocks == 0) blocks = 1;
 
-        for (int i = 0; i < n; i++) {
-            float t = (float)(produced + i) / (float)s_sample_rate;
-            float v = sinf(2.0f * (float)M_PI * (float)freq_hz * t);
-            int32_t s = (int32_t)(v * amp * 32767.0f);
-            buf[i] = (int16_t)s;
+        uint32_t best[3] = {UINT32_MAX, UINT32_MAX, UINT32_MAX};
+        for (int rep = 0; rep < 3; rep++) {
+            for (int mode = 0; mode < 3; mode++) {
+                const uint32_t c = bench_case(mode, speech, clip, frames, dma, acc, blocks);
+                if (c < best[mode]) best[mode] = c;
+            }
         }
 
-        ESP_RETURN_ON_ERROR(audio_play_pcm16_mono(buf, (size_t)n), TAG, "beep write failed");
-        produced += n;
+        const uint64_t samples = (uint64_t)blocks * n;
+        out->audio_ms = (uint32_t)(samples * 1000 / (uint32_t)s_sample_rate);
+        out->stereo_copy = (uint32_t)((uint64_t)best[0] * (uint32_t)s_sample_rate / samples);
+        out->mono = (uint32_t)((uint64_t)best[1] * (uint32_t)s_sample_rate / samples);
+        out->mono_mixed = (uint32_t)((uint64_t)best[2] * (uint32_t)s_sample_rate / samples);
+        out->cpu_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+        out->mono_slot = AUDIO_OUT_CHANNELS == 1;
+        err = ESP_OK;
     }
-
-    return ESP_OK;
+    heap_caps_free(speech);
+    heap_caps_free(clip);
+    heap_caps_free(frames);
+    heap_caps_free(dma);
+    heap_caps_free(acc);
+    return err;
 }
@@ -0,0 +1,268 @@
+#include "audio_codec.h"
+
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+#if CONFIG_LITTLEAI_AUDIO_OPUS
+#include "opus.h"
+
+static const char *TAG = "audio_codec";
+#endif
+
+// ---------- IMA-ADPCM ----------
+
+static const int16_t kImaStep[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int8_t kImaIndex[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+static inline int16_t ima_step(int32_t *pred, int *index, uint8_t code)
+{
+    const int32_t step = kImaStep[*index];
+    int32_t delta = step >> 3;
+    if (code & 4) delta += step;
+    if (code & 2) delta += step >> 1;
+    if (code & 1) delta += step >> 2;
+
+    int32_t p = (code & 8) ? (*pred - delta) : (*pred + delta);
+    if (p > 32767) p = 32767;
+    if (p < -32768) p = -32768;
+    *pred = p;
+
+    int idx = *index + kImaIndex[code & 7];
+    if (idx < 0) idx = 0;
+    if (idx > 88) idx = 88;
+    *index = idx;
+    return (int16_t)p;
+}
+
+size_t ima_adpcm_decode_block(const uint8_t *block, size_t len, int16_t *out)
+{
+    if (len < 4) return 0;
+    if (len > IMA_ADPCM_BLOCK_BYTES) len = IMA_ADPCM_BLOCK_BYTES;
+
+    int32_t pred = (int16_t)((uint16_t)block[0] | ((uint16_t)block[1] << 8));
+    int index = block[2] > 88 ? 88 : block[2];
+
+    size_t n = 0;
+    out[n++] = (int16_t)pred;
+    for (size_t i = 4; i < len; i++) {
+        const uint8_t b = block[i];
+        out[n++] = ima_step(&pred, &index, b & 0x0F);
+        out[n++] = ima_step(&pred, &index, b >> 4);
+    }
+    return n;
+}
+
+static int adpcm_samples(size_t len)
+{
+    const size_t full = len / IMA_ADPCM_BLOCK_BYTES;
+    const size_t tail = len % IMA_ADPCM_BLOCK_BYTES;
+    if (tail > 0 && tail < 4) return -1;
+    return (int)(full * IMA_ADPCM_BLOCK_SAMPLES + (tail ? 1 + 2 * (tail - 4) : 0));
+}
+
+// ---------- Opus (optional) ----------
+
+#if CONFIG_LITTLEAI_AUDIO_OPUS
+static OpusDecoder *s_opus = NULL;
+static int s_opus_rate = 0;
+
+static OpusDecoder *opus_get(int sample_rate)
+{
+    if (s_opus && s_opus_rate == sample_rate) return s_opus;
+
+    if (!s_opus) {
+        s_opus = (OpusDecoder *)heap_caps_malloc(opus_decoder_get_size(1), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!s_opus) {
+            ESP_LOGE(TAG, "no mem for opus decoder");
+            return NULL;
+        }
+    }
+    if (opus_decoder_init(s_opus, sample_rate, 1) != OPUS_OK) {
+        ESP_LOGE(TAG, "opus_decoder_init(%d) failed", sample_rate);
+        heap_caps_free(s_opus);
+        s_opus = NULL;
+        return NULL;
+    }
+    s_opus_rate = sample_rate;
+    return s_opus;
+}
+#endif
+
+// Opus payload framing: [u16 LE len][packet] repeated. Returns the packet length or -1.
+static int opus_next_packet(const uint8_t *p, size_t left, const uint8_t **pkt)
+{
+    if (left < 2) return -1;
+    const size_t n = (size_t)p[0] | ((size_t)p[1] << 8);
+    if (n == 0 || n + 2 > left) return -1;
+    *pkt = p + 2;
+    return (int)n;
+}
+
+static int opus_samples(const uint8_t *data, size_t len, int sample_rate)
+{
+#if CONFIG_LITTLEAI_AUDIO_OPUS
+    int total = 0;
+    while (len > 0) {
+        const uint8_t *pkt = NULL;
+        int n = opus_next_packet(data, len, &pkt);
+        if (n < 0) return -1;
+        int s = opus_packet_get_nb_samples(pkt, n, sample_rate);
+        if (s <= 0 || s > AUDIO_CODEC_MAX_FRAME_SAMPLES) return -1;
+        total += s;
+        data += n + 2;
+        len -= (size_t)n + 2;
+    }
+    return total;
+#else
+    return -1;
+#endif
+}
+
+// ---------- Public API ----------
+
+bool audio_codec_supported(audio_codec_t codec)
+{
+    switch (codec) {
+        case AUDIO_CODEC_PCM16: return true;
+        case AUDIO_CODEC_IMA_ADPCM: return true;
+#if CONFIG_LITTLEAI_AUDIO_OPUS
+        case AUDIO_CODEC_OPUS: return true;
+#endif
+        default: return false;
+    }
+}
+
+const char *audio_codec_name(audio_codec_t codec)
+{
+    switch (codec) {
+        case AUDIO_CODEC_PCM16: return "pcm16";
+        case AUDIO_CODEC_IMA_ADPCM: return "adpcm";
+        case AUDIO_CODEC_OPUS: return "opus";
+        default: return "unknown";
+    }
+}
+
+bool audio_codec_from_name(const char *name, audio_codec_t *out)
+{
+    if (!name || !out) return false;
+    if (strcmp(name, "pcm16") == 0) { *out = AUDIO_CODEC_PCM16; return true; }
+    if (strcmp(name, "adpcm") == 0) { *out = AUDIO_CODEC_IMA_ADPCM; return true; }
+    if (strcmp(name, "opus") == 0) { *out = AUDIO_CODEC_OPUS; return true; }
+    return false;
+}
+
+int audio_codec_decoded_samples(audio_codec_t codec, const uint8_t *data, size_t len, int sample_rate)
+{
+    switch (codec) {
+        case AUDIO_CODEC_PCM16: return (int)(len / sizeof(int16_t));
+        case AUDIO_CODEC_IMA_ADPCM: return adpcm_samples(len);
+        case AUDIO_CODEC_OPUS: return opus_samples(data, len, sample_rate);
+        default: return -1;
+    }
+}
+
+size_t audio_codec_split_point(audio_codec_t codec, const uint8_t *data, size_t len, size_t max_len)
+{
+    if (len <= max_len) return len;
+
+    switch (codec) {
+        case AUDIO_CODEC_PCM16:
+            return max_len & ~((size_t)1);
+        case AUDIO_CODEC_IMA_ADPCM:
+            return (max_len / IMA_ADPCM_BLOCK_BYTES) * IMA_ADPCM_BLOCK_BYTES;
+        case AUDIO_CODEC_OPUS: {
+            size_t off = 0;
+            while (off < len) {
+                const uint8_t *pkt = NULL;
+                int n = opus_next_packet(data + off, len - off, &pkt);
+                if (n < 0 || off + (size_t)n + 2 > max_len) break;
+                off += (size_t)n + 2;
+            }
+            return off;
+        }
+        default:
+            return 0;
+    }
+}
+
+size_t audio_codec_unit_prefix(audio_codec_t codec, const uint8_t *data, size_t len)
+{
+    switch (codec) {
+        case AUDIO_CODEC_PCM16:
+            return len & ~((size_t)1);
+        case AUDIO_CODEC_IMA_ADPCM:
+            return (len / IMA_ADPCM_BLOCK_BYTES) * IMA_ADPCM_BLOCK_BYTES;
+        case AUDIO_CODEC_OPUS: {
+            size_t off = 0;
+            const uint8_t *pkt = NULL;
+            int n;
+            while ((n = opus_next_packet(data + off, len - off, &pkt)) >= 0) off += (size_t)n + 2;
+            return off;
+        }
+        default:
+            return 0;
+    }
+}
+
+int audio_codec_decode_next(audio_codec_cursor_t *c, int16_t *out, int sample_rate)
+{
+    if (c->left == 0) return 0;
+
+    switch (c->codec) {
+        case AUDIO_CODEC_PCM16: {
+            size_t n = c->left / sizeof(int16_t);
+            if (n > AUDIO_CODEC_MAX_FRAME_SAMPLES) n = AUDIO_CODEC_MAX_FRAME_SAMPLES;
+            if (n == 0) {
+                c->left = 0;
+                return 0;
+            }
+            memcpy(out, c->p, n * sizeof(int16_t));
+            c->p += n * sizeof(int16_t);
+            c->left -= n * sizeof(int16_t);
+            return (int)n;
+        }
+        case AUDIO_CODEC_IMA_ADPCM: {
+            size_t n = c->left > IMA_ADPCM_BLOCK_BYTES ? IMA_ADPCM_BLOCK_BYTES : c->left;
+            size_t s = ima_adpcm_decode_block(c->p, n, out);
+            c->p += n;
+            c->left -= n;
+            return s ? (int)s : -1;
+        }
+#if CONFIG_LITTLEAI_AUDIO_OPUS
+        case AUDIO_CODEC_OPUS: {
+            const uint8_t *pkt = NULL;
+            int n = opus_next_packet(c->p, c->left, &pkt);
+            OpusDecoder *dec = opus_get(sample_rate);
+            if (n < 0 || !dec) {
+                c->left = 0;
+                return -1;
+            }
+            c->p += n + 2;
+            c->left -= (size_t)n + 2;
+            int s = opus_decode(dec, pkt, n, out, AUDIO_CODEC_MAX_FRAME_SAMPLES, 0);
+            return s > 0 ? s : -1;
+        }
+#endif
+        default:
+            c->left = 0;
+            return -1;
+    }
+}
+
+void audio_codec_reset(void)
+{
+#if CONFIG_LITTLEAI_AUDIO_OPUS
+    if (s_opus) opus_decoder_ctl(s_opus, OPUS_RESET_STATE);
+#endif
+}
@@ -0,0 +1,90 @@
+#include "audio_resample.h"
+
+#include <math.h>
+#include <string.h>
+
+#define Q16_ONE (1u << 16)
+
+static float sinc(float x)
+{
+    if (fabsf(x) < 1e-6f) return 1.0f;
+    return sinf((float)M_PI * x) / ((float)M_PI * x);
+}
+
+esp_err_t audio_resampler_init(audio_resampler_t *r, int in_rate, int out_rate)
+{
+    if (!r || in_rate < AUDIO_RESAMPLE_MIN_RATE || in_rate > AUDIO_RESAMPLE_MAX_RATE ||
+        out_rate < AUDIO_RESAMPLE_MIN_RATE || out_rate > AUDIO_RESAMPLE_MAX_RATE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    r->in_rate = in_rate;
+    r->out_rate = out_rate;
+    r->step = (uint32_t)(((uint64_t)in_rate << 16) / (uint32_t)out_rate);
+    r->step_rem = (uint32_t)(((uint64_t)in_rate << 16) % (uint32_t)out_rate);
+
+    // Cutoff in units of the input Nyquist rate, a little below it for the transition band.
+    const float fc = 0.92f * (out_rate < in_rate ? (float)out_rate / (float)in_rate : 1.0f);
+    const float half = AUDIO_RESAMPLE_TAPS / 2;
+    for (int p = 0; p < AUDIO_RESAMPLE_PHASES; p++) {
+        float row[AUDIO_RESAMPLE_TAPS];
+        float sum = 0.0f;
+        for (int t = 0; t < AUDIO_RESAMPLE_TAPS; t++) {
+            // Tap t weighs the input (TAPS - 1 - t) samples before the newest one.
+            const float tau = (float)p / AUDIO_RESAMPLE_PHASES + (float)(AUDIO_RESAMPLE_TAPS - 1 - t) - half;
+            const float w = fabsf(tau) >= half ? 0.0f
+                            : 0.42f + 0.5f * cosf((float)M_PI * tau / half) + 0.08f * cosf(2.0f * (float)M_PI * tau / half);
+            row[t] = fc * sinc(fc * tau) * w;
+            sum += row[t];
+        }
+        // Unity DC gain in every phase, so the phase steps don't modulate the level.
+        for (int t = 0; t < AUDIO_RESAMPLE_TAPS; t++) {
+            const long q = lrintf(row[t] / sum * 32768.0f);
+            r->coef[p][t] = (int16_t)(q > INT16_MAX ? INT16_MAX : (q < INT16_MIN ? INT16_MIN : q));
+        }
+    }
+    audio_resampler_reset(r);
+    return ESP_OK;
+}
+
+void audio_resampler_reset(audio_resampler_t *r)
+{
+    memset(r->hist, 0, sizeof(r->hist));
+    r->head = 0;
+    r->pos = Q16_ONE; // the first output lines up with the first input sample
+    r->pos_rem = 0;
+}
+
+size_t audio_resample(audio_resampler_t *r, const int16_t *in, size_t n_in, size_t *used, int16_t *out, size_t cap)
+{
+    size_t i = 0, o = 0;
+    while (o < cap) {
+        if (r->pos < Q16_ONE) {
+            const int16_t *x = &r->hist[r->head]; // oldest .. newest
+            const int16_t *h = r->coef[r->pos >> (16 - AUDIO_RESAMPLE_PHASE_BITS)];
+            int32_t acc = 1 << 14;
+            for (int t = 0; t < AUDIO_RESAMPLE_TAPS; t++) acc += x[t] * h[t];
+            acc >>= 15;
+            out[o++] = (int16_t)(acc > INT16_MAX ? INT16_MAX : (acc < INT16_MIN ? INT16_MIN : acc));
+            r->pos += r->step;
+            r->pos_rem += r->step_rem;
+            if (r->pos_rem >= (uint32_t)r->out_rate) {
+                r->pos_rem -= (uint32_t)r->out_rate;
+                r->pos++;
+            }
+            continue;
+        }
+        if (i == n_in) break;
+        r->hist[r->head] = in[i];
+        r->hist[r->head + AUDIO_RESAMPLE_TAPS] = in[i];
+        r->head = (uint16_t)((r->head + 1) % AUDIO_RESAMPLE_TAPS);
+        r->pos -= Q16_ONE;
+        i++;
+    }
+    *used = i;
+    return o;
+}
+
+size_t audio_resample_out_len(int in_rate, int out_rate, size_t n_in)
+{
+    return (size_t)(((uint64_t)n_in * (uint32_t)out_rate + (uint32_t)in_rate / 2) / (uint32_t)in_rate);
+}
@@ -0,0 +1,127 @@
+#include "discovery.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "esp_log.h"
+
+#ifndef CONFIG_LITTLEAI_MDNS
+#define CONFIG_LITTLEAI_MDNS 0
+#endif
+
+#if CONFIG_LITTLEAI_MDNS
+#include "esp_app_desc.h"
+#include "esp_mac.h"
+#include "mdns.h"
+
+#include "audio_codec.h"
+#include "audio_resample.h"
+#include "pin_config.h"
+#include "udp_ctl.h"
+
+static const char *TAG = "discovery";
+
+#define DISCOVERY_SERVICE "_littleai"
+#define DISCOVERY_PROTO "_tcp"
+#define DISCOVERY_WS_PORT 8080
+#define DISCOVERY_AUDIO_PORT 8081
+// Bump when the WS API changes incompatibly, so hosts can skip devices they can't drive.
+#define DISCOVERY_PROTO_VERSION "1"
+
+// Lowercase `name`, keep [a-z0-9-] and append the last 3 MAC bytes, so a fleet flashed with
+// the same FACE_DEVICE_NAME still gets one hostname per device ("littleai-face-a1b2c3").
+static void make_hostname(const char *name, const uint8_t mac[6], char *out, size_t cap) {
+    size_t n = 0;
+    for (const char *p = name; *p && n + 8 < cap && n < 48; p++) {
+        const char ch = (char)tolower((unsigned char)*p);
+        if (isalnum((unsigned char)ch)) {
+            out[n++] = ch;
+        } else if (n > 0 && out[n - 1] != '-') {
+            out[n++] = '-';
+        }
+    }
+    if (n == 0) n = (size_t)snprintf(out, cap, "littleai");
+    if (out[n - 1] == '-') n--;
+    snprintf(out + n, cap - n, "-%02x%02x%02x", mac[3], mac[4], mac[5]);
+}
+
+esp_err_t discovery_start(const char *instance_name) {
+    if (!instance_name || !instance_name[0]) return ESP_ERR_INVALID_ARG;
+
+    uint8_t mac[6] = {0};
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+
+    char host[64];
+    make_hostname(instance_name, mac, host, sizeof(host));
+
+    esp_err_t err = mdns_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "mdns_init failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    err = mdns_hostname_set(host);
+    if (err == ESP_OK) err = mdns_instance_name_set(instance_name);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "mdns name setup failed: %s", esp_err_to_name(err));
+        mdns_free();
+        return err;
+    }
+
+    // TXT values are copied by mdns_service_add(), so stack buffers are fine.
+    char id[13];
+    snprintf(id, sizeof(id), "%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+    char codecs[32] = "";
+    static const audio_codec_t kCodecs[] = {AUDIO_CODEC_PCM16, AUDIO_CODEC_IMA_ADPCM, AUDIO_CODEC_OPUS};
+    for (size_t i = 0; i < sizeof(kCodecs) / sizeof(kCodecs[0]); i++) {
+        if (!audio_codec_supported(kCodecs[i])) continue;
+        const size_t len = strlen(codecs);
+        snprintf(codecs + len, sizeof(codecs) - len, "%s%s", len ? "," : "", audio_codec_name(kCodecs[i]));
+    }
+
+    char rates[24];
+    snprintf(rates, sizeof(rates), "%d-%d", AUDIO_RESAMPLE_MIN_RATE, AUDIO_RESAMPLE_MAX_RATE);
+    char panel[16];
+    snprintf(panel, sizeof(panel), "%dx%d", LCD_HRES, LCD_VRES);
+    char audio_port[8];
+    snprintf(audio_port, sizeof(audio_port), "%d", DISCOVERY_AUDIO_PORT);
+    char udp_port[8] = "";
+    const uint16_t udp = udp_ctl_port();
+    if (udp) snprintf(udp_port, sizeof(udp_port), "%u", udp);
+
+    mdns_txt_item_t txt[] = {
+        {"proto", DISCOVERY_PROTO_VERSION},
+        {"id", id},
+        {"ver", esp_app_get_description()->version},
+        {"path", "/ws"},
+        {"audio", audio_port},
+        {"codecs", codecs},
+        {"rates", rates},
+        {"caps", "face,rig,speech,lipsync,clips,touch,ota"},
+        {"panel", panel},
+        {"udp", udp_port}, // last: left out when the UDP channel is off
+    };
+    const size_t ntxt = sizeof(txt) / sizeof(txt[0]) - (udp ? 0 : 1);
+
+    err = mdns_service_add(instance_name, DISCOVERY_SERVICE, DISCOVERY_PROTO, DISCOVERY_WS_PORT, txt, ntxt);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "mdns_service_add failed: %s", esp_err_to_name(err));
+        mdns_free();
+        return err;
+    }
+
+    ESP_LOGI(TAG, "advertising \"%s\" as %s.local (%s.%s, port %d)", instance_name, host, DISCOVERY_SERVICE,
+             DISCOVERY_PROTO, DISCOVERY_WS_PORT);
+    return ESP_OK;
+}
+
+#else
+
+esp_err_t discovery_start(const char *instance_name) {
+    (void)instance_name;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
@@ -2,6 +2,12 @@
 
 #include <string.h>
 
+#include "freertos/FreeRTOS.h"
+
+// Keeps a publish from being preempted (or interleaved with another one) half way through,
+// so a reader on either core spins for at most one copy.
+static portMUX_TYPE s_publish_lock = portMUX_INITIALIZER_UNLOCKED;
+
 void face_state_init(face_state_t *s) {
     memset(s, 0, sizeof(*s));
     s->expression = EXPR_NEUTRAL;
@@ -18,3 +24,121 @@ void face_state_init(face_state_t *s) {
     strcpy(s->viseme, "rest");
     s->viseme_weight = 0.0f;
 }
+
+uint8_t face_state_expire(face_state_t *s, uint32_t now_ms) {
+    uint8_t expired = 0;
+    if (s->caption_until_ms && now_ms > s->caption_until_ms) {
+        s->caption[0] = 0;
+        s->caption_until_ms = 0;
+        expired |= FACE_TTL_CAPTION;
+    }
+    if (s->viseme_until_ms && now_ms > s->viseme_until_ms) {
+        strcpy(s->viseme, "rest");
+        s->viseme_weight = 0.0f;
+        s->viseme_until_ms = 0;
+        expired |= FACE_TTL_VISEME;
+    }
+    if (s->blink_until_ms && now_ms >= s->blink_until_ms) {
+        s->blink_until_ms = 0;
+        expired |= FACE_TTL_BLINK;
+    }
+    return expired;
+}
+
+static float *channel_field(face_state_t *s, face_channel_t ch) {
+    switch (ch) {
+        case FACE_CH_GAZE_X: return &s->gaze_x;
+        case FACE_CH_GAZE_Y: return &s->gaze_y;
+        case FACE_CH_EYE_OPEN: return &s->eye_open;
+        case FACE_CH_MOUTH_OPEN: return &s->mouth_open;
+        default: return NULL;
+    }
+}
+
+static float ease(face_ease_t e, float t) {
+    switch (e) {
+        case FACE_EASE_IN: return t * t;
+        case FACE_EASE_OUT: return t * (2.0f - t);
+        case FACE_EASE_IN_OUT: return t * t * (3.0f - 2.0f * t);
+        case FACE_EASE_STEP: return 0.0f;
+        default: return t;
+    }
+}
+
+// Track value at now_ms; *done is set once the last key has been reached.
+static float anim_value(const face_anim_t *a, uint32_t now_ms, bool *done) {
+    uint32_t t = now_ms > a->start_ms ? now_ms - a->start_ms : 0;
+    float from = a->from;
+    for (int k = 0; k < a->nkeys; k++) {
+        const face_anim_key_t *key = &a->keys[k];
+        if (t < key->duration_ms) {
+            *done = false;
+            return from + (key->value - from) * ease((face_ease_t)key->ease, (float)t / (float)key->duration_ms);
+        }
+        t -= key->duration_ms;
+        from = key->value;
+    }
+    *done = true;
+    return from;
+}
+
+bool face_anim_start(face_state_t *s, face_channel_t ch, const face_anim_key_t *keys, int nkeys, uint32_t now_ms) {
+    float *field = channel_field(s, ch);
+    if (!field || nkeys <= 0 || nkeys > FACE_ANIM_MAX_KEYS) return false;
+
+    face_anim_t *a = &s->anim[ch];
+    bool done = true;
+    const float from = a->start_ms ? anim_value(a, now_ms, &done) : *field;
+
+    a->start_ms = now_ms ? now_ms : 1;
+    a->from = from;
+    a->nkeys = (uint8_t)nkeys;
+    memcpy(a->keys, keys, (size_t)nkeys * sizeof(keys[0]));
+    *field = keys[nkeys - 1].value;
+
+    if (ch == FACE_CH_EYE_OPEN) s->eye_open_override = true;
+    if (ch == FACE_CH_MOUTH_OPEN) s->mouth_open_override = true;
+    return true;
+}
+
+bool face_state_animate(face_state_t *s, uint32_t now_ms) {
+    bool running = false;
+    for (int ch = 0; ch < FACE_CH_COUNT; ch++) {
+        face_anim_t *a = &s->anim[ch];
+        if (!a->start_ms) continue;
+        bool done = false;
+        const float v = anim_value(a, now_ms, &done);
+        if (done) {
+            a->start_ms = 0;
+        } else {
+            *channel_field(s, (face_channel_t)ch) = v;
+            running = true;
+        }
+    }
+    return running;
+}
+
+void face_store_init(face_store_t *s, const face_state_t *initial) {
+    s->seq = 0;
+    s->state = *initial;
+}
+
+void face_store_publish(face_store_t *s, const face_state_t *src) {
+    portENTER_CRITICAL(&s_publish_lock);
+    const uint32_t seq = s->seq;
+    __atomic_store_n(&s->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&s->state, src, sizeof(s->state));
+    __atomic_store_n(&s->seq, seq + 2, __ATOMIC_RELEASE);
+    portEXIT_CRITICAL(&s_publish_lock);
+}
+
+void face_store_read(const face_store_t *s, face_state_t *dst) {
+    for (;;) {
+        const uint32_t seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) continue;
+        memcpy(dst, &s->state, sizeof(*dst));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&s->seq, __ATOMIC_RELAXED) == seq) return;
+    }
+}
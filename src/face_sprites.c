@@ -0,0 +1,110 @@
+#include "face_sprites.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+static const char *TAG = "face_sprites";
+
+// Eyes and mouth shapes at FACE_SPRITE_LEVELS each, plus a few fixed ones.
+#define FACE_SPRITE_MAX 128
+
+typedef struct {
+    uint16_t w;
+    uint16_t h;
+    uint16_t radius;
+    uint8_t border_w;
+    bool alpha;
+    lv_color_t fill;    // lv_color_t is a plain integer union: no padding, memcmp-safe
+    lv_color_t border;
+} sprite_key_t;
+
+typedef struct {
+    sprite_key_t key;
+    lv_img_dsc_t dsc;
+} sprite_t;
+
+static sprite_t s_sprites[FACE_SPRITE_MAX];
+static int s_count;
+static uint32_t s_bytes;
+static bool s_full_warned;
+static lv_obj_t *s_canvas;
+
+void face_sprites_init(lv_obj_t *parent) {
+    if (s_canvas) return;
+    s_canvas = lv_canvas_create(parent);
+    lv_obj_add_flag(s_canvas, LV_OBJ_FLAG_HIDDEN);
+}
+
+static const lv_img_dsc_t *render(sprite_t *sp) {
+    const sprite_key_t *k = &sp->key;
+    const lv_img_cf_t cf = k->alpha ? LV_IMG_CF_TRUE_COLOR_ALPHA : LV_IMG_CF_TRUE_COLOR;
+    const uint32_t size = k->alpha ? LV_CANVAS_BUF_SIZE_TRUE_COLOR_ALPHA(k->w, k->h)
+                                   : LV_CANVAS_BUF_SIZE_TRUE_COLOR(k->w, k->h);
+
+    uint8_t *buf = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!buf) {
+        ESP_LOGW(TAG, "no PSRAM for %ux%u sprite", k->w, k->h);
+        return NULL;
+    }
+
+    lv_canvas_set_buffer(s_canvas, buf, k->w, k->h, cf);
+    lv_canvas_fill_bg(s_canvas, lv_color_black(), k->alpha ? LV_OPA_TRANSP : LV_OPA_COVER);
+
+    lv_draw_rect_dsc_t d;
+    lv_draw_rect_dsc_init(&d);
+    d.radius = k->radius;
+    d.bg_color = k->fill;
+    d.bg_opa = LV_OPA_COVER;
+    d.border_width = k->border_w;
+    d.border_color = k->border;
+    d.border_opa = LV_OPA_COVER;
+    lv_canvas_draw_rect(s_canvas, 0, 0, k->w, k->h, &d);
+
+    sp->dsc.header.always_zero = 0;
+    sp->dsc.header.cf = cf;
+    sp->dsc.header.w = k->w;
+    sp->dsc.header.h = k->h;
+    sp->dsc.data_size = size;
+    sp->dsc.data = buf;
+    s_bytes += size;
+    return &sp->dsc;
+}
+
+const lv_img_dsc_t *face_sprite_rrect(const face_sprite_style_t *style, int w, int h, int radius) {
+    if (!s_canvas || w <= 0 || h <= 0) return NULL;
+    if (radius > h / 2) radius = h / 2;
+    if (radius > w / 2) radius = w / 2;
+
+    const sprite_key_t key = {
+        .w = (uint16_t)w,
+        .h = (uint16_t)h,
+        .radius = (uint16_t)radius,
+        .border_w = style->border_w,
+        .alpha = style->alpha,
+        .fill = style->fill,
+        .border = style->border_w ? style->border : lv_color_black(),
+    };
+    for (int i = 0; i < s_count; i++) {
+        if (memcmp(&s_sprites[i].key, &key, sizeof(key)) == 0) return &s_sprites[i].dsc;
+    }
+
+    if (s_count >= FACE_SPRITE_MAX) {
+        if (!s_full_warned) ESP_LOGW(TAG, "sprite cache full (%d)", FACE_SPRITE_MAX);
+        s_full_warned = true;
+        return NULL;
+    }
+
+    sprite_t *sp = &s_sprites[s_count];
+    memset(sp, 0, sizeof(*sp));
+    sp->key = key;
+    const lv_img_dsc_t *dsc = render(sp);
+    if (dsc) s_count++;
+    return dsc;
+}
+
+void face_sprites_usage(uint32_t *count, uint32_t *bytes) {
+    if (count) *count = (uint32_t)s_count;
+    if (bytes) *bytes = s_bytes;
+}
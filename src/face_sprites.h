@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Cache of pre-rendered rounded-rectangle sprites for the face. LVGL's anti-aliased rounded
+// rect (with border) is the most expensive thing it draws; blitting a cached image of the same
+// shape costs a straight copy. Sprites are rendered lazily on first use into PSRAM with LVGL's
+// own rasterizer (via a hidden canvas), so they look exactly like the objects they replace.
+
+// Continuous shape parameters (eye / mouth openness) are quantized to this many steps so the
+// number of distinct sprites stays bounded.
+#define FACE_SPRITE_LEVELS 32
+
+typedef struct {
+    lv_color_t fill;
+    lv_color_t border;
+    uint8_t border_w;
+    bool alpha;        // keep transparent corners (for shapes drawn over other shapes)
+} face_sprite_style_t;
+
+// Create the render canvas under `parent`. Call with the LVGL lock held.
+void face_sprites_init(lv_obj_t *parent);
+
+// w x h rounded rect with corner radius `radius` over a black (or, with style->alpha,
+// transparent) background. Returns NULL if the cache is full or out of memory.
+const lv_img_dsc_t *face_sprite_rrect(const face_sprite_style_t *style, int w, int h, int radius);
+
+static inline float face_sprite_quantize(float v01) {
+    if (v01 <= 0.0f) return 0.0f;
+    if (v01 >= 1.0f) return 1.0f;
+    return (float)(int)(v01 * (FACE_SPRITE_LEVELS - 1) + 0.5f) / (FACE_SPRITE_LEVELS - 1);
+}
+
+// Number of sprites and bytes of PSRAM held by the cache.
+void face_sprites_usage(uint32_t *count, uint32_t *bytes);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,132 @@
+#include "i2c_bus.h"
+
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+
+#include "pin_config.h"
+
+static const char *TAG = "i2c_bus";
+
+#ifndef CONFIG_LITTLEAI_I2C_CLK_HZ
+#define CONFIG_LITTLEAI_I2C_CLK_HZ 400000
+#endif
+
+#define I2C_BUS_PORT I2C_NUM_0
+#define I2C_BUS_RETRIES 2
+
+static SemaphoreHandle_t s_mux = NULL;
+static i2c_bus_stats_t s_stats[I2C_DEV_COUNT];
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const kDevNames[I2C_DEV_COUNT] = {
+    [I2C_DEV_TOUCH] = "touch",
+    [I2C_DEV_CODEC] = "codec",
+    [I2C_DEV_EXPANDER] = "expander",
+    [I2C_DEV_SCAN] = "scan",
+};
+
+esp_err_t i2c_bus_init(void)
+{
+    if (s_mux) return ESP_OK;
+
+    // The ES8311, FT3168 and TCA9554 all support 400 kHz fast mode.
+    const i2c_config_t conf = {
+        .mode = I2C_MODE_MASTER,
+        .sda_io_num = I2C_SDA,
+        .scl_io_num = I2C_SCL,
+        .sda_pullup_en = GPIO_PULLUP_ENABLE,
+        .scl_pullup_en = GPIO_PULLUP_ENABLE,
+        .master.clk_speed = CONFIG_LITTLEAI_I2C_CLK_HZ,
+    };
+    ESP_RETURN_ON_ERROR(i2c_param_config(I2C_BUS_PORT, &conf), TAG, "i2c_param_config failed");
+    ESP_RETURN_ON_ERROR(i2c_driver_install(I2C_BUS_PORT, conf.mode, 0, 0, 0), TAG, "i2c_driver_install failed");
+
+    s_mux = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(s_mux, ESP_ERR_NO_MEM, TAG, "bus mutex alloc failed");
+
+    ESP_LOGI(TAG, "I2C%d at %d Hz", (int)I2C_BUS_PORT, CONFIG_LITTLEAI_I2C_CLK_HZ);
+    return ESP_OK;
+}
+
+i2c_port_t i2c_bus_port(void)
+{
+    return I2C_BUS_PORT;
+}
+
+uint32_t i2c_bus_clk_hz(void)
+{
+    return CONFIG_LITTLEAI_I2C_CLK_HZ;
+}
+
+static esp_err_t bus_run(i2c_bus_dev_t dev, esp_err_t (*fn)(void *ctx), void *ctx, uint32_t timeout_ms,
+                        int max_retries)
+{
+    if ((unsigned)dev >= I2C_DEV_COUNT || !fn) return ESP_ERR_INVALID_ARG;
+    if (!s_mux) return ESP_ERR_INVALID_STATE;
+
+    const int64_t t0 = esp_timer_get_time();
+    if (xSemaphoreTake(s_mux, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        portENTER_CRITICAL(&s_stats_lock);
+        s_stats[dev].lock_timeouts++;
+        portEXIT_CRITICAL(&s_stats_lock);
+        return ESP_ERR_TIMEOUT;
+    }
+    const uint32_t waited = (uint32_t)(esp_timer_get_time() - t0);
+
+    esp_err_t err = fn(ctx);
+    int retries = 0;
+    while (err != ESP_OK && retries < max_retries) {
+        retries++;
+        err = fn(ctx);
+    }
+    xSemaphoreGive(s_mux);
+
+    portENTER_CRITICAL(&s_stats_lock);
+    i2c_bus_stats_t *st = &s_stats[dev];
+    if (err == ESP_OK) {
+        st->ok++;
+    } else {
+        st->errors++;
+    }
+    st->retries += (uint32_t)retries;
+    if (waited > st->max_wait_us) st->max_wait_us = waited;
+    portEXIT_CRITICAL(&s_stats_lock);
+    return err;
+}
+
+esp_err_t i2c_bus_run(i2c_bus_dev_t dev, esp_err_t (*fn)(void *ctx), void *ctx, uint32_t timeout_ms)
+{
+    return bus_run(dev, fn, ctx, timeout_ms, 0);
+}
+
+esp_err_t i2c_bus_xfer(i2c_bus_dev_t dev, esp_err_t (*fn)(void *ctx), void *ctx, uint32_t timeout_ms)
+{
+    return bus_run(dev, fn, ctx, timeout_ms, I2C_BUS_RETRIES);
+}
+
+void i2c_bus_get_stats(i2c_bus_dev_t dev, i2c_bus_stats_t *out)
+{
+    if ((unsigned)dev >= I2C_DEV_COUNT || !out) return;
+    portENTER_CRITICAL(&s_stats_lock);
+    *out = s_stats[dev];
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+void i2c_bus_reset_stats(void)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    memset(s_stats, 0, sizeof(s_stats));
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+const char *i2c_bus_dev_name(i2c_bus_dev_t dev)
+{
+    return (unsigned)dev < I2C_DEV_COUNT ? kDevNames[dev] : "unknown";
+}
@@ -8,6 +8,7 @@
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_err.h"
+#include "esp_attr.h"
 
 #include "driver/gpio.h"
 #include "driver/i2c.h"
@@ -28,7 +29,16 @@
 #include "wifi_manager.h"
 #include "face_protocol.h"
 #include "ws_server.h"
+#include "udp_ctl.h"
+#include "discovery.h"
 #include "audio.h"
+#include "perf.h"
+#include "face_sprites.h"
+#include "touch_gesture.h"
+#include "i2c_bus.h"
+#include "ota.h"
+#include "assets.h"
+#include "assets_lv.h"
 
 static const char *TAG = "littleAI";
 
@@ -39,8 +49,8 @@ static const char *TAG = "littleAI";
 // LVGL locking
 static SemaphoreHandle_t s_lvgl_mux;
 
-// Face state locking (used by WS server + LVGL task)
-static SemaphoreHandle_t s_face_mux;
+// Face state, published by the WS server and read lock-free by the LVGL task
+static face_store_t s_face_store;
 
 static esp_lcd_panel_handle_t s_panel = NULL;
 static esp_lcd_panel_io_handle_t s_io = NULL;
@@ -49,6 +59,19 @@ static esp_lcd_touch_handle_t s_touch = NULL;
 static lv_disp_t *s_disp = NULL;
 static lv_indev_t *s_indev = NULL;
 
+// Render task; sleeps on its task notification until there is something to draw.
+static TaskHandle_t s_lvgl_task = NULL;
+static volatile bool s_touch_down = false;
+static volatile bool s_touch_irq = false; // controller raised INT since the last read
+static touch_gesture_state_t s_gesture;
+
+// Flush accounting for the frame being sent (see lvgl_flush_cb / notify_flush_ready).
+static int64_t s_flush_start_us;
+static uint32_t s_frame_bytes;
+static uint32_t s_frame_areas;
+static uint32_t s_frames_flushed;
+
+// Renderer's snapshot of s_face_store, with expired TTLs cleared (renderer-local).
 static face_state_t s_face;
 
 // LVGL objects
@@ -64,9 +87,13 @@ static lv_obj_t *o_mouth_bar;
 static lv_obj_t *o_mouth;
 static lv_obj_t *o_caption;
 
+// Face palette
+#define FACE_EYE_FILL   0x0B1F4A // very dark blue
+#define FACE_EYE_EDGE   0x1D4ED8 // blue edge
+#define FACE_ACCENT     0x60A5FA // lighter blue accent
+
 // Display params
 #define LCD_HOST SPI2_HOST
-#define TOUCH_HOST I2C_NUM_0
 
 #if CONFIG_LV_COLOR_DEPTH == 32
 #define LCD_BIT_PER_PIXEL (24)
@@ -76,7 +103,65 @@ static lv_obj_t *o_caption;
 
 // Safer for SPI DMA: keep buffers small enough to fit in internal DMA-capable RAM
 #define LVGL_BUF_HEIGHT (LCD_VRES / 8)
+
+#if CONFIG_LITTLEAI_LCD_FB_PSRAM
+#if LCD_BIT_PER_PIXEL != 16
+#error "CONFIG_LITTLEAI_LCD_FB_PSRAM requires 16-bit LVGL colour"
+#endif
+#ifndef CONFIG_LITTLEAI_LCD_BOUNCE_LINES
+#define CONFIG_LITTLEAI_LCD_BOUNCE_LINES 16
+#endif
+#define LCD_BOUNCE_LINES CONFIG_LITTLEAI_LCD_BOUNCE_LINES
+
+// The framebuffer lives in PSRAM, which the QSPI DMA can't read reliably, so dirty rows are
+// copied into one of two internal DMA buffers and sent from there while the other is refilled.
+static lv_color_t *s_bounce[2];
+static SemaphoreHandle_t s_bounce_free;     // counting: bounce buffers not in flight
+// Transfers queued but not done yet. LVGL is released as soon as a frame's rows are copied, so
+// the next frame's transfers can be queued while these are still in flight.
+static uint32_t s_bounce_pending;
+static portMUX_TYPE s_bounce_lock = portMUX_INITIALIZER_UNLOCKED;
+// Next bounce buffer to fill. Transfers complete in order, so once s_bounce_free is taken this
+// one (used two transfers ago) is free, also across frames.
+static int s_bounce_next;
+
+#ifndef CONFIG_LITTLEAI_LCD_MERGE_SLACK_PX
+#define CONFIG_LITTLEAI_LCD_MERGE_SLACK_PX 8192
+#endif
+#define LCD_MERGE_SLACK_PX CONFIG_LITTLEAI_LCD_MERGE_SLACK_PX
+
+#define LCD_MAX_TRANSFER_BYTES (LCD_HRES * LCD_BOUNCE_LINES * LCD_BIT_PER_PIXEL / 8)
+#else
+#define LCD_MAX_TRANSFER_BYTES (LCD_HRES * LVGL_BUF_HEIGHT * LCD_BIT_PER_PIXEL / 8)
+#endif
 #define LVGL_TICK_PERIOD_MS 2
+#ifndef CONFIG_LITTLEAI_LVGL_TASK_CORE
+#define CONFIG_LITTLEAI_LVGL_TASK_CORE 1
+#endif
+#ifndef CONFIG_LITTLEAI_LVGL_TASK_PRIORITY
+#define CONFIG_LITTLEAI_LVGL_TASK_PRIORITY 4
+#endif
+#define LVGL_TASK_CORE (CONFIG_LITTLEAI_LVGL_TASK_CORE < 0 ? tskNO_AFFINITY : CONFIG_LITTLEAI_LVGL_TASK_CORE)
+
+#ifndef CONFIG_LITTLEAI_IO_EXPANDER_RESET_MS
+#define CONFIG_LITTLEAI_IO_EXPANDER_RESET_MS 20
+#endif
+
+// Boot phase end times (esp_timer, i.e. since the app started), logged as one breakdown line.
+// Only app_main writes them; the parallel network bring-up reports its own duration.
+#define BOOT_MAX_MARKS 12
+static struct {
+    const char *name;
+    int64_t us;
+} s_boot_marks[BOOT_MAX_MARKS];
+static int s_boot_nmarks;
+static int64_t s_wifi_init_us;             // written by net_boot_task before it gives s_net_ready
+static SemaphoreHandle_t s_net_ready;
+
+// Longest the render task sleeps with nothing scheduled (it is woken early by WS commands and touch).
+#define LVGL_IDLE_WAIT_MS 1000
+// Render period while an on-device animation (WS "animate") is running.
+#define FACE_ANIM_FRAME_MS 16
 
 static const sh8601_lcd_init_cmd_t lcd_init_cmds[] = {
     {0x11, (uint8_t[]){0x00}, 0, 120},
@@ -92,7 +177,10 @@ static const sh8601_lcd_init_cmd_t lcd_init_cmds[] = {
 
 static bool lvgl_lock(int timeout_ms) {
     const TickType_t ticks = timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
-    return xSemaphoreTake(s_lvgl_mux, ticks) == pdTRUE;
+    const int64_t t0 = esp_timer_get_time();
+    const bool locked = xSemaphoreTake(s_lvgl_mux, ticks) == pdTRUE;
+    perf_record_since(PERF_LVGL_LOCK, t0);
+    return locked;
 }
 
 static void lvgl_unlock(void) {
@@ -101,10 +189,148 @@ static void lvgl_unlock(void) {
 
 static bool notify_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx) {
     lv_disp_drv_t *disp_driver = (lv_disp_drv_t *)user_ctx;
+#if CONFIG_LITTLEAI_LCD_FB_PSRAM
+    (void)disp_driver; // lvgl_flush_cb() already released LVGL
+    BaseType_t hp_woken = pdFALSE;
+    xSemaphoreGiveFromISR(s_bounce_free, &hp_woken);
+    portENTER_CRITICAL_ISR(&s_bounce_lock);
+    const bool idle = --s_bounce_pending == 0;
+    portEXIT_CRITICAL_ISR(&s_bounce_lock);
+    if (idle) perf_record_since(PERF_FLUSH_DMA, s_flush_start_us);
+    return hp_woken == pdTRUE;
+#else
+    perf_record_since(PERF_FLUSH_DMA, s_flush_start_us);
     lv_disp_flush_ready(disp_driver);
     return false;
+#endif
+}
+
+// SH8601 column/row windows must start on an even pixel and span an even count.
+static void lvgl_rounder_cb(lv_disp_drv_t *drv, lv_area_t *area) {
+    area->x1 &= ~1;
+    area->y1 &= ~1;
+    area->x2 |= 1;
+    area->y2 |= 1;
+}
+
+static inline uint32_t area_px(const lv_area_t *a) {
+    return (uint32_t)(a->x2 - a->x1 + 1) * (uint32_t)(a->y2 - a->y1 + 1);
+}
+
+static void account_flush(const lv_area_t *a) {
+    s_frame_bytes += area_px(a) * LCD_BIT_PER_PIXEL / 8;
+    s_frame_areas++;
+}
+
+static void account_frame_done(void) {
+    perf_record(PERF_FLUSH_BYTES, s_frame_bytes);
+    perf_record(PERF_FLUSH_AREAS, s_frame_areas);
+    s_frame_bytes = 0;
+    s_frame_areas = 0;
+    s_frames_flushed++;
+}
+
+#if CONFIG_LITTLEAI_LCD_FB_PSRAM
+// Dirty areas of the frame being flushed. In direct mode every pixel of the frame is valid in
+// the PSRAM buffer, so areas can be merged at flush time without re-rendering anything.
+#define LCD_DIRTY_MAX 16
+static lv_area_t s_dirty[LCD_DIRTY_MAX];
+static int s_ndirty;
+
+static void dirty_add(const lv_area_t *a) {
+    if (s_ndirty < LCD_DIRTY_MAX) {
+        s_dirty[s_ndirty++] = *a;
+        return;
+    }
+    lv_area_t *u = &s_dirty[LCD_DIRTY_MAX - 1];
+    if (a->x1 < u->x1) u->x1 = a->x1;
+    if (a->y1 < u->y1) u->y1 = a->y1;
+    if (a->x2 > u->x2) u->x2 = a->x2;
+    if (a->y2 > u->y2) u->y2 = a->y2;
+}
+
+// Merge pairs whose bounding box costs at most LCD_MERGE_SLACK_PX more pixels than the two
+// areas do separately (e.g. both pupils moving on the same rows): one window instead of two
+// CASET/RASET/RAMWR sequences. Overlapping pairs always merge.
+static void dirty_merge(void) {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (int i = 0; i < s_ndirty && !merged; i++) {
+            for (int j = i + 1; j < s_ndirty && !merged; j++) {
+                const lv_area_t *a = &s_dirty[i];
+                const lv_area_t *b = &s_dirty[j];
+                lv_area_t u = {
+                    .x1 = a->x1 < b->x1 ? a->x1 : b->x1,
+                    .y1 = a->y1 < b->y1 ? a->y1 : b->y1,
+                    .x2 = a->x2 > b->x2 ? a->x2 : b->x2,
+                    .y2 = a->y2 > b->y2 ? a->y2 : b->y2,
+                };
+                if (area_px(&u) > area_px(a) + area_px(b) + LCD_MERGE_SLACK_PX) continue;
+                s_dirty[i] = u;
+                s_dirty[j] = s_dirty[--s_ndirty];
+                merged = true;
+            }
+        }
+    }
+}
+
+static uint32_t bounce_chunks(const lv_area_t *a) {
+    return (uint32_t)(a->y2 - a->y1 + LCD_BOUNCE_LINES) / LCD_BOUNCE_LINES;
 }
 
+// Copy `area` of the PSRAM frame `fb` out through the bounce buffers, one transfer per
+// LCD_BOUNCE_LINES rows. Returns once every row is copied (LVGL may draw into fb again);
+// notify_flush_ready() hands each bounce buffer back when its transfer is done.
+static void flush_via_bounce(esp_lcd_panel_handle_t panel, const lv_area_t *area, const lv_color_t *fb, int *buf) {
+    const int w = area->x2 - area->x1 + 1;
+    for (int y = area->y1; y <= area->y2; y += LCD_BOUNCE_LINES) {
+        int n = area->y2 - y + 1;
+        if (n > LCD_BOUNCE_LINES) n = LCD_BOUNCE_LINES;
+
+        xSemaphoreTake(s_bounce_free, portMAX_DELAY);
+        lv_color_t *dst = s_bounce[*buf];
+        const lv_color_t *src = fb + (size_t)y * LCD_HRES + area->x1;
+        for (int r = 0; r < n; r++) {
+            memcpy(dst + (size_t)r * w, src + (size_t)r * LCD_HRES, (size_t)w * sizeof(lv_color_t));
+        }
+        esp_lcd_panel_draw_bitmap(panel, area->x1, y, area->x2 + 1, y + n, dst);
+        *buf ^= 1;
+    }
+}
+
+// Direct mode: collect the frame's dirty areas and send them, merged, after the last one.
+// LVGL is released once every row is in a bounce buffer or on the wire, so it renders the
+// next frame while the tail of this one is still being sent.
+static void lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map) {
+    dirty_add(area);
+    if (!lv_disp_flush_is_last(drv)) {
+        lv_disp_flush_ready(drv);
+        return;
+    }
+    dirty_merge();
+
+    uint32_t chunks = 0;
+    for (int i = 0; i < s_ndirty; i++) chunks += bounce_chunks(&s_dirty[i]);
+    // flush_dma: from the first chunk queued while the DMA was idle until it is idle again.
+    const int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_bounce_lock);
+    if (s_bounce_pending == 0) s_flush_start_us = now_us;
+    s_bounce_pending += chunks;
+    portEXIT_CRITICAL(&s_bounce_lock);
+
+    esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t)drv->user_data;
+    for (int i = 0; i < s_ndirty; i++) {
+        account_flush(&s_dirty[i]);
+        flush_via_bounce(panel_handle, &s_dirty[i], color_map, &s_bounce_next);
+    }
+    s_ndirty = 0;
+    account_frame_done();
+    lv_disp_flush_ready(drv);
+}
+#else
+// The draw buffer holds just this area, so there is nothing to merge with, and it is never larger
+// than LCD_MAX_TRANSFER_BYTES, so the whole area goes out as one transfer.
 static void lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map) {
     esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t)drv->user_data;
     const int offsetx1 = area->x1;
@@ -129,15 +355,51 @@ static void lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t
     }
 #endif
 
+    account_flush(area);
+    if (lv_disp_flush_is_last(drv)) account_frame_done();
+
+    s_flush_start_us = esp_timer_get_time();
     esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, color_map);
 }
+#endif
+
+// Wake the render task: face state changed or a touch interrupt fired.
+static void lvgl_wake(void) {
+    if (s_lvgl_task) xTaskNotifyGive(s_lvgl_task);
+}
+
+static void IRAM_ATTR touch_isr_cb(esp_lcd_touch_handle_t tp) {
+    BaseType_t hp_woken = pdFALSE;
+    s_touch_irq = true;
+    if (s_lvgl_task) vTaskNotifyGiveFromISR(s_lvgl_task, &hp_woken);
+    portYIELD_FROM_ISR(hp_woken);
+}
+
+static esp_err_t touch_read(void *tp) {
+    return esp_lcd_touch_read_data((esp_lcd_touch_handle_t)tp);
+}
 
 static void lvgl_touch_cb(lv_indev_drv_t *drv, lv_indev_data_t *data) {
     esp_lcd_touch_handle_t tp = (esp_lcd_touch_handle_t)drv->user_data;
-    uint16_t x, y;
+    uint16_t x = 0, y = 0;
     uint8_t cnt = 0;
 
-    esp_lcd_touch_read_data(tp);
+    // Only talk to the controller (on the I2C bus shared with the codec) after it raised INT,
+    // or while a finger is down so movement and the release are seen.
+    if (!s_touch_irq && !s_touch_down) {
+        data->state = LV_INDEV_STATE_RELEASED;
+        return;
+    }
+    // Clear before reading so an INT that fires during the transfer is not lost. If the read
+    // fails (bus busy behind a codec write, or an I2C error) mark the IRQ pending again and
+    // retry on the next indev read, keeping the last reported state meanwhile.
+    s_touch_irq = false;
+    if (i2c_bus_xfer(I2C_DEV_TOUCH, touch_read, tp, 5) != ESP_OK) {
+        s_touch_irq = true;
+        data->state = s_touch_down ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+        return;
+    }
+
     bool pressed = esp_lcd_touch_get_coordinates(tp, &x, &y, NULL, &cnt, 1);
     if (pressed && cnt > 0) {
         data->point.x = x;
@@ -146,11 +408,56 @@ static void lvgl_touch_cb(lv_indev_drv_t *drv, lv_indev_data_t *data) {
     } else {
         data->state = LV_INDEV_STATE_RELEASED;
     }
+    s_touch_down = data->state == LV_INDEV_STATE_PRESSED;
+
+    touch_gesture_t g;
+    if (touch_gesture_feed(&s_gesture, s_touch_down, x, y, (uint32_t)(esp_timer_get_time() / 1000), &g)) {
+        ws_server_notify_touch(&g);
+    }
 }
 
+#if !CONFIG_LV_TICK_CUSTOM
 static void lvgl_tick(void *arg) {
     lv_tick_inc(LVGL_TICK_PERIOD_MS);
 }
+#endif
+
+// Rounded-rect face parts. With CONFIG_LITTLEAI_FACE_SPRITES they are lv_img objects showing a
+// cached pre-rendered sprite (see face_sprites.h); otherwise styled lv_obj rectangles.
+static lv_obj_t *create_rrect(lv_obj_t *parent, const face_sprite_style_t *st) {
+#if CONFIG_LITTLEAI_FACE_SPRITES
+    return lv_img_create(parent);
+#else
+    lv_obj_t *o = lv_obj_create(parent);
+    lv_obj_clear_flag(o, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_bg_color(o, st->fill, 0);
+    lv_obj_set_style_bg_opa(o, LV_OPA_COVER, 0);
+    lv_obj_set_style_border_width(o, st->border_w, 0);
+    lv_obj_set_style_border_color(o, st->border, 0);
+    return o;
+#endif
+}
+
+static void set_rrect(lv_obj_t *o, const face_sprite_style_t *st, int w, int h, int radius) {
+#if CONFIG_LITTLEAI_FACE_SPRITES
+    // On a cache miss that can't be filled (PSRAM exhausted) the previous sprite stays up.
+    const lv_img_dsc_t *img = face_sprite_rrect(st, w, h, radius);
+    if (img) lv_img_set_src(o, img);
+#else
+    lv_obj_set_size(o, w, h);
+    lv_obj_set_style_radius(o, radius, 0);
+#endif
+}
+
+static face_sprite_style_t s_eye_style;
+static face_sprite_style_t s_pupil_style;
+static face_sprite_style_t s_bar_style; // blink lines + mouth bar
+
+// Text font from the asset pack if it has one, else the built-in Montserrat.
+static const lv_font_t *ui_font(const char *asset) {
+    const lv_font_t *f = assets_lv_font(asset);
+    return f ? f : &lv_font_montserrat_16;
+}
 
 static void create_face_ui(void) {
     lv_obj_t *scr = lv_scr_act();
@@ -164,9 +471,25 @@ static void create_face_ui(void) {
     lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
     lv_obj_set_style_bg_opa(scr, LV_OPA_COVER, 0);
 
-    const lv_color_t eye_fill = lv_color_hex(0x0B1F4A);   // very dark blue
-    const lv_color_t eye_edge = lv_color_hex(0x1D4ED8);   // blue edge
-    const lv_color_t accent   = lv_color_hex(0x60A5FA);   // lighter blue accent
+    s_eye_style = (face_sprite_style_t){
+        .fill = lv_color_hex(FACE_EYE_FILL),
+        .border = lv_color_hex(FACE_EYE_EDGE),
+        .border_w = 3,
+    };
+    // pupils sit on the eyes, so keep their corners transparent
+    s_pupil_style = (face_sprite_style_t){
+        .fill = lv_color_black(),
+        .border = lv_color_hex(FACE_ACCENT), // a subtle ring so the pupil reads against very dark blue
+        .border_w = 2,
+        .alpha = true,
+    };
+    s_bar_style = (face_sprite_style_t){
+        .fill = lv_color_hex(FACE_EYE_EDGE),
+    };
+
+#if CONFIG_LITTLEAI_FACE_SPRITES
+    face_sprites_init(scr);
+#endif
 
     int eye_w = 120;
     int eye_h = 80;
@@ -174,50 +497,26 @@ static void create_face_ui(void) {
     int pupil_r = 14;
     int eye_dx = 100;
 
-    o_left_eye = lv_obj_create(scr);
-    lv_obj_clear_flag(o_left_eye, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_size(o_left_eye, eye_w, eye_h);
-    lv_obj_set_style_radius(o_left_eye, eye_r, 0);
-    lv_obj_set_style_bg_color(o_left_eye, eye_fill, 0);
-    lv_obj_set_style_bg_opa(o_left_eye, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_width(o_left_eye, 3, 0);
-    lv_obj_set_style_border_color(o_left_eye, eye_edge, 0);
+    o_left_eye = create_rrect(scr, &s_eye_style);
+    set_rrect(o_left_eye, &s_eye_style, eye_w, eye_h, eye_r);
     lv_obj_set_pos(o_left_eye, cx - eye_dx - eye_w / 2, cy - eye_h / 2);
 
-    o_right_eye = lv_obj_create(scr);
-    lv_obj_clear_flag(o_right_eye, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_size(o_right_eye, eye_w, eye_h);
-    lv_obj_set_style_radius(o_right_eye, eye_r, 0);
-    lv_obj_set_style_bg_color(o_right_eye, eye_fill, 0);
-    lv_obj_set_style_bg_opa(o_right_eye, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_width(o_right_eye, 3, 0);
-    lv_obj_set_style_border_color(o_right_eye, eye_edge, 0);
+    o_right_eye = create_rrect(scr, &s_eye_style);
+    set_rrect(o_right_eye, &s_eye_style, eye_w, eye_h, eye_r);
     lv_obj_set_pos(o_right_eye, cx + eye_dx - eye_w / 2, cy - eye_h / 2);
 
-    o_left_pupil = lv_obj_create(scr);
-    lv_obj_clear_flag(o_left_pupil, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_size(o_left_pupil, pupil_r * 2, pupil_r * 2);
-    lv_obj_set_style_radius(o_left_pupil, LV_RADIUS_CIRCLE, 0);
-    lv_obj_set_style_bg_color(o_left_pupil, lv_color_black(), 0);
-    lv_obj_set_style_bg_opa(o_left_pupil, LV_OPA_COVER, 0);
-    // a subtle ring so the pupil reads against very dark blue
-    lv_obj_set_style_border_width(o_left_pupil, 2, 0);
-    lv_obj_set_style_border_color(o_left_pupil, accent, 0);
-
-    o_right_pupil = lv_obj_create(scr);
-    lv_obj_clear_flag(o_right_pupil, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_size(o_right_pupil, pupil_r * 2, pupil_r * 2);
-    lv_obj_set_style_radius(o_right_pupil, LV_RADIUS_CIRCLE, 0);
-    lv_obj_set_style_bg_color(o_right_pupil, lv_color_black(), 0);
-    lv_obj_set_style_bg_opa(o_right_pupil, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_width(o_right_pupil, 2, 0);
-    lv_obj_set_style_border_color(o_right_pupil, accent, 0);
-
-    // Lids (for blink): black overlays that hide the eyes (background is black)
+    o_left_pupil = create_rrect(scr, &s_pupil_style);
+    set_rrect(o_left_pupil, &s_pupil_style, pupil_r * 2, pupil_r * 2, pupil_r);
+
+    o_right_pupil = create_rrect(scr, &s_pupil_style);
+    set_rrect(o_right_pupil, &s_pupil_style, pupil_r * 2, pupil_r * 2, pupil_r);
+
+    // Lids (for blink): black overlays that hide the eyes (background is black, so square
+    // corners look the same as rounded ones and skip the anti-aliased corner path)
     o_left_lid = lv_obj_create(scr);
     lv_obj_clear_flag(o_left_lid, LV_OBJ_FLAG_SCROLLABLE);
     lv_obj_set_size(o_left_lid, eye_w + 6, eye_h + 6);
-    lv_obj_set_style_radius(o_left_lid, eye_r, 0);
+    lv_obj_set_style_radius(o_left_lid, 0, 0);
     lv_obj_set_style_bg_color(o_left_lid, lv_color_black(), 0);
     lv_obj_set_style_bg_opa(o_left_lid, LV_OPA_COVER, 0);
     lv_obj_set_style_border_width(o_left_lid, 0, 0);
@@ -227,7 +526,7 @@ static void create_face_ui(void) {
     o_right_lid = lv_obj_create(scr);
     lv_obj_clear_flag(o_right_lid, LV_OBJ_FLAG_SCROLLABLE);
     lv_obj_set_size(o_right_lid, eye_w + 6, eye_h + 6);
-    lv_obj_set_style_radius(o_right_lid, eye_r, 0);
+    lv_obj_set_style_radius(o_right_lid, 0, 0);
     lv_obj_set_style_bg_color(o_right_lid, lv_color_black(), 0);
     lv_obj_set_style_bg_opa(o_right_lid, LV_OPA_COVER, 0);
     lv_obj_set_style_border_width(o_right_lid, 0, 0);
@@ -235,40 +534,25 @@ static void create_face_ui(void) {
     lv_obj_add_flag(o_right_lid, LV_OBJ_FLAG_HIDDEN);
 
     // Blink lines: blue bars to show a "closed eye"
-    o_left_blink = lv_obj_create(scr);
-    lv_obj_clear_flag(o_left_blink, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_color(o_left_blink, eye_edge, 0);
-    lv_obj_set_style_bg_opa(o_left_blink, LV_OPA_COVER, 0);
-    lv_obj_set_style_radius(o_left_blink, 3, 0);
-    lv_obj_set_style_border_width(o_left_blink, 0, 0);
-    lv_obj_set_size(o_left_blink, eye_w - 16, 6);
+    o_left_blink = create_rrect(scr, &s_bar_style);
+    set_rrect(o_left_blink, &s_bar_style, eye_w - 16, 6, 3);
     lv_obj_set_pos(o_left_blink, cx - eye_dx - eye_w / 2 + 8, cy - 3);
     lv_obj_add_flag(o_left_blink, LV_OBJ_FLAG_HIDDEN);
 
-    o_right_blink = lv_obj_create(scr);
-    lv_obj_clear_flag(o_right_blink, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_color(o_right_blink, eye_edge, 0);
-    lv_obj_set_style_bg_opa(o_right_blink, LV_OPA_COVER, 0);
-    lv_obj_set_style_radius(o_right_blink, 3, 0);
-    lv_obj_set_style_border_width(o_right_blink, 0, 0);
-    lv_obj_set_size(o_right_blink, eye_w - 16, 6);
+    o_right_blink = create_rrect(scr, &s_bar_style);
+    set_rrect(o_right_blink, &s_bar_style, eye_w - 16, 6, 3);
     lv_obj_set_pos(o_right_blink, cx + eye_dx - eye_w / 2 + 8, cy - 3);
     lv_obj_add_flag(o_right_blink, LV_OBJ_FLAG_HIDDEN);
 
     // Mouth (simple): a thick bar for resting/angry, and a label for glyph expressions.
-    o_mouth_bar = lv_obj_create(scr);
-    lv_obj_clear_flag(o_mouth_bar, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_color(o_mouth_bar, eye_edge, 0);
-    lv_obj_set_style_bg_opa(o_mouth_bar, LV_OPA_COVER, 0);
-    lv_obj_set_style_radius(o_mouth_bar, 6, 0);
-    lv_obj_set_style_border_width(o_mouth_bar, 0, 0);
-    lv_obj_set_size(o_mouth_bar, 80, 10);
+    o_mouth_bar = create_rrect(scr, &s_bar_style);
+    set_rrect(o_mouth_bar, &s_bar_style, 80, 10, 6);
     lv_obj_align(o_mouth_bar, LV_ALIGN_CENTER, 0, 120);
 
     o_mouth = lv_label_create(scr);
     lv_obj_set_style_text_color(o_mouth, lv_color_white(), 0);
     lv_label_set_text(o_mouth, "");
-    lv_obj_set_style_text_font(o_mouth, &lv_font_montserrat_16, 0);
+    lv_obj_set_style_text_font(o_mouth, ui_font("mouth"), 0);
     lv_obj_align(o_mouth, LV_ALIGN_CENTER, 0, 105);
     lv_obj_add_flag(o_mouth, LV_OBJ_FLAG_HIDDEN);
 
@@ -276,7 +560,7 @@ static void create_face_ui(void) {
     lv_obj_set_width(o_caption, LCD_HRES - 20);
     lv_label_set_long_mode(o_caption, LV_LABEL_LONG_WRAP);
     lv_obj_set_style_text_align(o_caption, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_set_style_text_font(o_caption, &lv_font_montserrat_16, 0);
+    lv_obj_set_style_text_font(o_caption, ui_font("caption"), 0);
     lv_obj_set_style_text_color(o_caption, lv_color_white(), 0);
     // subtle dark backdrop (background is black)
     lv_obj_set_style_bg_color(o_caption, lv_color_black(), 0);
@@ -291,9 +575,81 @@ static void create_face_ui(void) {
     lv_obj_set_pos(o_right_pupil, cx + eye_dx - pupil_r, cy - pupil_r);
 }
 
-static void apply_face_state(uint32_t now_ms) {
-    if (!s_face_mux) return;
-    if (xSemaphoreTake(s_face_mux, pdMS_TO_TICKS(10)) != pdTRUE) return;
+// Everything apply_face_state() derives from face_state_t, as last pushed into LVGL.
+// LVGL setters invalidate (and re-flush) their area even when the value is unchanged, so each
+// group below is only written when it differs from what is already on screen.
+typedef struct {
+    bool valid;
+    uint32_t version;
+    uint8_t expired; // FACE_TTL_* bits cleared in the snapshot this was derived from
+    bool animating;  // derived from an in-between animation frame
+
+    int eye_h;
+    int eye_r;
+    bool blink;
+
+    bool pupils_visible;
+    int pupil_dx;
+    int pupil_dy;
+
+    char caption[sizeof(((face_state_t *)0)->caption)];
+
+    bool use_label;
+    const char *label;
+    int mouth_w;
+    int mouth_h;
+    int mouth_r;
+} face_geom_t;
+
+static face_geom_t s_geom;
+
+static void set_hidden(lv_obj_t *o, bool hidden) {
+    if (hidden) {
+        lv_obj_add_flag(o, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_clear_flag(o, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+// Milliseconds from now_ms until the next TTL deadline, capped at LVGL_IDLE_WAIT_MS.
+static uint32_t next_face_deadline_ms(uint32_t now_ms) {
+    uint32_t wait_ms = LVGL_IDLE_WAIT_MS;
+    const uint32_t until[] = {s_face.caption_until_ms, s_face.viseme_until_ms, s_face.blink_until_ms};
+    for (size_t i = 0; i < sizeof(until) / sizeof(until[0]); i++) {
+        if (!until[i]) continue;
+        // caption/viseme expire once now_ms > until, so wake one ms after it
+        const uint32_t d = until[i] >= now_ms ? until[i] - now_ms + 1 : 0;
+        if (d < wait_ms) wait_ms = d;
+    }
+    return wait_ms;
+}
+
+// Push the latest published face state into the LVGL objects. Returns how long the face can
+// stay as it is (ms) before a TTL runs out, assuming no new commands arrive.
+static uint32_t apply_face_state(uint32_t now_ms) {
+    face_store_read(&s_face_store, &s_face);
+    const uint8_t expired = face_state_expire(&s_face, now_ms);
+    bool animating = face_state_animate(&s_face, now_ms);
+
+    // While speech is audible, on-device lip sync drives the mouth (unless it is being animated).
+    float lip_open;
+    if (audio_lipsync_level(&lip_open) && !s_face.anim[FACE_CH_MOUTH_OPEN].start_ms) {
+        s_face.mouth_open = lip_open;
+        s_face.mouth_open_override = true;
+        animating = true;
+    }
+
+    uint32_t wait_ms = next_face_deadline_ms(now_ms);
+    if (animating && wait_ms > FACE_ANIM_FRAME_MS) wait_ms = FACE_ANIM_FRAME_MS;
+    if (s_geom.valid && s_geom.version == s_face.version) {
+        if (s_geom.expired != expired) {
+            // Same published state, but a TTL ran out since: subscribers should hear about it too.
+            ws_server_notify_face_changed();
+        } else if (!animating && !s_geom.animating) {
+            // Nothing changed since the last frame: leave LVGL alone so it has nothing to redraw.
+            return wait_ms;
+        }
+    }
 
     // Geometry constants (keep in sync with create_face_ui())
     const int eye_w = 120;
@@ -322,9 +678,12 @@ static void apply_face_state(uint32_t now_ms) {
     }
     if (open01 < 0.0f) open01 = 0.0f;
     if (open01 > 1.0f) open01 = 1.0f;
+#if CONFIG_LITTLEAI_FACE_SPRITES
+    open01 = face_sprite_quantize(open01); // one cached eye sprite per step
+#endif
 
     // Blink overrides (also treat sleeping as essentially "closed")
-    bool blink_active = (s_face.blink_until_ms && now_ms < s_face.blink_until_ms) || (s_face.expression == EXPR_SLEEPING);
+    bool blink_active = s_face.blink_until_ms || (s_face.expression == EXPR_SLEEPING);
 
     const int eye_h_min = 18;
     const int eye_h_max = 96;
@@ -339,28 +698,23 @@ static void apply_face_state(uint32_t now_ms) {
     int right_eye_y = cy - eye_h / 2;
 
     // Apply eye shape (lets us "squint" by changing height)
-    lv_obj_set_pos(o_left_eye, left_eye_x, left_eye_y);
-    lv_obj_set_size(o_left_eye, eye_w, eye_h);
-    lv_obj_set_style_radius(o_left_eye, eye_r, 0);
+    if (!s_geom.valid || eye_h != s_geom.eye_h || eye_r != s_geom.eye_r) {
+        lv_obj_set_pos(o_left_eye, left_eye_x, left_eye_y);
+        set_rrect(o_left_eye, &s_eye_style, eye_w, eye_h, eye_r);
 
-    lv_obj_set_pos(o_right_eye, right_eye_x, right_eye_y);
-    lv_obj_set_size(o_right_eye, eye_w, eye_h);
-    lv_obj_set_style_radius(o_right_eye, eye_r, 0);
+        lv_obj_set_pos(o_right_eye, right_eye_x, right_eye_y);
+        set_rrect(o_right_eye, &s_eye_style, eye_w, eye_h, eye_r);
 
-    // Update lids + blink lines to match eye geometry
-    lv_obj_set_pos(o_left_lid, left_eye_x - 3, left_eye_y - 3);
-    lv_obj_set_size(o_left_lid, eye_w + 6, eye_h + 6);
-    lv_obj_set_style_radius(o_left_lid, eye_r, 0);
-
-    lv_obj_set_pos(o_right_lid, right_eye_x - 3, right_eye_y - 3);
-    lv_obj_set_size(o_right_lid, eye_w + 6, eye_h + 6);
-    lv_obj_set_style_radius(o_right_lid, eye_r, 0);
+        // Update lids + blink lines to match eye geometry
+        lv_obj_set_pos(o_left_lid, left_eye_x - 3, left_eye_y - 3);
+        lv_obj_set_size(o_left_lid, eye_w + 6, eye_h + 6);
 
-    lv_obj_set_pos(o_left_blink, left_eye_x + 8, left_eye_y + eye_h / 2 - 3);
-    lv_obj_set_size(o_left_blink, eye_w - 16, 6);
+        lv_obj_set_pos(o_right_lid, right_eye_x - 3, right_eye_y - 3);
+        lv_obj_set_size(o_right_lid, eye_w + 6, eye_h + 6);
 
-    lv_obj_set_pos(o_right_blink, right_eye_x + 8, right_eye_y + eye_h / 2 - 3);
-    lv_obj_set_size(o_right_blink, eye_w - 16, 6);
+        lv_obj_set_pos(o_left_blink, left_eye_x + 8, left_eye_y + eye_h / 2 - 3);
+        lv_obj_set_pos(o_right_blink, right_eye_x + 8, right_eye_y + eye_h / 2 - 3);
+    }
 
     // gaze -> pupil offset (clamp to stay inside the eye)
     int max_px = (eye_w / 2) - pupil_r - 8;
@@ -375,10 +729,13 @@ static void apply_face_state(uint32_t now_ms) {
     if (py > max_py) py = max_py;
 
     bool pupils_visible = !blink_active && (eye_h >= (pupil_r * 2 + 10));
-    if (pupils_visible) {
-        lv_obj_clear_flag(o_left_pupil, LV_OBJ_FLAG_HIDDEN);
-        lv_obj_clear_flag(o_right_pupil, LV_OBJ_FLAG_HIDDEN);
-
+    if (!s_geom.valid || pupils_visible != s_geom.pupils_visible) {
+        set_hidden(o_left_pupil, !pupils_visible);
+        set_hidden(o_right_pupil, !pupils_visible);
+    }
+    if (pupils_visible &&
+        (!s_geom.valid || !s_geom.pupils_visible || eye_h != s_geom.eye_h ||
+         px != s_geom.pupil_dx || py != s_geom.pupil_dy)) {
         lv_obj_set_pos(o_left_pupil,
                        left_eye_x + eye_w / 2 - pupil_r + px,
                        left_eye_y + eye_h / 2 - pupil_r + py);
@@ -386,37 +743,20 @@ static void apply_face_state(uint32_t now_ms) {
         lv_obj_set_pos(o_right_pupil,
                        right_eye_x + eye_w / 2 - pupil_r + px,
                        right_eye_y + eye_h / 2 - pupil_r + py);
-    } else {
-        lv_obj_add_flag(o_left_pupil, LV_OBJ_FLAG_HIDDEN);
-        lv_obj_add_flag(o_right_pupil, LV_OBJ_FLAG_HIDDEN);
-    }
-
-    // caption ttl
-    if (s_face.caption_until_ms && now_ms > s_face.caption_until_ms) {
-        s_face.caption[0] = 0;
-        s_face.caption_until_ms = 0;
     }
-    lv_label_set_text(o_caption, s_face.caption);
 
-    // viseme ttl
-    if (s_face.viseme_until_ms && now_ms > s_face.viseme_until_ms) {
-        strcpy(s_face.viseme, "rest");
-        s_face.viseme_weight = 0.0f;
-        s_face.viseme_until_ms = 0;
+    // caption (lv_label_set_text re-wraps and redraws the whole label, even for the same text)
+    if (!s_geom.valid || strcmp(s_face.caption, s_geom.caption) != 0) {
+        lv_label_set_text(o_caption, s_face.caption);
+        strcpy(s_geom.caption, s_face.caption);
     }
 
     // blink
-    if (blink_active) {
-        lv_obj_clear_flag(o_left_lid, LV_OBJ_FLAG_HIDDEN);
-        lv_obj_clear_flag(o_right_lid, LV_OBJ_FLAG_HIDDEN);
-        lv_obj_clear_flag(o_left_blink, LV_OBJ_FLAG_HIDDEN);
-        lv_obj_clear_flag(o_right_blink, LV_OBJ_FLAG_HIDDEN);
-    } else {
-        lv_obj_add_flag(o_left_lid, LV_OBJ_FLAG_HIDDEN);
-        lv_obj_add_flag(o_right_lid, LV_OBJ_FLAG_HIDDEN);
-        lv_obj_add_flag(o_left_blink, LV_OBJ_FLAG_HIDDEN);
-        lv_obj_add_flag(o_right_blink, LV_OBJ_FLAG_HIDDEN);
-        s_face.blink_until_ms = 0;
+    if (!s_geom.valid || blink_active != s_geom.blink) {
+        set_hidden(o_left_lid, !blink_active);
+        set_hidden(o_right_lid, !blink_active);
+        set_hidden(o_left_blink, !blink_active);
+        set_hidden(o_right_blink, !blink_active);
     }
 
     // mouth expression
@@ -437,21 +777,13 @@ static void apply_face_state(uint32_t now_ms) {
         use_label = false;
     }
 
-    if (use_label) {
-        lv_obj_add_flag(o_mouth_bar, LV_OBJ_FLAG_HIDDEN);
-        lv_obj_clear_flag(o_mouth, LV_OBJ_FLAG_HIDDEN);
-        lv_label_set_text(o_mouth, label);
-    } else {
-        lv_obj_clear_flag(o_mouth_bar, LV_OBJ_FLAG_HIDDEN);
-        lv_obj_add_flag(o_mouth, LV_OBJ_FLAG_HIDDEN);
-
-        // Configure the bar: closed mouth (filled) vs open mouth (filled, taller).
+    // Mouth bar: closed mouth (filled) vs open mouth (filled, taller).
+    int mw = 0, mh = 0, mr = 0;
+    if (!use_label) {
         if (s_face.expression == EXPR_ANGRY) {
-            lv_obj_set_size(o_mouth_bar, 90, 12);
-            lv_obj_align(o_mouth_bar, LV_ALIGN_CENTER, 0, 120);
-            lv_obj_set_style_radius(o_mouth_bar, 2, 0);
-            lv_obj_set_style_bg_opa(o_mouth_bar, LV_OPA_COVER, 0);
-            lv_obj_set_style_border_width(o_mouth_bar, 0, 0);
+            mw = 90;
+            mh = 12;
+            mr = 2;
         } else {
             // Mouth openness: either rig-driven (sticky override) or viseme/expression-driven.
             float mopen01 = 0.0f;
@@ -466,44 +798,122 @@ static void apply_face_state(uint32_t now_ms) {
             }
             if (mopen01 < 0.0f) mopen01 = 0.0f;
             if (mopen01 > 1.0f) mopen01 = 1.0f;
+#if CONFIG_LITTLEAI_FACE_SPRITES
+            mopen01 = face_sprite_quantize(mopen01);
+#endif
 
             if (mopen01 > 0.05f) {
                 // Make it look like the same thick line, just "opening" vertically.
-                int mw = (s_face.expression == EXPR_SURPRISED) ? 120 : 96;
-                int mh = 10 + (int)(mopen01 * 54.0f); // 10..64-ish
+                mw = (s_face.expression == EXPR_SURPRISED) ? 120 : 96;
+                mh = 10 + (int)(mopen01 * 54.0f); // 10..64-ish
                 if (mh > 72) mh = 72;
-
-                lv_obj_set_size(o_mouth_bar, mw, mh);
-                lv_obj_align(o_mouth_bar, LV_ALIGN_CENTER, 0, 120);
-                lv_obj_set_style_radius(o_mouth_bar, mh / 2, 0);
-                lv_obj_set_style_bg_opa(o_mouth_bar, LV_OPA_COVER, 0);
-                lv_obj_set_style_border_width(o_mouth_bar, 0, 0);
+                mr = mh / 2;
             } else {
                 // Resting mouth: thick filled bar
-                lv_obj_set_size(o_mouth_bar, 96, 10);
-                lv_obj_align(o_mouth_bar, LV_ALIGN_CENTER, 0, 120);
-                lv_obj_set_style_radius(o_mouth_bar, 6, 0);
-                lv_obj_set_style_bg_opa(o_mouth_bar, LV_OPA_COVER, 0);
-                lv_obj_set_style_border_width(o_mouth_bar, 0, 0);
+                mw = 96;
+                mh = 10;
+                mr = 6;
             }
         }
     }
 
-    xSemaphoreGive(s_face_mux);
+    if (!s_geom.valid || use_label != s_geom.use_label) {
+        set_hidden(o_mouth_bar, use_label);
+        set_hidden(o_mouth, !use_label);
+    }
+    if (use_label && (!s_geom.valid || !s_geom.use_label || label != s_geom.label)) {
+        lv_label_set_text_static(o_mouth, label);
+    }
+    if (!use_label &&
+        (!s_geom.valid || s_geom.use_label || mw != s_geom.mouth_w || mh != s_geom.mouth_h || mr != s_geom.mouth_r)) {
+        set_rrect(o_mouth_bar, &s_bar_style, mw, mh, mr);
+        lv_obj_align(o_mouth_bar, LV_ALIGN_CENTER, 0, 120);
+    }
+
+    s_geom.valid = true;
+    s_geom.version = s_face.version;
+    s_geom.expired = expired;
+    s_geom.animating = animating;
+    s_geom.eye_h = eye_h;
+    s_geom.eye_r = eye_r;
+    s_geom.blink = blink_active;
+    s_geom.pupils_visible = pupils_visible;
+    s_geom.pupil_dx = px;
+    s_geom.pupil_dy = py;
+    s_geom.use_label = use_label;
+    s_geom.label = label;
+    s_geom.mouth_w = mw;
+    s_geom.mouth_h = mh;
+    s_geom.mouth_r = mr;
+
+    return wait_ms;
 }
 
+// Event-driven render loop. LVGL's refresh and input timers are due every few ms whether or
+// not there is work, so their deadline is only honoured while a redraw, touch or animation is
+// in flight; otherwise the task sleeps until the next face TTL, a WS command or a touch IRQ.
+// Timers that came due while asleep simply run on the next lv_timer_handler() call.
 static void lvgl_task(void *arg) {
     while (1) {
+        uint32_t wait_ms = 10;
         if (lvgl_lock(50)) {
-            lv_timer_handler();
-            apply_face_state((uint32_t)(esp_timer_get_time() / 1000));
+            int64_t t0 = esp_timer_get_time();
+            wait_ms = apply_face_state((uint32_t)(t0 / 1000));
+            perf_record_since(PERF_APPLY_FACE, t0);
+
+            const uint32_t frames = s_frames_flushed;
+            t0 = esp_timer_get_time();
+            const uint32_t lv_ms = lv_timer_handler();
+            if (s_frames_flushed != frames) perf_record_since(PERF_FRAME, t0);
+            if ((s_disp->inv_p > 0 || s_touch_down || s_touch_irq || lv_anim_count_running() > 0) && lv_ms < wait_ms) {
+                wait_ms = lv_ms;
+            }
             lvgl_unlock();
         }
-        vTaskDelay(pdMS_TO_TICKS(5));
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms ? wait_ms : 1));
     }
 }
 
-static void i2c_scan_bus(i2c_port_t port) {
+static void boot_mark(const char *name) {
+    if (s_boot_nmarks < BOOT_MAX_MARKS) {
+        s_boot_marks[s_boot_nmarks].name = name;
+        s_boot_marks[s_boot_nmarks].us = esp_timer_get_time();
+        s_boot_nmarks++;
+    }
+}
+
+// e.g. "boot (ms): i2c 1, expander 21, panel 142, ... | face at 260, ready at 310 | wifi init 240 in parallel"
+static void boot_log(void) {
+    char line[256];
+    int n = snprintf(line, sizeof(line), "boot (ms):");
+    int64_t prev = 0;
+    int64_t face_us = 0;
+    for (int i = 0; i < s_boot_nmarks && n < (int)sizeof(line); i++) {
+        n += snprintf(line + n, sizeof(line) - n, "%s %s %lld", i ? "," : "", s_boot_marks[i].name,
+                      (long long)((s_boot_marks[i].us - prev) / 1000));
+        prev = s_boot_marks[i].us;
+        if (strcmp(s_boot_marks[i].name, "first_frame") == 0) face_us = prev;
+    }
+    if (n < (int)sizeof(line)) {
+        snprintf(line + n, sizeof(line) - n, " | face at %lld, ready at %lld | wifi init %lld in parallel",
+                 (long long)(face_us / 1000), (long long)(prev / 1000), (long long)(s_wifi_init_us / 1000));
+    }
+    ESP_LOGI(TAG, "%s", line);
+}
+
+// NVS + netif + Wi-Fi driver init, on the other core while app_main brings up the panel. The
+// connection itself proceeds in the background from the Wi-Fi event handler.
+static void net_boot_task(void *arg) {
+    const int64_t t0 = esp_timer_get_time();
+    wifi_manager_start();
+    s_wifi_init_us = esp_timer_get_time() - t0;
+    xSemaphoreGive(s_net_ready);
+    vTaskDelete(NULL);
+}
+
+#if CONFIG_LITTLEAI_I2C_BOOT_SCAN
+static esp_err_t i2c_scan_bus(void *arg) {
+    const i2c_port_t port = i2c_bus_port();
     ESP_LOGI(TAG, "I2C scan on port %d...", (int)port);
     for (uint8_t addr = 0x08; addr < 0x78; addr++) {
         i2c_cmd_handle_t cmd = i2c_cmd_link_create();
@@ -516,13 +926,21 @@ static void i2c_scan_bus(i2c_port_t port) {
             ESP_LOGI(TAG, "  found device at 0x%02X", addr);
         }
     }
+    return ESP_OK;
+}
+#endif
+
+static esp_err_t tca9554_create(void *out) {
+    return esp_io_expander_new_i2c_tca9554(i2c_bus_port(), ESP_IO_EXPANDER_I2C_TCA9554_ADDRESS_000,
+                                           (esp_io_expander_handle_t *)out);
 }
 
-static void maybe_init_io_expander(i2c_port_t port) {
+static void maybe_init_io_expander(void) {
     // Waveshare reference design uses a TCA9554 IO expander to enable power rails.
     // On some boards it's required for the touch controller to respond on I2C.
+    // Boot-time only (before touch and audio exist), so the pin writes below don't need the bus lock.
     esp_io_expander_handle_t io_expander = NULL;
-    esp_err_t err = esp_io_expander_new_i2c_tca9554(port, ESP_IO_EXPANDER_I2C_TCA9554_ADDRESS_000, &io_expander);
+    esp_err_t err = i2c_bus_run(I2C_DEV_EXPANDER, tca9554_create, &io_expander, 100);
     if (err != ESP_OK) {
         ESP_LOGW(TAG, "No TCA9554 IO expander at addr 000 (0x20): %s", esp_err_to_name(err));
         return;
@@ -533,7 +951,7 @@ static void maybe_init_io_expander(i2c_port_t port) {
     esp_io_expander_set_level(io_expander, IO_EXPANDER_PIN_NUM_0, 0);
     esp_io_expander_set_level(io_expander, IO_EXPANDER_PIN_NUM_1, 0);
     esp_io_expander_set_level(io_expander, IO_EXPANDER_PIN_NUM_2, 0);
-    vTaskDelay(pdMS_TO_TICKS(200));
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_LITTLEAI_IO_EXPANDER_RESET_MS));
     esp_io_expander_set_level(io_expander, IO_EXPANDER_PIN_NUM_0, 1);
     esp_io_expander_set_level(io_expander, IO_EXPANDER_PIN_NUM_1, 1);
     esp_io_expander_set_level(io_expander, IO_EXPANDER_PIN_NUM_2, 1);
@@ -550,21 +968,18 @@ static void init_display_and_lvgl(void) {
     // -----------------
     // I2C (touch + optional IO expander)
     // -----------------
-    i2c_config_t i2c_conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = I2C_SDA,
-        .scl_io_num = I2C_SCL,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = 200000,
-    };
-    ESP_ERROR_CHECK(i2c_param_config(TOUCH_HOST, &i2c_conf));
-    ESP_ERROR_CHECK(i2c_driver_install(TOUCH_HOST, i2c_conf.mode, 0, 0, 0));
+    ESP_ERROR_CHECK(i2c_bus_init());
+    boot_mark("i2c");
 
+#if CONFIG_LITTLEAI_I2C_BOOT_SCAN
     // Helpful when bringing up new boards
-    i2c_scan_bus(TOUCH_HOST);
-    maybe_init_io_expander(TOUCH_HOST);
-    i2c_scan_bus(TOUCH_HOST);
+    i2c_bus_run(I2C_DEV_SCAN, i2c_scan_bus, NULL, 100);
+#endif
+    maybe_init_io_expander();
+#if CONFIG_LITTLEAI_I2C_BOOT_SCAN
+    i2c_bus_run(I2C_DEV_SCAN, i2c_scan_bus, NULL, 100);
+#endif
+    boot_mark("expander");
 
     // -----------------
     // LCD (QSPI / SH8601)
@@ -575,7 +990,7 @@ static void init_display_and_lvgl(void) {
         LCD_SDIO1,
         LCD_SDIO2,
         LCD_SDIO3,
-        LCD_HRES * LCD_VRES * LCD_BIT_PER_PIXEL / 8);
+        LCD_MAX_TRANSFER_BYTES);
 
     ESP_ERROR_CHECK(spi_bus_initialize(LCD_HOST, &buscfg, SPI_DMA_CH_AUTO));
 
@@ -630,19 +1045,21 @@ static void init_display_and_lvgl(void) {
 
     // Brightness (0..255)
     ESP_ERROR_CHECK(esp_lcd_panel_io_tx_param(s_io, 0x51, (uint8_t[]){0xFF}, 1));
+    boot_mark("panel");
 
     // -----------------
     // TOUCH (I2C / FT3168 via FT5x06 driver)
     // -----------------
     esp_lcd_panel_io_handle_t tp_io_handle = NULL;
     const esp_lcd_panel_io_i2c_config_t tp_io_config = ESP_LCD_TOUCH_IO_I2C_FT5x06_CONFIG();
-    ESP_ERROR_CHECK(esp_lcd_new_panel_io_i2c((esp_lcd_i2c_bus_handle_t)TOUCH_HOST, &tp_io_config, &tp_io_handle));
+    ESP_ERROR_CHECK(esp_lcd_new_panel_io_i2c((esp_lcd_i2c_bus_handle_t)(uintptr_t)i2c_bus_port(), &tp_io_config, &tp_io_handle));
 
     esp_lcd_touch_config_t tp_cfg = {
         .x_max = LCD_HRES,
         .y_max = LCD_VRES,
         .rst_gpio_num = -1,
         .int_gpio_num = TP_INT,
+        .interrupt_callback = touch_isr_cb,
         .levels = {
             .reset = 0,
             .interrupt = 0,
@@ -655,25 +1072,44 @@ static void init_display_and_lvgl(void) {
     };
 
     ESP_ERROR_CHECK(esp_lcd_touch_new_i2c_ft5x06(tp_io_handle, &tp_cfg, &s_touch));
+    boot_mark("touch");
 
     // -----------------
     // LVGL
     // -----------------
     lv_init();
+    assets_lv_init();
     s_lvgl_mux = xSemaphoreCreateMutex();
 
+#if CONFIG_LITTLEAI_LCD_FB_PSRAM
+    // one full frame in PSRAM, rendered in place (direct mode); only dirty rectangles go out
+    // to the panel, staged through two small internal DMA bounce buffers
+    lv_color_t *fb = (lv_color_t *)heap_caps_malloc(LCD_HRES * LCD_VRES * sizeof(lv_color_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    for (int i = 0; i < 2; i++) {
+        s_bounce[i] = (lv_color_t *)heap_caps_malloc(LCD_HRES * LCD_BOUNCE_LINES * sizeof(lv_color_t), MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+    }
+    s_bounce_free = xSemaphoreCreateCounting(2, 2);
+    assert(fb && s_bounce[0] && s_bounce[1] && s_bounce_free);
+    memset(fb, 0, LCD_HRES * LCD_VRES * sizeof(lv_color_t));
+    lv_disp_draw_buf_init(&draw_buf, fb, NULL, LCD_HRES * LCD_VRES);
+#else
     // draw buffers in internal DMA-capable memory (QSPI/SPI DMA can't reliably read PSRAM)
     lv_color_t *buf1 = (lv_color_t *)heap_caps_malloc(LCD_HRES * LVGL_BUF_HEIGHT * sizeof(lv_color_t), MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
     lv_color_t *buf2 = (lv_color_t *)heap_caps_malloc(LCD_HRES * LVGL_BUF_HEIGHT * sizeof(lv_color_t), MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
     assert(buf1 && buf2);
     lv_disp_draw_buf_init(&draw_buf, buf1, buf2, LCD_HRES * LVGL_BUF_HEIGHT);
+#endif
 
     lv_disp_drv_init(&disp_drv);
     disp_drv.hor_res = LCD_HRES;
     disp_drv.ver_res = LCD_VRES;
     disp_drv.flush_cb = lvgl_flush_cb;
+    disp_drv.rounder_cb = lvgl_rounder_cb;
     disp_drv.draw_buf = &draw_buf;
     disp_drv.user_data = s_panel;
+#if CONFIG_LITTLEAI_LCD_FB_PSRAM
+    disp_drv.direct_mode = 1;
+#endif
 
     s_disp = lv_disp_drv_register(&disp_drv);
 
@@ -683,6 +1119,9 @@ static void init_display_and_lvgl(void) {
     indev_drv.user_data = s_touch;
     s_indev = lv_indev_drv_register(&indev_drv);
 
+#if !CONFIG_LV_TICK_CUSTOM
+    // Prefer CONFIG_LV_TICK_CUSTOM (esp_timer_get_time): this periodic timer keeps the CPU
+    // from ever idling for long.
     const esp_timer_create_args_t tick_args = {
         .callback = &lvgl_tick,
         .name = "lv_tick",
@@ -690,14 +1129,24 @@ static void init_display_and_lvgl(void) {
     esp_timer_handle_t tick_timer;
     ESP_ERROR_CHECK(esp_timer_create(&tick_args, &tick_timer));
     ESP_ERROR_CHECK(esp_timer_start_periodic(tick_timer, LVGL_TICK_PERIOD_MS * 1000));
+#endif
+
+    boot_mark("lvgl");
 
-    // UI
+    // UI. Draw the neutral face right away instead of waiting for the render task's first pass.
     if (lvgl_lock(1000)) {
         create_face_ui();
+        lv_refr_now(s_disp);
         lvgl_unlock();
     }
+    boot_mark("first_frame");
+
+    xTaskCreatePinnedToCore(lvgl_task, "lvgl", 4096, NULL, CONFIG_LITTLEAI_LVGL_TASK_PRIORITY, &s_lvgl_task,
+                            LVGL_TASK_CORE);
+}
 
-    xTaskCreate(lvgl_task, "lvgl", 4096, NULL, 2, NULL);
+static void boot_chime_cb(void *arg) {
+    audio_beep(1320, 120);
 }
 
 void app_main(void) {
@@ -707,7 +1156,17 @@ void app_main(void) {
 
     ESP_LOGI(TAG, "%s boot", FACE_DEVICE_NAME);
     face_state_init(&s_face);
-    s_face_mux = xSemaphoreCreateMutex();
+    face_store_init(&s_face_store, &s_face);
+
+    // Fonts, images and sound clips from the "assets" partition (optional).
+    esp_err_t as = assets_mount();
+    if (as != ESP_OK) ESP_LOGW(TAG, "no asset pack (%s); using built-in fonts", esp_err_to_name(as));
+
+    // Wi-Fi/NVS init on the other core while this one brings up the panel; the slow parts
+    // (expander pulse, SH8601 sleep-out, PHY calibration) overlap.
+    s_net_ready = xSemaphoreCreateBinary();
+    assert(s_net_ready);
+    xTaskCreatePinnedToCore(net_boot_task, "net_boot", 4096, NULL, 3, NULL, xPortGetCoreID() ? 0 : 1);
 
     init_display_and_lvgl();
 
@@ -716,27 +1175,43 @@ void app_main(void) {
     audio_config_t acfg = {
         .sample_rate_hz = 16000,
         .volume_percent = 75,
+        .on_lipsync_start = lvgl_wake,
     };
     esp_err_t ae = audio_init(&acfg);
     if (ae == ESP_OK) {
+        // Two-note chime; beeps replace each other on the tone voice, so time the second one.
         audio_beep(880, 120);
-        audio_beep(1320, 120);
+        const esp_timer_create_args_t chime_args = {.callback = &boot_chime_cb, .name = "chime"};
+        esp_timer_handle_t chime;
+        if (esp_timer_create(&chime_args, &chime) == ESP_OK) esp_timer_start_once(chime, 120 * 1000);
     } else {
         ESP_LOGW(TAG, "audio_init failed: %s", esp_err_to_name(ae));
     }
+    boot_mark("audio");
 
-    // Wi-Fi manager: auto-connect or start AP portal
-    wifi_manager_start();
+    // Wi-Fi manager (auto-connect or AP portal) must be up before the WS server binds.
+    xSemaphoreTake(s_net_ready, portMAX_DELAY);
+    boot_mark("wifi_wait");
 
     // WebSocket control plane
     ws_server_config_t ws_cfg = {
-        .face = &s_face,
-        .face_mutex = s_face_mux,
+        .face = &s_face_store,
+        .on_face_changed = lvgl_wake,
     };
     ESP_ERROR_CHECK(ws_server_start(&ws_cfg));
     ESP_LOGI(TAG, "WS: ws://<device-ip>:8080/ws");
+    boot_mark("ws");
+
+    // Optional: UDP face channel, then mDNS (its TXT records list the UDP port if it is up).
+    esp_err_t ue = udp_ctl_start();
+    if (ue != ESP_OK && ue != ESP_ERR_NOT_SUPPORTED) ESP_LOGW(TAG, "udp_ctl_start failed: %s", esp_err_to_name(ue));
+    esp_err_t de = discovery_start(FACE_DEVICE_NAME);
+    if (de != ESP_OK && de != ESP_ERR_NOT_SUPPORTED) ESP_LOGW(TAG, "discovery_start failed: %s", esp_err_to_name(de));
+    boot_mark("discovery");
+    boot_log();
 
     while (1) {
         vTaskDelay(pdMS_TO_TICKS(1000));
+        ota_confirm_tick();
     }
 }
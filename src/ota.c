@@ -0,0 +1,189 @@
+#include "ota.h"
+
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_ota_ops.h"
+#include "esp_app_desc.h"
+
+#include "mbedtls/sha256.h"
+
+#include "wifi_manager.h"
+
+static const char *TAG = "ota";
+
+#ifndef CONFIG_LITTLEAI_OTA_CONFIRM_TIMEOUT_S
+#define CONFIG_LITTLEAI_OTA_CONFIRM_TIMEOUT_S 120
+#endif
+
+static struct {
+    ota_phase_t phase;
+    const esp_partition_t *part;
+    esp_ota_handle_t handle;
+    mbedtls_sha256_context sha;
+    uint8_t expect[32];
+    uint32_t size;
+    uint32_t written;
+} s_ota;
+
+static esp_timer_handle_t s_restart_timer = NULL;
+
+const char *ota_phase_name(ota_phase_t phase)
+{
+    switch (phase) {
+        case OTA_IDLE: return "idle";
+        case OTA_RECEIVING: return "receiving";
+        case OTA_READY: return "ready";
+        default: return "unknown";
+    }
+}
+
+void ota_abort(void)
+{
+    if (s_ota.phase == OTA_RECEIVING) {
+        esp_ota_abort(s_ota.handle);
+        mbedtls_sha256_free(&s_ota.sha);
+    } else if (s_ota.phase == OTA_READY) {
+        // The new slot was already made the boot partition; point it back at ourselves.
+        esp_ota_set_boot_partition(esp_ota_get_running_partition());
+    }
+    if (s_ota.phase != OTA_IDLE) ESP_LOGW(TAG, "update aborted at %u/%u bytes", (unsigned)s_ota.written, (unsigned)s_ota.size);
+    memset(&s_ota, 0, sizeof(s_ota));
+}
+
+esp_err_t ota_begin(uint32_t size, const uint8_t sha256[32], uint32_t *offset)
+{
+    ESP_RETURN_ON_FALSE(size > 0 && sha256 && offset, ESP_ERR_INVALID_ARG, TAG, "bad args");
+
+    if (s_ota.phase != OTA_IDLE && s_ota.size == size && memcmp(s_ota.expect, sha256, 32) == 0) {
+        *offset = s_ota.written;
+        ESP_LOGI(TAG, "resuming update at %u/%u bytes", (unsigned)s_ota.written, (unsigned)size);
+        return ESP_OK;
+    }
+    ota_abort();
+
+    const esp_partition_t *part = esp_ota_get_next_update_partition(NULL);
+    ESP_RETURN_ON_FALSE(part, ESP_ERR_NOT_FOUND, TAG, "no OTA slot in the partition table");
+    ESP_RETURN_ON_FALSE(size <= part->size, ESP_ERR_INVALID_SIZE, TAG, "image (%u) larger than %s (%u)",
+                        (unsigned)size, part->label, (unsigned)part->size);
+
+    // Sequential writes: sectors are erased as the image reaches them, so begin returns at once.
+    ESP_RETURN_ON_ERROR(esp_ota_begin(part, OTA_WITH_SEQUENTIAL_WRITES, &s_ota.handle), TAG, "esp_ota_begin");
+    mbedtls_sha256_init(&s_ota.sha);
+    mbedtls_sha256_starts(&s_ota.sha, 0);
+    memcpy(s_ota.expect, sha256, 32);
+    s_ota.part = part;
+    s_ota.size = size;
+    s_ota.written = 0;
+    s_ota.phase = OTA_RECEIVING;
+    *offset = 0;
+    ESP_LOGI(TAG, "update of %u bytes into %s", (unsigned)size, part->label);
+    return ESP_OK;
+}
+
+esp_err_t ota_write(uint32_t offset, const void *data, size_t len)
+{
+    if (s_ota.phase != OTA_RECEIVING) return ESP_ERR_INVALID_STATE;
+    if (offset != s_ota.written || len > s_ota.size - s_ota.written) return ESP_ERR_INVALID_ARG;
+    if (len == 0) return ESP_OK;
+
+    esp_err_t err = esp_ota_write(s_ota.handle, data, len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_write at %u: %s", (unsigned)offset, esp_err_to_name(err));
+        ota_abort();
+        return err;
+    }
+    mbedtls_sha256_update(&s_ota.sha, (const unsigned char *)data, len);
+    s_ota.written += len;
+    return ESP_OK;
+}
+
+esp_err_t ota_finish(void)
+{
+    if (s_ota.phase == OTA_READY) return ESP_OK;
+    if (s_ota.phase != OTA_RECEIVING || s_ota.written != s_ota.size) return ESP_ERR_INVALID_STATE;
+
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&s_ota.sha, digest);
+    if (memcmp(digest, s_ota.expect, sizeof(digest)) != 0) {
+        ESP_LOGE(TAG, "SHA-256 mismatch");
+        ota_abort();
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    mbedtls_sha256_free(&s_ota.sha);
+    esp_err_t err = esp_ota_end(s_ota.handle); // also validates the image header/checksum
+    if (err == ESP_OK) err = esp_ota_set_boot_partition(s_ota.part);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "finishing update: %s", esp_err_to_name(err));
+        memset(&s_ota, 0, sizeof(s_ota)); // esp_ota_end() released the handle either way
+        return err;
+    }
+    s_ota.phase = OTA_READY;
+    ESP_LOGI(TAG, "update verified; %s boots next", s_ota.part->label);
+    return ESP_OK;
+}
+
+void ota_get_status(ota_status_t *out)
+{
+    if (!out) return;
+    const esp_partition_t *run = esp_ota_get_running_partition();
+    esp_ota_img_states_t st = ESP_OTA_IMG_UNDEFINED;
+    out->phase = s_ota.phase;
+    out->size = s_ota.size;
+    out->written = s_ota.written;
+    out->target = s_ota.part ? s_ota.part->label : "";
+    out->running = run ? run->label : "";
+    out->pending_verify = run && esp_ota_get_state_partition(run, &st) == ESP_OK && st == ESP_OTA_IMG_PENDING_VERIFY;
+    out->version = esp_app_get_description()->version;
+}
+
+static void restart_cb(void *arg)
+{
+    esp_restart();
+}
+
+void ota_restart_after(uint32_t delay_ms)
+{
+    if (!s_restart_timer) {
+        const esp_timer_create_args_t args = {
+            .callback = restart_cb,
+            .name = "ota_restart",
+        };
+        if (esp_timer_create(&args, &s_restart_timer) != ESP_OK) {
+            esp_restart();
+            return;
+        }
+    }
+    esp_timer_stop(s_restart_timer);
+    esp_timer_start_once(s_restart_timer, (uint64_t)delay_ms * 1000);
+}
+
+void ota_confirm_tick(void)
+{
+    static bool s_done = false;
+    if (s_done) return;
+
+    const esp_partition_t *run = esp_ota_get_running_partition();
+    esp_ota_img_states_t st;
+    if (!run || esp_ota_get_state_partition(run, &st) != ESP_OK || st != ESP_OTA_IMG_PENDING_VERIFY) {
+        s_done = true; // factory image, or already confirmed
+        return;
+    }
+
+    if (CONFIG_LITTLEAI_OTA_CONFIRM_TIMEOUT_S == 0 || wifi_manager_is_connected()) {
+        ESP_LOGI(TAG, "new image in %s confirmed", run->label);
+        esp_ota_mark_app_valid_cancel_rollback();
+        s_done = true;
+        return;
+    }
+
+    if (esp_timer_get_time() > (int64_t)CONFIG_LITTLEAI_OTA_CONFIRM_TIMEOUT_S * 1000000) {
+        ESP_LOGE(TAG, "no Wi-Fi %d s after an update; rolling back", CONFIG_LITTLEAI_OTA_CONFIRM_TIMEOUT_S);
+        esp_ota_mark_app_invalid_rollback_and_reboot();
+    }
+}
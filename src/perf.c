@@ -0,0 +1,73 @@
+#include "perf.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+const uint32_t perf_hist_bounds_us[PERF_HIST_BUCKETS - 1] = {
+    250, 500, 1000, 2000, 4000, 8000, 16000, 33000,
+};
+
+static const struct {
+    const char *name;
+    bool time;
+} kPerfIds[PERF_ID_COUNT] = {
+    [PERF_FRAME] = {"frame", true},
+    [PERF_APPLY_FACE] = {"apply_face", true},
+    [PERF_LVGL_LOCK] = {"lvgl_lock", true},
+    [PERF_FLUSH_DMA] = {"flush_dma", true},
+    [PERF_FLUSH_BYTES] = {"flush_bytes", false},
+    [PERF_FLUSH_AREAS] = {"flush_areas", false},
+    [PERF_WS_HANDLER] = {"ws_handler", true},
+    [PERF_WS_AUDIO] = {"ws_audio", true},
+    [PERF_AUDIO_WRITE] = {"audio_write", true},
+};
+
+static perf_stat_t s_stats[PERF_ID_COUNT];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void perf_record(perf_id_t id, uint32_t value)
+{
+    if ((unsigned)id >= PERF_ID_COUNT) return;
+
+    int bucket = 0;
+    if (kPerfIds[id].time) {
+        while (bucket < PERF_HIST_BUCKETS - 1 && value >= perf_hist_bounds_us[bucket]) bucket++;
+    }
+
+    portENTER_CRITICAL_SAFE(&s_lock);
+    perf_stat_t *st = &s_stats[id];
+    st->count++;
+    st->total += value;
+    if (value > st->max) st->max = value;
+    if (kPerfIds[id].time) st->hist[bucket]++;
+    portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+void perf_get(perf_id_t id, perf_stat_t *out)
+{
+    if ((unsigned)id >= PERF_ID_COUNT) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    portENTER_CRITICAL_SAFE(&s_lock);
+    *out = s_stats[id];
+    portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+void perf_reset(void)
+{
+    portENTER_CRITICAL_SAFE(&s_lock);
+    memset(s_stats, 0, sizeof(s_stats));
+    portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+const char *perf_name(perf_id_t id)
+{
+    return (unsigned)id < PERF_ID_COUNT ? kPerfIds[id].name : "unknown";
+}
+
+bool perf_is_time(perf_id_t id)
+{
+    return (unsigned)id < PERF_ID_COUNT && kPerfIds[id].time;
+}
@@ -0,0 +1,117 @@
+#include "touch_gesture.h"
+
+#include <stdlib.h>
+
+// Thresholds in panel pixels (368 x 448) and milliseconds.
+#define TAP_MAX_MS 350
+#define TAP_MAX_MOVE_PX 24
+#define LONG_PRESS_MS 700
+#define SWIPE_MAX_MS 800
+#define SWIPE_MIN_PX 80
+#define PET_MIN_PATH_PX 240
+#define PET_MIN_REVERSALS 2
+#define REVERSAL_MIN_PX 30 // movement that counts as a stroke leg (filters jitter)
+
+static int8_t sign_of(int v) {
+    return (int8_t)((v > 0) - (v < 0));
+}
+
+// Track per-axis direction changes; a reversal counts once the new leg is long enough.
+static void track_axis(int pos, int16_t *anchor, int8_t *dir, uint8_t *reversals) {
+    const int d = pos - *anchor;
+    if (abs(d) < REVERSAL_MIN_PX) return;
+    const int8_t s = sign_of(d);
+    if (*dir != 0 && s != *dir && *reversals < UINT8_MAX) (*reversals)++;
+    *dir = s;
+    *anchor = (int16_t)pos;
+}
+
+static void fill(const touch_gesture_state_t *st, touch_gesture_type_t type, uint32_t now_ms, touch_gesture_t *out) {
+    out->type = (uint8_t)type;
+    out->dir = TOUCH_DIR_NONE;
+    out->strokes = 0;
+    out->x = st->x0;
+    out->y = st->y0;
+    out->dx = (int16_t)(st->x - st->x0);
+    out->dy = (int16_t)(st->y - st->y0);
+    out->duration_ms = now_ms - st->t0_ms;
+}
+
+bool touch_gesture_feed(touch_gesture_state_t *st, bool pressed, int x, int y, uint32_t now_ms,
+                        touch_gesture_t *out) {
+    if (pressed && !st->down) {
+        *st = (touch_gesture_state_t){0};
+        st->down = true;
+        st->x0 = st->x = st->ax = (int16_t)x;
+        st->y0 = st->y = st->ay = (int16_t)y;
+        st->t0_ms = now_ms;
+        return false;
+    }
+
+    if (pressed) {
+        st->path += (uint32_t)(abs(x - st->x) + abs(y - st->y));
+        st->x = (int16_t)x;
+        st->y = (int16_t)y;
+        track_axis(x, &st->ax, &st->sx, &st->reversals);
+        track_axis(y, &st->ay, &st->sy, &st->reversals);
+
+        const uint32_t held = now_ms - st->t0_ms;
+        const int moved = abs(x - st->x0) + abs(y - st->y0);
+        if (!st->long_sent && held >= LONG_PRESS_MS && moved <= TAP_MAX_MOVE_PX && st->path <= 2 * TAP_MAX_MOVE_PX) {
+            st->long_sent = true;
+            fill(st, TOUCH_GESTURE_LONG_PRESS, now_ms, out);
+            return true;
+        }
+        return false;
+    }
+
+    if (!st->down) return false;
+    st->down = false;
+    if (st->long_sent) return false;
+
+    // Released: classify the whole touch (coordinates of the release sample are not valid).
+    const uint32_t held = now_ms - st->t0_ms;
+    const int dx = st->x - st->x0;
+    const int dy = st->y - st->y0;
+    const int moved = abs(dx) + abs(dy);
+
+    if (st->reversals >= PET_MIN_REVERSALS && st->path >= PET_MIN_PATH_PX) {
+        fill(st, TOUCH_GESTURE_PET, now_ms, out);
+        out->strokes = st->reversals;
+        return true;
+    }
+    if (held <= SWIPE_MAX_MS && (abs(dx) >= SWIPE_MIN_PX || abs(dy) >= SWIPE_MIN_PX)) {
+        fill(st, TOUCH_GESTURE_SWIPE, now_ms, out);
+        if (abs(dx) >= abs(dy)) {
+            out->dir = dx < 0 ? TOUCH_DIR_LEFT : TOUCH_DIR_RIGHT;
+        } else {
+            out->dir = dy < 0 ? TOUCH_DIR_UP : TOUCH_DIR_DOWN;
+        }
+        return true;
+    }
+    if (held <= TAP_MAX_MS && moved <= TAP_MAX_MOVE_PX) {
+        fill(st, TOUCH_GESTURE_TAP, now_ms, out);
+        return true;
+    }
+    return false;
+}
+
+const char *touch_gesture_name(touch_gesture_type_t type) {
+    switch (type) {
+        case TOUCH_GESTURE_TAP: return "tap";
+        case TOUCH_GESTURE_LONG_PRESS: return "long_press";
+        case TOUCH_GESTURE_SWIPE: return "swipe";
+        case TOUCH_GESTURE_PET: return "pet";
+        default: return "unknown";
+    }
+}
+
+const char *touch_dir_name(touch_dir_t dir) {
+    switch (dir) {
+        case TOUCH_DIR_LEFT: return "left";
+        case TOUCH_DIR_RIGHT: return "right";
+        case TOUCH_DIR_UP: return "up";
+        case TOUCH_DIR_DOWN: return "down";
+        default: return "none";
+    }
+}
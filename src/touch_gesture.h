@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Small gesture recognizer over raw touch samples (one finger). Feed it every touch read;
+// it reports tap, long press, swipes and "pet" (a back-and-forth stroke across the face).
+
+typedef enum {
+    TOUCH_GESTURE_TAP = 0,
+    TOUCH_GESTURE_LONG_PRESS, // reported while the finger is still down
+    TOUCH_GESTURE_SWIPE,      // dir is set
+    TOUCH_GESTURE_PET,        // strokes = direction reversals
+} touch_gesture_type_t;
+
+typedef enum {
+    TOUCH_DIR_NONE = 0,
+    TOUCH_DIR_LEFT,
+    TOUCH_DIR_RIGHT,
+    TOUCH_DIR_UP,
+    TOUCH_DIR_DOWN,
+} touch_dir_t;
+
+typedef struct {
+    uint8_t type;         // touch_gesture_type_t
+    uint8_t dir;          // touch_dir_t (swipes)
+    uint8_t strokes;      // pets
+    int16_t x;            // where the touch started
+    int16_t y;
+    int16_t dx;           // net movement
+    int16_t dy;
+    uint32_t duration_ms;
+} touch_gesture_t;
+
+// Recognizer state for one touch surface; zero-initialise.
+typedef struct {
+    bool down;
+    bool long_sent;
+    int16_t x0, y0;       // press position
+    int16_t x, y;         // last position
+    int16_t ax, ay;       // last direction-reversal anchor
+    int8_t sx, sy;        // current movement direction per axis (-1, 0, 1)
+    uint8_t reversals;
+    uint32_t path;        // total distance travelled (px, Manhattan)
+    uint32_t t0_ms;
+} touch_gesture_state_t;
+
+// Feed one sample. Returns true and fills *out when a gesture is recognized.
+bool touch_gesture_feed(touch_gesture_state_t *st, bool pressed, int x, int y, uint32_t now_ms,
+                        touch_gesture_t *out);
+
+const char *touch_gesture_name(touch_gesture_type_t type);
+const char *touch_dir_name(touch_dir_t dir);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,234 @@
+#include "udp_ctl.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#ifndef CONFIG_LITTLEAI_UDP_CONTROL
+#define CONFIG_LITTLEAI_UDP_CONTROL 0
+#endif
+#ifndef CONFIG_LITTLEAI_UDP_PORT
+#define CONFIG_LITTLEAI_UDP_PORT 8082
+#endif
+#ifndef CONFIG_LITTLEAI_WS_TASK_CORE
+#define CONFIG_LITTLEAI_WS_TASK_CORE 0
+#endif
+#ifndef CONFIG_LITTLEAI_WS_TASK_PRIORITY
+#define CONFIG_LITTLEAI_WS_TASK_PRIORITY 5
+#endif
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static udp_ctl_stats_t s_stats; // guarded by s_lock
+
+#if CONFIG_LITTLEAI_UDP_CONTROL
+#include "lwip/sockets.h"
+
+#include "ws_server.h"
+
+static const char *TAG = "udp_ctl";
+
+#define UDP_TASK_CORE (CONFIG_LITTLEAI_WS_TASK_CORE < 0 ? tskNO_AFFINITY : CONFIG_LITTLEAI_WS_TASK_CORE)
+#define UDP_MAX_STREAMS 8
+// A stream not heard from for this long restarts: its next packet is taken whatever its seq,
+// so a host that restarts (and counts from 0 again) is not ignored.
+#define UDP_STREAM_IDLE_US (2 * 1000 * 1000)
+
+// Newest sequence number applied per (sender address, port, stream_id). Receiver task only.
+typedef struct {
+    bool used;
+    uint32_t addr;
+    uint16_t port;
+    uint16_t stream_id;
+    uint32_t seq;
+    int64_t last_us;
+} udp_stream_t;
+
+static udp_stream_t s_streams[UDP_MAX_STREAMS];
+static int s_sock = -1;
+
+// The entry for this sender and stream; a new one replaces the least recently heard.
+// Sets *fresh when the entry carries no usable seq (new or idle too long).
+static udp_stream_t *stream_get(uint32_t addr, uint16_t port, uint16_t id, int64_t now_us, bool *fresh) {
+    udp_stream_t *lru = &s_streams[0];
+    for (int i = 0; i < UDP_MAX_STREAMS; i++) {
+        udp_stream_t *s = &s_streams[i];
+        if (s->used && s->addr == addr && s->port == port && s->stream_id == id) {
+            *fresh = now_us - s->last_us > UDP_STREAM_IDLE_US;
+            return s;
+        }
+        if (!s->used || (lru->used && s->last_us < lru->last_us)) lru = s;
+    }
+    *lru = (udp_stream_t){.used = true, .addr = addr, .port = port, .stream_id = id};
+    *fresh = true;
+    return lru;
+}
+
+static uint8_t streams_active(int64_t now_us) {
+    uint8_t n = 0;
+    for (int i = 0; i < UDP_MAX_STREAMS; i++) {
+        n += s_streams[i].used && now_us - s_streams[i].last_us <= UDP_STREAM_IDLE_US;
+    }
+    return n;
+}
+
+static bool read_f32(const uint8_t **p, const uint8_t *end, float lo, float hi, float *out) {
+    if (end - *p < 4) return false;
+    float v;
+    memcpy(&v, *p, sizeof(v)); // little-endian on the wire and on the ESP32
+    *p += 4;
+    if (!isfinite(v)) return false;
+    *out = v < lo ? lo : (v > hi ? hi : v);
+    return true;
+}
+
+// Decode the values after the header. false if a group is short or a value is not finite.
+static bool parse_values(const udp_ctl_hdr_t *h, const uint8_t *p, const uint8_t *end, ws_stream_update_t *u) {
+    memset(u, 0, sizeof(*u));
+    if (h->fields & UDP_CTL_F_GAZE) {
+        if (!read_f32(&p, end, -1.0f, 1.0f, &u->gaze_x) || !read_f32(&p, end, -1.0f, 1.0f, &u->gaze_y)) return false;
+        u->mask |= WS_STREAM_GAZE;
+    }
+    if (h->fields & UDP_CTL_F_MOUTH) {
+        if (!read_f32(&p, end, 0.0f, 1.0f, &u->mouth_open)) return false;
+        u->mask |= WS_STREAM_MOUTH;
+    }
+    if (h->fields & UDP_CTL_F_EYES) {
+        if (!read_f32(&p, end, 0.0f, 1.0f, &u->eye_open)) return false;
+        u->mask |= WS_STREAM_EYES;
+    }
+    return u->mask != 0;
+}
+
+// One datagram: check it, drop it if a newer one from the same stream was applied, else
+// hand it to the WS task.
+static void handle_datagram(const uint8_t *buf, int n, const struct sockaddr_in *from) {
+    udp_ctl_hdr_t h;
+    ws_stream_update_t u;
+    if (n < UDP_CTL_HDR_LEN) goto malformed;
+    memcpy(&h, buf, sizeof(h));
+    if (h.magic != UDP_CTL_MAGIC || h.hdr_len < UDP_CTL_HDR_LEN || h.hdr_len > n) goto malformed;
+    if (!parse_values(&h, buf + h.hdr_len, buf + n, &u)) goto malformed;
+
+    const int64_t now_us = esp_timer_get_time();
+    bool fresh;
+    udp_stream_t *s = stream_get(from->sin_addr.s_addr, from->sin_port, h.stream_id, now_us, &fresh);
+    if (!fresh && (int32_t)(h.seq - s->seq) <= 0) {
+        portENTER_CRITICAL(&s_lock);
+        s_stats.stale++;
+        portEXIT_CRITICAL(&s_lock);
+        return;
+    }
+    s->seq = h.seq;
+    s->last_us = now_us;
+
+    bool coalesced = false;
+    const esp_err_t err = ws_server_submit_stream(&u, &coalesced);
+    const uint8_t active = streams_active(now_us);
+    portENTER_CRITICAL(&s_lock);
+    if (err == ESP_OK) {
+        s_stats.applied++;
+        if (coalesced) s_stats.coalesced++;
+    } else {
+        s_stats.busy++;
+    }
+    s_stats.streams = active;
+    portEXIT_CRITICAL(&s_lock);
+    return;
+
+malformed:
+    portENTER_CRITICAL(&s_lock);
+    s_stats.malformed++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void udp_task(void *param) {
+    (void)param;
+
+    // hdr_len is a byte, plus the largest value set; anything longer is truncated harmlessly.
+    uint8_t buf[256 + 16];
+    while (1) {
+        struct sockaddr_in from;
+        socklen_t fromlen = sizeof(from);
+        const int n = recvfrom(s_sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &fromlen);
+        if (n < 0) {
+            ESP_LOGW(TAG, "recvfrom failed");
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+        portENTER_CRITICAL(&s_lock);
+        s_stats.rx++;
+        portEXIT_CRITICAL(&s_lock);
+        handle_datagram(buf, n, &from);
+    }
+}
+
+esp_err_t udp_ctl_start(void) {
+    if (s_sock >= 0) return ESP_OK;
+
+    const int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "socket failed");
+        return ESP_FAIL;
+    }
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(CONFIG_LITTLEAI_UDP_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(TAG, "bind :%d failed", CONFIG_LITTLEAI_UDP_PORT);
+        close(sock);
+        return ESP_FAIL;
+    }
+
+    // Same priority and core as the /ws httpd task that applies the updates, so a stream
+    // can't starve face commands and the hand-off stays on one core.
+    s_sock = sock;
+    if (xTaskCreatePinnedToCore(udp_task, "udp_ctl", 3072, NULL, CONFIG_LITTLEAI_WS_TASK_PRIORITY, NULL,
+                                UDP_TASK_CORE) != pdPASS) {
+        close(sock);
+        s_sock = -1;
+        return ESP_ERR_NO_MEM;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.running = true;
+    s_stats.port = CONFIG_LITTLEAI_UDP_PORT;
+    portEXIT_CRITICAL(&s_lock);
+    ESP_LOGI(TAG, "UDP face channel on :%d", CONFIG_LITTLEAI_UDP_PORT);
+    return ESP_OK;
+}
+
+#else
+
+esp_err_t udp_ctl_start(void) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
+
+uint16_t udp_ctl_port(void) {
+    portENTER_CRITICAL(&s_lock);
+    const uint16_t port = s_stats.running ? s_stats.port : 0;
+    portEXIT_CRITICAL(&s_lock);
+    return port;
+}
+
+void udp_ctl_get_stats(udp_ctl_stats_t *out) {
+    portENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void udp_ctl_reset_stats(void) {
+    portENTER_CRITICAL(&s_lock);
+    const udp_ctl_stats_t keep = {.running = s_stats.running, .port = s_stats.port, .streams = s_stats.streams};
+    s_stats = keep;
+    portEXIT_CRITICAL(&s_lock);
+}
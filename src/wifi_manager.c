@@ -9,22 +9,58 @@
 
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_netif.h"
 #include "esp_wifi.h"
 #include "nvs.h"
 #include "nvs_flash.h"
 #include "esp_http_server.h"
 #include "esp_mac.h"
+#if CONFIG_LITTLEAI_WIFI_ROAMING
+#include "esp_wnm.h"
+#endif
 
 #include "lwip/inet.h"
 #include "lwip/sockets.h"
 
 static const char *TAG = "wifi_mgr";
 
+#ifndef CONFIG_LITTLEAI_DNS_TASK_CORE
+#define CONFIG_LITTLEAI_DNS_TASK_CORE 0
+#endif
+#ifndef CONFIG_LITTLEAI_DNS_TASK_PRIORITY
+#define CONFIG_LITTLEAI_DNS_TASK_PRIORITY 3
+#endif
+#define DNS_TASK_CORE (CONFIG_LITTLEAI_DNS_TASK_CORE < 0 ? tskNO_AFFINITY : CONFIG_LITTLEAI_DNS_TASK_CORE)
+
+#ifndef CONFIG_LITTLEAI_WIFI_PROFILE
+#define CONFIG_LITTLEAI_WIFI_PROFILE 0
+#endif
+#ifndef CONFIG_LITTLEAI_WIFI_BATTERY_LISTEN_INTERVAL
+#define CONFIG_LITTLEAI_WIFI_BATTERY_LISTEN_INTERVAL 10
+#endif
+#ifndef CONFIG_LITTLEAI_WIFI_ROAM_RSSI
+#define CONFIG_LITTLEAI_WIFI_ROAM_RSSI -70
+#endif
+
+// Immediate reconnect attempts after a drop before the setup portal is opened; after that the
+// watchdog keeps retrying every WIFI_WATCH_MS.
+#define WIFI_FAST_RETRIES 5
+#define WIFI_WATCH_MS 12000
+
 // NVS keys
 static const char *kNvsNs = "wifi";
 static const char *kKeySsid = "ssid";
 static const char *kKeyPass = "pass";
+static const char *kKeyProfile = "profile";
+static const char *kKeyAp = "ap"; // ap_cache_t blob
+
+// Last AP we got an IP from. Reconnecting with bssid + channel set makes the driver probe one
+// channel instead of scanning all of them.
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+} ap_cache_t;
 
 static esp_netif_t *s_netif_sta = NULL;
 static esp_netif_t *s_netif_ap = NULL;
@@ -32,6 +68,17 @@ static esp_netif_t *s_netif_ap = NULL;
 static bool s_connected = false;
 static char s_ip_str[16] = {0};
 
+static wifi_config_t s_sta_cfg;   // saved credentials, loaded once in connect_sta_from_saved()
+static bool s_have_creds = false;
+static wifi_profile_t s_profile = (wifi_profile_t)CONFIG_LITTLEAI_WIFI_PROFILE;
+static ap_cache_t s_ap_cache;
+static bool s_ap_cache_valid = false;
+static bool s_attempt_cached = false; // the attempt in flight targets s_ap_cache
+static int s_retries = 0;             // failed attempts since the last connect
+static int64_t s_attempt_us = 0;
+static int64_t s_up_us = 0;
+static wifi_stats_t s_stats;
+
 // Captive portal server state
 static httpd_handle_t s_httpd = NULL;
 static TaskHandle_t s_dns_task = NULL;
@@ -80,6 +127,38 @@ static esp_err_t nvs_set_wifi(const char *ssid, const char *pass) {
     return err;
 }
 
+static void ap_cache_load(void) {
+    nvs_handle_t h;
+    if (nvs_open(kNvsNs, NVS_READONLY, &h) != ESP_OK) return;
+    size_t len = sizeof(s_ap_cache);
+    s_ap_cache_valid = nvs_get_blob(h, kKeyAp, &s_ap_cache, &len) == ESP_OK && len == sizeof(s_ap_cache)
+                       && s_ap_cache.channel != 0;
+    uint8_t p = 0;
+    if (nvs_get_u8(h, kKeyProfile, &p) == ESP_OK && p < WIFI_PROFILE_COUNT) s_profile = (wifi_profile_t)p;
+    nvs_close(h);
+}
+
+// Only written when the AP changes, not on every reconnect.
+static void ap_cache_store(const uint8_t bssid[6], uint8_t channel) {
+    if (s_ap_cache_valid && s_ap_cache.channel == channel && memcmp(s_ap_cache.bssid, bssid, 6) == 0) return;
+    memcpy(s_ap_cache.bssid, bssid, 6);
+    s_ap_cache.channel = channel;
+    s_ap_cache_valid = true;
+
+    nvs_handle_t h;
+    if (nvs_open(kNvsNs, NVS_READWRITE, &h) != ESP_OK) return;
+    if (nvs_set_blob(h, kKeyAp, &s_ap_cache, sizeof(s_ap_cache)) == ESP_OK) nvs_commit(h);
+    nvs_close(h);
+}
+
+static void ap_cache_clear(void) {
+    s_ap_cache_valid = false;
+    nvs_handle_t h;
+    if (nvs_open(kNvsNs, NVS_READWRITE, &h) != ESP_OK) return;
+    if (nvs_erase_key(h, kKeyAp) == ESP_OK) nvs_commit(h);
+    nvs_close(h);
+}
+
 static void update_ip_cache(void) {
     if (!s_netif_sta) return;
     esp_netif_ip_info_t ip;
@@ -96,21 +175,155 @@ const char* wifi_manager_get_ip_str(void) {
     return s_connected ? s_ip_str : NULL;
 }
 
+// ---------- Profiles ----------
+
+static const char *const kProfileNames[WIFI_PROFILE_COUNT] = {"realtime", "balanced", "battery"};
+
+const char *wifi_profile_name(wifi_profile_t p) {
+    return (unsigned)p < WIFI_PROFILE_COUNT ? kProfileNames[p] : "unknown";
+}
+
+bool wifi_profile_from_name(const char *name, wifi_profile_t *out) {
+    if (!name || !out) return false;
+    for (int i = 0; i < WIFI_PROFILE_COUNT; i++) {
+        if (strcmp(name, kProfileNames[i]) == 0) {
+            *out = (wifi_profile_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static wifi_ps_type_t profile_ps(wifi_profile_t p) {
+    switch (p) {
+        case WIFI_PROFILE_REALTIME: return WIFI_PS_NONE;
+        case WIFI_PROFILE_BATTERY: return WIFI_PS_MAX_MODEM;
+        default: return WIFI_PS_MIN_MODEM;
+    }
+}
+
+// Beacon intervals between wakeups; only WIFI_PS_MAX_MODEM uses it.
+static uint16_t profile_listen_interval(wifi_profile_t p) {
+    return p == WIFI_PROFILE_BATTERY ? CONFIG_LITTLEAI_WIFI_BATTERY_LISTEN_INTERVAL : 1;
+}
+
+esp_err_t wifi_manager_set_profile(wifi_profile_t p) {
+    if ((unsigned)p >= WIFI_PROFILE_COUNT) return ESP_ERR_INVALID_ARG;
+    esp_err_t err = esp_wifi_set_ps(profile_ps(p));
+    if (err != ESP_OK) return err;
+    s_profile = p;
+    s_sta_cfg.sta.listen_interval = profile_listen_interval(p);
+    ESP_LOGI(TAG, "Wi-Fi profile: %s", wifi_profile_name(p));
+
+    nvs_handle_t h;
+    err = nvs_open(kNvsNs, NVS_READWRITE, &h);
+    if (err != ESP_OK) return err;
+    err = nvs_set_u8(h, kKeyProfile, (uint8_t)p);
+    if (err == ESP_OK) err = nvs_commit(h);
+    nvs_close(h);
+    return err;
+}
+
+wifi_profile_t wifi_manager_get_profile(void) {
+    return s_profile;
+}
+
+void wifi_manager_get_stats(wifi_stats_t *out) {
+    if (!out) return;
+    *out = s_stats;
+    out->connected = s_connected;
+    out->rssi = 0;
+    out->channel = 0;
+    memset(out->bssid, 0, sizeof(out->bssid));
+    out->uptime_ms = 0;
+
+    wifi_ap_record_t ap;
+    if (s_connected && esp_wifi_sta_get_ap_info(&ap) == ESP_OK) {
+        out->rssi = ap.rssi;
+        out->channel = ap.primary;
+        memcpy(out->bssid, ap.bssid, sizeof(out->bssid));
+        out->uptime_ms = (uint32_t)((esp_timer_get_time() - s_up_us) / 1000);
+    }
+}
+
+// ---------- Station ----------
+
+// One association attempt. The first attempt after a drop (or at boot) goes straight to the
+// cached AP; later ones, and the watchdog's, scan every channel and pick the strongest AP.
+static void sta_connect(void) {
+    if (!s_have_creds) return;
+
+    wifi_config_t cfg = s_sta_cfg;
+    s_attempt_cached = s_retries == 0 && s_ap_cache_valid;
+    if (s_attempt_cached) {
+        cfg.sta.bssid_set = 1;
+        memcpy(cfg.sta.bssid, s_ap_cache.bssid, sizeof(cfg.sta.bssid));
+        cfg.sta.channel = s_ap_cache.channel;
+    } else {
+        cfg.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        cfg.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
+
+    esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, &cfg);
+    if (err == ESP_OK) err = esp_wifi_connect();
+    if (err != ESP_OK) {
+        // Usually ESP_ERR_WIFI_CONN: an attempt is already in flight.
+        ESP_LOGD(TAG, "esp_wifi_connect: %s", esp_err_to_name(err));
+        return;
+    }
+    s_attempt_us = esp_timer_get_time();
+}
+
 static void wifi_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
     if (event_base == WIFI_EVENT) {
-        if (event_id == WIFI_EVENT_STA_DISCONNECTED) {
-            ESP_LOGW(TAG, "STA disconnected");
+        if (event_id == WIFI_EVENT_STA_CONNECTED) {
+            const wifi_event_sta_connected_t *ev = (const wifi_event_sta_connected_t *)event_data;
+            ap_cache_store(ev->bssid, ev->channel);
+        } else if (event_id == WIFI_EVENT_STA_DISCONNECTED) {
+            const wifi_event_sta_disconnected_t *ev = (const wifi_event_sta_disconnected_t *)event_data;
+            ESP_LOGW(TAG, "STA disconnected (reason %u)%s", ev->reason, s_attempt_cached ? ", cached AP" : "");
+            if (s_connected) s_stats.disconnects++;
+            s_stats.last_reason = ev->reason;
             s_connected = false;
-            // Reopen portal if we lose Wi-Fi after boot
-            start_softap_portal();
+
+            // Reconnect right away instead of waiting for the watchdog; open the portal only
+            // once a few attempts in a row have failed.
+            if (s_retries < WIFI_FAST_RETRIES) {
+                sta_connect();
+                s_retries++;
+            } else if (s_retries == WIFI_FAST_RETRIES) {
+                s_retries++;
+                start_softap_portal();
+            }
+#if CONFIG_LITTLEAI_WIFI_ROAMING
+        } else if (event_id == WIFI_EVENT_STA_BSS_RSSI_LOW) {
+            // Ask the AP to steer us to a better BSS (802.11v); the supplicant handles the reply.
+            const wifi_event_bss_rssi_low_t *ev = (const wifi_event_bss_rssi_low_t *)event_data;
+            ESP_LOGI(TAG, "RSSI low (%d dBm)", (int)ev->rssi);
+            if (esp_wnm_is_btm_supported_connection() &&
+                esp_wnm_send_bss_transition_mgmt_query(REASON_FRAME_LOSS, NULL, 0) == 0) {
+                s_stats.roam_queries++;
+            }
+            esp_wifi_set_rssi_threshold(CONFIG_LITTLEAI_WIFI_ROAM_RSSI); // one-shot; re-arm
+#endif
         }
     }
 
     if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
-        ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&event->ip_info.ip));
+        const int64_t now = esp_timer_get_time();
+        s_stats.connects++;
+        if (s_attempt_cached) s_stats.fast_connects++;
+        s_stats.last_connect_ms = s_attempt_us ? (uint32_t)((now - s_attempt_us) / 1000) : 0;
+        ESP_LOGI(TAG, "Got IP: " IPSTR " (%u ms%s)", IP2STR(&event->ip_info.ip), (unsigned)s_stats.last_connect_ms,
+                 s_attempt_cached ? ", cached AP" : "");
+        s_up_us = now;
+        s_retries = 0;
         s_connected = true;
         update_ip_cache();
+#if CONFIG_LITTLEAI_WIFI_ROAMING
+        esp_wifi_set_rssi_threshold(CONFIG_LITTLEAI_WIFI_ROAM_RSSI);
+#endif
 
         stop_softap_portal();
     }
@@ -344,6 +557,7 @@ static esp_err_t handle_save(httpd_req_t *req) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Save failed");
         return ESP_OK;
     }
+    ap_cache_clear(); // possibly a different network
 
     httpd_resp_set_type(req, "text/html");
     httpd_resp_sendstr(req, "<html><body><h3>Saved. Connecting...</h3><p>You can close this page.</p></body></html>");
@@ -438,7 +652,8 @@ static void start_softap_portal(void) {
     start_httpd();
 
     if (!s_dns_task) {
-        xTaskCreate(dns_task, "dns", 4096, NULL, 3, &s_dns_task);
+        xTaskCreatePinnedToCore(dns_task, "dns", 4096, NULL, CONFIG_LITTLEAI_DNS_TASK_PRIORITY, &s_dns_task,
+                                DNS_TASK_CORE);
     }
 
     ESP_LOGI(TAG, "AP SSID: %s", ap_ssid);
@@ -479,11 +694,20 @@ static void connect_sta_from_saved(void) {
     wifi_config_t cfg = {0};
     strncpy((char*)cfg.sta.ssid, ssid, sizeof(cfg.sta.ssid));
     if (pass) strncpy((char*)cfg.sta.password, pass, sizeof(cfg.sta.password));
+    cfg.sta.listen_interval = profile_listen_interval(s_profile);
+#if CONFIG_LITTLEAI_WIFI_ROAMING
+    cfg.sta.rm_enabled = 1;  // 802.11k neighbor reports
+    cfg.sta.btm_enabled = 1; // 802.11v BSS transition management
+#endif
 
-    ESP_LOGI(TAG, "Connecting STA to '%s'", ssid);
+    ESP_LOGI(TAG, "Connecting STA to '%s'%s", ssid, s_ap_cache_valid ? " (cached AP)" : "");
 
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &cfg));
-    esp_wifi_connect();
+    // New credentials from the portal replace any attempt still in flight.
+    if (s_have_creds) esp_wifi_disconnect();
+    s_sta_cfg = cfg;
+    s_have_creds = true;
+    s_retries = 0;
+    sta_connect();
 
     free(ssid);
     if (pass) free(pass);
@@ -495,10 +719,11 @@ static void connect_sta_from_saved(void) {
 
 static void wifi_watchdog_task(void *arg) {
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(12000));
+        vTaskDelay(pdMS_TO_TICKS(WIFI_WATCH_MS));
         if (!wifi_manager_is_connected()) {
             ESP_LOGW(TAG, "Not connected; ensuring AP portal is running");
             start_softap_portal();
+            sta_connect();
         }
     }
 }
@@ -517,6 +742,10 @@ void wifi_manager_start(void) {
     wifi_init_config_t wifi_init_cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&wifi_init_cfg));
 
+    ap_cache_load();
+    ESP_ERROR_CHECK(esp_wifi_set_ps(profile_ps(s_profile)));
+    ESP_LOGI(TAG, "Wi-Fi profile: %s", wifi_profile_name(s_profile));
+
     ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL, NULL));
     ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL, NULL));
 
@@ -0,0 +1,488 @@
+#include "ws_json.h"
+
+#include <string.h>
+#include <math.h>
+
+#define JSON_MAX_DEPTH 8
+
+// ---------- Tokenizer ----------
+
+static void skip_ws(const json_doc_t *d, size_t *p) {
+    while (*p < d->len) {
+        const char c = d->js[*p];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+        (*p)++;
+    }
+}
+
+static int new_tok(json_doc_t *d, json_type_t type, size_t start) {
+    if (d->ntok >= d->cap) return -1;
+    json_tok_t *t = &d->tok[d->ntok];
+    t->type = (uint8_t)type;
+    t->escaped = 0;
+    t->next = 0;
+    t->start = (uint32_t)start;
+    t->end = (uint32_t)start;
+    return d->ntok++;
+}
+
+static bool is_hex(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool parse_string(json_doc_t *d, size_t *p) {
+    const int idx = new_tok(d, JSON_STRING, *p + 1);
+    if (idx < 0) return false;
+
+    size_t i = *p + 1;
+    while (i < d->len) {
+        const char c = d->js[i];
+        if (c == '"') break;
+        if ((unsigned char)c < 0x20) return false;
+        if (c == '\\') {
+            d->tok[idx].escaped = 1;
+            if (++i >= d->len) return false;
+            if (d->js[i] == 'u') {
+                if (i + 4 >= d->len) return false;
+                for (int k = 1; k <= 4; k++) {
+                    if (!is_hex(d->js[i + k])) return false;
+                }
+                i += 4;
+            } else if (!strchr("\"\\/bfnrt", d->js[i])) {
+                return false;
+            }
+        }
+        i++;
+    }
+    if (i >= d->len) return false;
+
+    d->tok[idx].end = (uint32_t)i;
+    d->tok[idx].next = (uint16_t)d->ntok;
+    *p = i + 1;
+    return true;
+}
+
+static bool parse_number(json_doc_t *d, size_t *p) {
+    const int idx = new_tok(d, JSON_NUMBER, *p);
+    if (idx < 0) return false;
+
+    size_t i = *p;
+    if (i < d->len && d->js[i] == '-') i++;
+    if (i >= d->len || !is_digit(d->js[i])) return false;
+    while (i < d->len && is_digit(d->js[i])) i++;
+    if (i < d->len && d->js[i] == '.') {
+        i++;
+        if (i >= d->len || !is_digit(d->js[i])) return false;
+        while (i < d->len && is_digit(d->js[i])) i++;
+    }
+    if (i < d->len && (d->js[i] == 'e' || d->js[i] == 'E')) {
+        i++;
+        if (i < d->len && (d->js[i] == '+' || d->js[i] == '-')) i++;
+        if (i >= d->len || !is_digit(d->js[i])) return false;
+        while (i < d->len && is_digit(d->js[i])) i++;
+    }
+
+    d->tok[idx].end = (uint32_t)i;
+    d->tok[idx].next = (uint16_t)d->ntok;
+    *p = i;
+    return true;
+}
+
+static bool parse_literal(json_doc_t *d, size_t *p, const char *lit, json_type_t type) {
+    const size_t n = strlen(lit);
+    if (*p + n > d->len || memcmp(d->js + *p, lit, n) != 0) return false;
+    const int idx = new_tok(d, type, *p);
+    if (idx < 0) return false;
+    *p += n;
+    d->tok[idx].end = (uint32_t)*p;
+    d->tok[idx].next = (uint16_t)d->ntok;
+    return true;
+}
+
+static bool parse_value(json_doc_t *d, size_t *p, int depth);
+
+static bool parse_container(json_doc_t *d, size_t *p, int depth, bool object) {
+    if (depth >= JSON_MAX_DEPTH) return false;
+    const int idx = new_tok(d, object ? JSON_OBJECT : JSON_ARRAY, *p);
+    if (idx < 0) return false;
+    const char close = object ? '}' : ']';
+
+    (*p)++;
+    skip_ws(d, p);
+    if (*p < d->len && d->js[*p] == close) {
+        (*p)++;
+    } else {
+        while (1) {
+            if (object) {
+                skip_ws(d, p);
+                if (*p >= d->len || d->js[*p] != '"' || !parse_string(d, p)) return false;
+                skip_ws(d, p);
+                if (*p >= d->len || d->js[*p] != ':') return false;
+                (*p)++;
+            }
+            if (!parse_value(d, p, depth + 1)) return false;
+            skip_ws(d, p);
+            if (*p >= d->len) return false;
+            if (d->js[*p] == ',') {
+                (*p)++;
+                continue;
+            }
+            if (d->js[*p] != close) return false;
+            (*p)++;
+            break;
+        }
+    }
+
+    d->tok[idx].end = (uint32_t)*p;
+    d->tok[idx].next = (uint16_t)d->ntok;
+    return true;
+}
+
+static bool parse_value(json_doc_t *d, size_t *p, int depth) {
+    skip_ws(d, p);
+    if (*p >= d->len) return false;
+
+    const char c = d->js[*p];
+    switch (c) {
+        case '{': return parse_container(d, p, depth, true);
+        case '[': return parse_container(d, p, depth, false);
+        case '"': return parse_string(d, p);
+        case 't': return parse_literal(d, p, "true", JSON_TRUE);
+        case 'f': return parse_literal(d, p, "false", JSON_FALSE);
+        case 'n': return parse_literal(d, p, "null", JSON_NULL);
+        default:
+            if (c == '-' || is_digit(c)) return parse_number(d, p);
+            return false;
+    }
+}
+
+bool json_parse(json_doc_t *d, const char *js, size_t len, json_tok_t *tok, int cap) {
+    d->js = js;
+    d->len = len;
+    d->tok = tok;
+    d->ntok = 0;
+    d->cap = cap > UINT16_MAX ? UINT16_MAX : cap;
+
+    size_t p = 0;
+    if (!parse_value(d, &p, 0)) {
+        d->ntok = 0;
+        return false;
+    }
+    skip_ws(d, &p);
+    if (p != len) {
+        d->ntok = 0;
+        return false;
+    }
+    return true;
+}
+
+// ---------- Accessors ----------
+
+int json_get(const json_doc_t *d, int obj, const char *key) {
+    if (!json_is(d, obj, JSON_OBJECT)) return -1;
+
+    const int end = d->tok[obj].next;
+    int i = obj + 1;
+    while (i + 1 < end) {
+        if (json_eq(d, i, key)) return i + 1;
+        i = d->tok[i + 1].next;
+    }
+    return -1;
+}
+
+bool json_eq(const json_doc_t *d, int i, const char *s) {
+    if (!json_is(d, i, JSON_STRING) || d->tok[i].escaped) return false;
+    const size_t n = d->tok[i].end - d->tok[i].start;
+    return strlen(s) == n && memcmp(d->js + d->tok[i].start, s, n) == 0;
+}
+
+const char *json_raw(const json_doc_t *d, int i, size_t *len) {
+    if (!json_is(d, i, JSON_STRING)) return NULL;
+    if (len) *len = d->tok[i].end - d->tok[i].start;
+    return d->js + d->tok[i].start;
+}
+
+bool json_number(const json_doc_t *d, int i, double *out) {
+    if (!json_is(d, i, JSON_NUMBER)) return false;
+
+    // The tokenizer already validated the syntax.
+    const char *s = d->js + d->tok[i].start;
+    const char *e = d->js + d->tok[i].end;
+    bool neg = false;
+    double v = 0.0;
+
+    if (*s == '-') {
+        neg = true;
+        s++;
+    }
+    while (s < e && is_digit(*s)) v = v * 10.0 + (*s++ - '0');
+    if (s < e && *s == '.') {
+        double scale = 0.1;
+        for (s++; s < e && is_digit(*s); s++) {
+            v += (*s - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+    if (s < e && (*s == 'e' || *s == 'E')) {
+        s++;
+        bool eneg = false;
+        if (*s == '+' || *s == '-') eneg = (*s++ == '-');
+        int ex = 0;
+        while (s < e && is_digit(*s) && ex < 400) ex = ex * 10 + (*s++ - '0');
+        v *= pow(10.0, eneg ? -ex : ex);
+    }
+
+    *out = neg ? -v : v;
+    return true;
+}
+
+static int hex_val(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return c - 'A' + 10;
+}
+
+static uint32_t read_u4(const char *s) {
+    return (uint32_t)((hex_val(s[0]) << 12) | (hex_val(s[1]) << 8) | (hex_val(s[2]) << 4) | hex_val(s[3]));
+}
+
+bool json_strcpy(const json_doc_t *d, int i, char *dst, size_t cap) {
+    if (!cap) return false;
+    dst[0] = 0;
+    if (!json_is(d, i, JSON_STRING)) return false;
+
+    const char *s = d->js + d->tok[i].start;
+    const char *e = d->js + d->tok[i].end;
+    size_t n = 0;
+
+    while (s < e) {
+        char tmp[4];
+        size_t k = 1;
+        if (*s != '\\') {
+            tmp[0] = *s++;
+        } else {
+            s++;
+            const char c = *s++;
+            switch (c) {
+                case 'b': tmp[0] = '\b'; break;
+                case 'f': tmp[0] = '\f'; break;
+                case 'n': tmp[0] = '\n'; break;
+                case 'r': tmp[0] = '\r'; break;
+                case 't': tmp[0] = '\t'; break;
+                case 'u': {
+                    uint32_t cp = read_u4(s);
+                    s += 4;
+                    if (cp >= 0xD800 && cp < 0xDC00 && e - s >= 6 && s[0] == '\\' && s[1] == 'u') {
+                        const uint32_t lo = read_u4(s + 2);
+                        if (lo >= 0xDC00 && lo < 0xE000) {
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                            s += 6;
+                        }
+                    }
+                    if (cp < 0x80) {
+                        tmp[0] = (char)cp;
+                    } else if (cp < 0x800) {
+                        tmp[0] = (char)(0xC0 | (cp >> 6));
+                        tmp[1] = (char)(0x80 | (cp & 0x3F));
+                        k = 2;
+                    } else if (cp < 0x10000) {
+                        tmp[0] = (char)(0xE0 | (cp >> 12));
+                        tmp[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                        tmp[2] = (char)(0x80 | (cp & 0x3F));
+                        k = 3;
+                    } else {
+                        tmp[0] = (char)(0xF0 | (cp >> 18));
+                        tmp[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+                        tmp[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                        tmp[3] = (char)(0x80 | (cp & 0x3F));
+                        k = 4;
+                    }
+                    break;
+                }
+                default: tmp[0] = c; break; // \" \\ \/
+            }
+        }
+        if (n + k >= cap) break;
+        memcpy(dst + n, tmp, k);
+        n += k;
+    }
+    dst[n] = 0;
+    return true;
+}
+
+// ---------- Writer ----------
+
+static void put(json_out_t *o, const char *s, size_t n) {
+    if (o->overflow) return;
+    if (o->len + n >= o->cap) {
+        o->overflow = true;
+        return;
+    }
+    memcpy(o->buf + o->len, s, n);
+    o->len += n;
+}
+
+static void put_c(json_out_t *o, char c) {
+    put(o, &c, 1);
+}
+
+static void put_escaped(json_out_t *o, const char *s) {
+    put_c(o, '"');
+    for (; *s; s++) {
+        const unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            const char esc[2] = {'\\', (char)c};
+            put(o, esc, 2);
+        } else if (c < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            const char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+            put(o, esc, 6);
+        } else {
+            put_c(o, (char)c);
+        }
+    }
+    put_c(o, '"');
+}
+
+static void put_sep(json_out_t *o) {
+    const uint8_t bit = (uint8_t)(1u << o->depth);
+    if (!(o->first & bit)) put_c(o, ',');
+    o->first &= (uint8_t)~bit;
+}
+
+static void put_key(json_out_t *o, const char *key) {
+    put_sep(o);
+    put_escaped(o, key);
+    put_c(o, ':');
+}
+
+static void put_u64(json_out_t *o, uint64_t v) {
+    char tmp[20];
+    size_t n = 0;
+    do {
+        tmp[sizeof(tmp) - 1 - n++] = (char)('0' + (v % 10));
+        v /= 10;
+    } while (v && n < sizeof(tmp));
+    put(o, tmp + sizeof(tmp) - n, n);
+}
+
+void json_out_init(json_out_t *o, char *buf, size_t cap) {
+    o->buf = buf;
+    o->cap = cap;
+    o->len = 0;
+    o->depth = 0;
+    o->first = 1;
+    o->arr = 0;
+    o->overflow = false;
+    put_c(o, '{');
+}
+
+void json_out_str(json_out_t *o, const char *key, const char *val) {
+    put_key(o, key);
+    put_escaped(o, val ? val : "");
+}
+
+static void put_i64(json_out_t *o, int64_t val) {
+    if (val < 0) {
+        put_c(o, '-');
+        put_u64(o, (uint64_t)(-(val + 1)) + 1);
+    } else {
+        put_u64(o, (uint64_t)val);
+    }
+}
+
+void json_out_int(json_out_t *o, const char *key, int64_t val) {
+    put_key(o, key);
+    put_i64(o, val);
+}
+
+void json_out_item_int(json_out_t *o, int64_t val) {
+    put_sep(o);
+    put_i64(o, val);
+}
+
+void json_out_float(json_out_t *o, const char *key, float val) {
+    put_key(o, key);
+    if (!isfinite(val)) {
+        put(o, "null", 4);
+        return;
+    }
+
+    const bool neg = val < 0.0f;
+    const double a = fabs((double)val);
+    if (a >= 1e14) {
+        if (neg) put_c(o, '-');
+        put_u64(o, (uint64_t)a);
+        return;
+    }
+
+    const uint64_t scaled = (uint64_t)(a * 10000.0 + 0.5);
+    if (neg && scaled) put_c(o, '-');
+    put_u64(o, scaled / 10000);
+
+    uint32_t frac = (uint32_t)(scaled % 10000);
+    if (frac) {
+        char tmp[5] = {'.', 0, 0, 0, 0};
+        for (int k = 4; k >= 1; k--) {
+            tmp[k] = (char)('0' + frac % 10);
+            frac /= 10;
+        }
+        size_t n = 5;
+        while (tmp[n - 1] == '0') n--;
+        put(o, tmp, n);
+    }
+}
+
+void json_out_bool(json_out_t *o, const char *key, bool val) {
+    put_key(o, key);
+    if (val) put(o, "true", 4);
+    else put(o, "false", 5);
+}
+
+static void open_nested(json_out_t *o, const char *key, bool array) {
+    if (o->depth >= 7) {
+        o->overflow = true;
+        return;
+    }
+    if (key) put_key(o, key);
+    else put_sep(o);
+    put_c(o, array ? '[' : '{');
+    o->depth++;
+    const uint8_t bit = (uint8_t)(1u << o->depth);
+    o->first |= bit;
+    if (array) o->arr |= bit;
+    else o->arr &= (uint8_t)~bit;
+}
+
+void json_out_obj(json_out_t *o, const char *key) {
+    open_nested(o, key, false);
+}
+
+void json_out_arr(json_out_t *o, const char *key) {
+    open_nested(o, key, true);
+}
+
+void json_out_item_obj(json_out_t *o) {
+    open_nested(o, NULL, false);
+}
+
+void json_out_close(json_out_t *o) {
+    if (o->depth == 0) return;
+    put_c(o, (o->arr & (1u << o->depth)) ? ']' : '}');
+    o->depth--;
+}
+
+size_t json_out_finish(json_out_t *o) {
+    while (o->depth > 0) json_out_close(o);
+    put_c(o, '}');
+    if (o->overflow) {
+        if (o->cap) o->buf[0] = 0;
+        return 0;
+    }
+    o->buf[o->len] = 0;
+    return o->len;
+}
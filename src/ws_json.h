@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Minimal JSON tokenizer + writer for the WS command path. Nothing here allocates: the
+// tokenizer fills a caller-provided token array (jsmn-style, tokens point into the source
+// text) and the writer appends into a caller-provided buffer.
+
+typedef enum {
+    JSON_NONE = 0,
+    JSON_OBJECT,
+    JSON_ARRAY,
+    JSON_STRING,
+    JSON_NUMBER,
+    JSON_TRUE,
+    JSON_FALSE,
+    JSON_NULL,
+} json_type_t;
+
+typedef struct {
+    uint8_t type;     // json_type_t
+    uint8_t escaped;  // string contains backslash escapes
+    uint16_t next;    // index of the first token after this value (skips nested values)
+    uint32_t start;   // byte offset of the value (strings: first char after the quote)
+    uint32_t end;     // one past the last byte (strings: the closing quote)
+} json_tok_t;
+
+typedef struct {
+    const char *js;
+    size_t len;
+    json_tok_t *tok;
+    int ntok;
+    int cap;
+} json_doc_t;
+
+// Tokenize `len` bytes of `js` into tok[cap]. Token 0 is the root value.
+// Returns false on malformed input, nesting deeper than 8 or more than `cap` tokens.
+bool json_parse(json_doc_t *d, const char *js, size_t len, json_tok_t *tok, int cap);
+
+// Value token for `key` in object token `obj`, or -1.
+int json_get(const json_doc_t *d, int obj, const char *key);
+
+static inline bool json_is(const json_doc_t *d, int i, json_type_t t) {
+    return i >= 0 && i < d->ntok && d->tok[i].type == t;
+}
+static inline bool json_is_true(const json_doc_t *d, int i) { return json_is(d, i, JSON_TRUE); }
+static inline bool json_is_bool(const json_doc_t *d, int i) {
+    return json_is(d, i, JSON_TRUE) || json_is(d, i, JSON_FALSE);
+}
+
+// String token equals `s` (raw comparison; escaped strings never match).
+bool json_eq(const json_doc_t *d, int i, const char *s);
+
+// Number token value; false if `i` is not a number.
+bool json_number(const json_doc_t *d, int i, double *out);
+
+// Raw bytes of a string token (escapes not decoded); NULL if not a string.
+const char *json_raw(const json_doc_t *d, int i, size_t *len);
+
+// Decode a string token into dst[cap] (always NUL-terminated, truncated to fit).
+// Returns false if `i` is not a string.
+bool json_strcpy(const json_doc_t *d, int i, char *dst, size_t cap);
+
+// ---------- Writer ----------
+
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t len;
+    uint8_t depth;
+    uint8_t first;    // bit n set: nothing written yet at depth n
+    uint8_t arr;      // bit n set: depth n is an array
+    bool overflow;
+} json_out_t;
+
+// Start a top-level object in buf[cap].
+void json_out_init(json_out_t *o, char *buf, size_t cap);
+
+void json_out_str(json_out_t *o, const char *key, const char *val);
+void json_out_int(json_out_t *o, const char *key, int64_t val);
+void json_out_float(json_out_t *o, const char *key, float val); // up to 4 decimals
+void json_out_bool(json_out_t *o, const char *key, bool val);
+
+// Open a nested object / array under `key`; close it with json_out_close().
+void json_out_obj(json_out_t *o, const char *key);
+void json_out_arr(json_out_t *o, const char *key);
+void json_out_item_int(json_out_t *o, int64_t val); // array element
+void json_out_item_obj(json_out_t *o);              // object array element; close with json_out_close()
+void json_out_close(json_out_t *o);
+
+// Close any open objects and NUL-terminate. Returns the text length, or 0 if it didn't fit.
+size_t json_out_finish(json_out_t *o);
+
+#ifdef __cplusplus
+}
+#endif
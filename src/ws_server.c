@@ -1,26 +1,196 @@
 #include "ws_server.h"
 
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
+#include "freertos/task.h"
 
 #include "esp_log.h"
+#include "esp_check.h"
 #include "esp_timer.h"
 #include "esp_http_server.h"
+#include "esp_heap_caps.h"
 
 #include "mbedtls/base64.h"
 
-#include "cJSON.h"
-
+#include "assets.h"
 #include "audio.h"
+#include "audio_resample.h"
+#include "face_sprites.h"
+#include "i2c_bus.h"
+#include "ota.h"
+#include "perf.h"
+#include "udp_ctl.h"
+#include "wifi_manager.h"
+#include "ws_json.h"
 
 static const char *TAG = "ws";
 
-static httpd_handle_t s_httpd = NULL;
-static face_state_t *s_face = NULL;
-static SemaphoreHandle_t s_face_mux = NULL;
+static httpd_handle_t s_httpd = NULL;       // control lane: /ws on :8080
+static httpd_handle_t s_audio_httpd = NULL; // audio lane: /ws/audio on :8081
+static face_store_t *s_face = NULL;
+// Working copy of the face state. Only the /ws httpd task touches it: commands edit it in place
+// and publish it to s_face, so neither side ever waits for the other.
+static face_state_t s_draft;
+// Scratch snapshot for replies and pushes (/ws httpd task only).
+static face_state_t s_view;
+static void (*s_on_face_changed)(void) = NULL;
+
+#define WS_MAX_FRAME_LEN 16384 // text (JSON) frames; binary frames are streamed and unbounded
+#define WS_RX_SLICE 4096       // binary frames are read this much at a time (multiple of 4)
+#define WS_MAX_TOKENS 256
+#define WS_OUT_LEN 3072 // "tasks" lists every FreeRTOS task
+#define WS_PUSH_OUT_LEN 1536
+#define WS_PCM_LEN ((WS_MAX_FRAME_LEN / 4) * 3 + 8)
+
+#ifndef CONFIG_LITTLEAI_WS_TASK_CORE
+#define CONFIG_LITTLEAI_WS_TASK_CORE 0
+#endif
+#ifndef CONFIG_LITTLEAI_WS_TASK_PRIORITY
+#define CONFIG_LITTLEAI_WS_TASK_PRIORITY 5
+#endif
+#ifndef CONFIG_LITTLEAI_WS_AUDIO_TASK_PRIORITY
+#define CONFIG_LITTLEAI_WS_AUDIO_TASK_PRIORITY 4
+#endif
+#ifndef CONFIG_LITTLEAI_WS_PUSH_MAX_HZ
+#define CONFIG_LITTLEAI_WS_PUSH_MAX_HZ 10
+#endif
+#ifndef CONFIG_LITTLEAI_WS_MAX_CLIENTS
+#define CONFIG_LITTLEAI_WS_MAX_CLIENTS 6
+#endif
+
+// Connections on /ws. The server keeps one more socket than this so a newcomer can always
+// get in; taking it closes the idlest connection that is not a controller (see ws_open).
+#define WS_MAX_CLIENTS CONFIG_LITTLEAI_WS_MAX_CLIENTS
+// /ws/audio connections (speech streams); when full, httpd closes the least recently used.
+#define WS_AUDIO_MAX_CLIENTS 3
+#define WS_AUDIO_TOKENS 32
+#define WS_AUDIO_OUT_LEN 1024
+#define WS_LIST_MAX (WS_MAX_CLIENTS + 1 > WS_AUDIO_MAX_CLIENTS ? WS_MAX_CLIENTS + 1 : WS_AUDIO_MAX_CLIENTS)
+
+// State push subscribers (every /ws connection may subscribe).
+#define WS_MAX_SUBS WS_MAX_CLIENTS
+
+// How long a speech chunk may wait for playback-queue space before we nack it. Acks go out
+// as soon as audio is queued, so this is the only place the WS task can stall on audio.
+#define WS_AUDIO_ENQUEUE_TIMEOUT_MS 1000
+
+// One httpd server and its message buffers. Each lane's handlers run on that server's own task
+// and every frame is received, parsed and answered within one handler call, so one set per lane
+// serves all of its connections and the steady-state command path never touches the heap.
+// Speech on /ws/audio runs on a lower-priority task than /ws, so a speech chunk waiting for
+// queue space never holds up a gaze update behind it.
+typedef struct {
+    bool control;     // /ws: every command, OTA and state pushes; otherwise /ws/audio (WS_CMD_AUDIO only)
+    perf_id_t perf;   // handler timing
+    uint8_t *rx_buf;  // incoming frame (text or binary), PSRAM; allocated in ws_server_start()
+    uint8_t *pcm_buf; // base64-decoded speech payload, PSRAM
+    json_tok_t *tok;
+    int tok_cap;
+    char *out;
+    size_t out_cap;
+} ws_lane_t;
+
+static json_tok_t s_tok[WS_MAX_TOKENS];
+static char s_out[WS_OUT_LEN];
+static json_tok_t s_audio_tok[WS_AUDIO_TOKENS];
+static char s_audio_out[WS_AUDIO_OUT_LEN];
+static char s_push_out[WS_PUSH_OUT_LEN];
+
+static ws_lane_t s_ctl_lane = {
+    .control = true,
+    .perf = PERF_WS_HANDLER,
+    .tok = s_tok,
+    .tok_cap = WS_MAX_TOKENS,
+    .out = s_out,
+    .out_cap = WS_OUT_LEN,
+};
+static ws_lane_t s_audio_lane = {
+    .perf = PERF_WS_AUDIO,
+    .tok = s_audio_tok,
+    .tok_cap = WS_AUDIO_TOKENS,
+    .out = s_audio_out,
+    .out_cap = WS_AUDIO_OUT_LEN,
+};
+
+// The lane is the URI handler's user_ctx.
+static ws_lane_t *lane_of(httpd_req_t *req) {
+    return (ws_lane_t *)req->user_ctx;
+}
+
+// Reply policy, per connection (session command) or per message ("ack" field).
+typedef enum {
+    WS_ACK_FULL = 0, // ack + face state dump (default)
+    WS_ACK_MINIMAL,  // ack without the state dump
+    WS_ACK_NONE,     // fire-and-forget: no reply (queries like ping/get_state still answer)
+} ws_ack_mode_t;
+
+// What a /ws connection may do. Observers only read (WS_CMD_READ commands) and get state
+// pushes; controllers are never closed to make room for a new connection.
+typedef enum {
+    WS_ROLE_AUTO = 0,   // default: becomes a controller with its first command that changes anything
+    WS_ROLE_CONTROLLER,
+    WS_ROLE_OBSERVER,
+} ws_role_t;
+
+// Per-connection state, kept in the httpd session context.
+typedef struct {
+    int fd;
+    ws_ack_mode_t ack;
+    ws_role_t role;     // /ws only
+    int64_t last_rx_us; // last frame received (eviction order)
+} ws_session_t;
+
+// A subscribed connection and the state it was last sent (deltas are computed against it).
+typedef struct {
+    bool active;
+    int fd;
+    uint32_t interval_ms;
+    int64_t last_push_us;
+    face_state_t sent;
+    uint8_t sent_expired; // FACE_TTL_* bits already cleared in `sent`
+    bool touch;           // also wants touch gesture events
+} ws_sub_t;
+
+static ws_sub_t s_subs[WS_MAX_SUBS];
+static esp_timer_handle_t s_push_timer = NULL;
+static portMUX_TYPE s_push_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_push_queued = false;
+
+// Touch gestures waiting to be pushed: queued by the LVGL task, drained on the httpd task.
+// Guarded by s_push_lock; when full, the oldest event is dropped.
+#define WS_EVENT_QUEUE 8
+
+typedef struct {
+    touch_gesture_t g;
+    uint32_t ts_ms;
+} ws_touch_event_t;
+
+static ws_touch_event_t s_events[WS_EVENT_QUEUE];
+static uint8_t s_event_head = 0;
+static uint8_t s_event_count = 0;
+static bool s_event_queued = false;
+
+// Stream updates waiting to be applied: merged by ws_server_submit_stream(), drained on the
+// httpd task. Guarded by s_push_lock.
+static ws_stream_update_t s_stream;
+static bool s_stream_queued = false;
+
+// One command being handled.
+typedef struct {
+    httpd_req_t *req;
+    const char *name;      // command name (table entry)
+    const json_doc_t *doc; // parsed message
+    int obj;               // token of the command object (root, or a batch entry)
+    json_out_t *out;       // reply being built
+    ws_lane_t *lane;
+    ws_session_t *sess;
+    ws_ack_mode_t ack;
+    bool ok;               // outcome, as written to the reply
+    uint32_t now;
+} ws_cmd_t;
 
 static const char* expr_to_str(expression_t e) {
     switch (e) {
@@ -35,19 +205,14 @@ static const char* expr_to_str(expression_t e) {
     }
 }
 
-static bool str_eq(const char *a, const char *b) {
-    return a && b && strcmp(a, b) == 0;
-}
-
-static expression_t parse_expr(const char *s) {
-    if (!s) return EXPR_NEUTRAL;
-    if (str_eq(s, "neutral")) return EXPR_NEUTRAL;
-    if (str_eq(s, "happy")) return EXPR_HAPPY;
-    if (str_eq(s, "sad")) return EXPR_SAD;
-    if (str_eq(s, "angry")) return EXPR_ANGRY;
-    if (str_eq(s, "surprised")) return EXPR_SURPRISED;
-    if (str_eq(s, "thinking")) return EXPR_THINKING;
-    if (str_eq(s, "sleeping")) return EXPR_SLEEPING;
+static expression_t parse_expr(const json_doc_t *d, int tok) {
+    if (json_eq(d, tok, "neutral")) return EXPR_NEUTRAL;
+    if (json_eq(d, tok, "happy")) return EXPR_HAPPY;
+    if (json_eq(d, tok, "sad")) return EXPR_SAD;
+    if (json_eq(d, tok, "angry")) return EXPR_ANGRY;
+    if (json_eq(d, tok, "surprised")) return EXPR_SURPRISED;
+    if (json_eq(d, tok, "thinking")) return EXPR_THINKING;
+    if (json_eq(d, tok, "sleeping")) return EXPR_SLEEPING;
     return EXPR_NEUTRAL;
 }
 
@@ -61,47 +226,1698 @@ static uint32_t now_ms(void) {
     return (uint32_t)(esp_timer_get_time() / 1000);
 }
 
-static cJSON* face_to_json(const face_state_t *f) {
-    cJSON *o = cJSON_CreateObject();
-    cJSON_AddStringToObject(o, "expression", expr_to_str(f->expression));
-    cJSON_AddNumberToObject(o, "intensity", f->intensity);
-    cJSON_AddNumberToObject(o, "gaze_x", f->gaze_x);
-    cJSON_AddNumberToObject(o, "gaze_y", f->gaze_y);
-    cJSON_AddNumberToObject(o, "eye_open", f->eye_open);
-    cJSON_AddBoolToObject(o, "eye_open_override", f->eye_open_override);
-    cJSON_AddNumberToObject(o, "mouth_open", f->mouth_open);
-    cJSON_AddBoolToObject(o, "mouth_open_override", f->mouth_open_override);
+// Latest published state as clients should see it (TTLs that ran out already cleared).
+// Returns the FACE_TTL_* bits that expired.
+static uint8_t face_view(face_state_t *out) {
+    face_store_read(s_face, out);
+    return face_state_expire(out, now_ms());
+}
+
+// Make the edited working copy visible to the renderer and other readers.
+static void face_publish(void) {
+    s_draft.version++;
+    face_store_publish(s_face, &s_draft);
+}
+
+// Field accessors on object token `obj` (0 = message root).
+static bool get_num(const json_doc_t *d, int obj, const char *key, double *out) {
+    return json_number(d, json_get(d, obj, key), out);
+}
+
+static bool get_unit(const json_doc_t *d, int obj, const char *key, float lo, float hi, float *out) {
+    double v;
+    if (!get_num(d, obj, key, &v)) return false;
+    *out = clampf((float)v, lo, hi);
+    return true;
+}
+
+static bool get_bool(const json_doc_t *d, int obj, const char *key, bool *out) {
+    const int i = json_get(d, obj, key);
+    if (!json_is_bool(d, i)) return false;
+    *out = json_is_true(d, i);
+    return true;
+}
+
+static const char *ack_mode_str(ws_ack_mode_t m) {
+    switch (m) {
+        case WS_ACK_MINIMAL: return "minimal";
+        case WS_ACK_NONE: return "none";
+        default: return "full";
+    }
+}
+
+// "ack": true | false | "full" | "minimal" | "none". Returns false if absent or unrecognized.
+static bool parse_ack_mode(const json_doc_t *d, int obj, ws_ack_mode_t *out) {
+    const int i = json_get(d, obj, "ack");
+    if (json_is_bool(d, i)) {
+        *out = json_is_true(d, i) ? WS_ACK_FULL : WS_ACK_NONE;
+        return true;
+    }
+    if (json_eq(d, i, "full")) { *out = WS_ACK_FULL; return true; }
+    if (json_eq(d, i, "minimal")) { *out = WS_ACK_MINIMAL; return true; }
+    if (json_eq(d, i, "none")) { *out = WS_ACK_NONE; return true; }
+    return false;
+}
+
+static const char *role_str(ws_role_t r) {
+    switch (r) {
+        case WS_ROLE_CONTROLLER: return "controller";
+        case WS_ROLE_OBSERVER: return "observer";
+        default: return "auto";
+    }
+}
+
+static ws_sub_t *sub_find(int fd) {
+    for (int i = 0; i < WS_MAX_SUBS; i++) {
+        if (s_subs[i].active && s_subs[i].fd == fd) return &s_subs[i];
+    }
+    return NULL;
+}
+
+static void unsubscribe_fd(int fd) {
+    for (int i = 0; i < WS_MAX_SUBS; i++) {
+        if (s_subs[i].active && s_subs[i].fd == fd) s_subs[i].active = false;
+    }
+}
+
+// Runs on the lane's httpd task when the connection closes. /ws/audio connections never
+// subscribe, and fds are unique across both servers, so the unsubscribe is a no-op there.
+static void session_free(void *ctx) {
+    ws_session_t *sess = (ws_session_t *)ctx;
+    if (sess) unsubscribe_fd(sess->fd);
+    free(sess);
+}
+
+static ws_session_t *session_new(int fd) {
+    ws_session_t *sess = (ws_session_t *)calloc(1, sizeof(ws_session_t));
+    if (!sess) return NULL;
+    sess->fd = fd;
+    sess->last_rx_us = esp_timer_get_time();
+    return sess;
+}
+
+static ws_session_t *get_session(httpd_req_t *req) {
+    // /ws connections get theirs in ws_open(), /ws/audio ones on their first frame; httpd
+    // frees it when the socket closes.
+    if (!req->sess_ctx) {
+        ws_session_t *sess = session_new(httpd_req_to_sockfd(req));
+        if (!sess) return NULL;
+        req->sess_ctx = sess;
+        req->free_ctx = session_free;
+    }
+    return (ws_session_t *)req->sess_ctx;
+}
+
+// open_fn of the /ws server. Its max_open_sockets leaves one spare slot: when a connection
+// takes it, the longest-idle connection that is not a controller is closed so the next one
+// can get in too. If every other connection is a controller the newcomer is refused instead,
+// so one client opening idle sockets can't push another client's controller out (httpd's own
+// LRU purge closes whichever socket has been quiet longest).
+static esp_err_t ws_open(httpd_handle_t hd, int fd) {
+    ws_session_t *sess = session_new(fd);
+    if (!sess) return ESP_ERR_NO_MEM;
+    httpd_sess_set_ctx(hd, fd, sess, session_free);
+
+    size_t n = WS_LIST_MAX;
+    int fds[WS_LIST_MAX];
+    if (httpd_get_client_list(hd, &n, fds) != ESP_OK || n <= WS_MAX_CLIENTS) return ESP_OK;
+
+    int victim = -1;
+    int64_t oldest = INT64_MAX;
+    for (size_t i = 0; i < n; i++) {
+        if (fds[i] == fd) continue;
+        const ws_session_t *s = (const ws_session_t *)httpd_sess_get_ctx(hd, fds[i]);
+        if (s && s->role == WS_ROLE_CONTROLLER) continue;
+        const int64_t t = s ? s->last_rx_us : 0;
+        if (t < oldest) {
+            oldest = t;
+            victim = fds[i];
+        }
+    }
+    if (victim < 0) {
+        ESP_LOGW(TAG, "fd %d refused: all %d connections are controllers", fd, WS_MAX_CLIENTS);
+        return ESP_FAIL; // httpd closes the socket and frees `sess`
+    }
+    ESP_LOGI(TAG, "fd %d: closing idle fd %d to make room", fd, victim);
+    httpd_sess_trigger_close(hd, victim);
+    return ESP_OK;
+}
+
+static void add_face_state(json_out_t *o, const face_state_t *f) {
+    json_out_obj(o, "state");
+    json_out_int(o, "version", f->version);
+    json_out_str(o, "expression", expr_to_str(f->expression));
+    json_out_float(o, "intensity", f->intensity);
+    json_out_float(o, "gaze_x", f->gaze_x);
+    json_out_float(o, "gaze_y", f->gaze_y);
+    json_out_float(o, "eye_open", f->eye_open);
+    json_out_bool(o, "eye_open_override", f->eye_open_override);
+    json_out_float(o, "mouth_open", f->mouth_open);
+    json_out_bool(o, "mouth_open_override", f->mouth_open_override);
 
-    cJSON_AddStringToObject(o, "caption", f->caption);
-    cJSON_AddNumberToObject(o, "caption_until_ms", (double)f->caption_until_ms);
-    cJSON_AddStringToObject(o, "viseme", f->viseme);
-    cJSON_AddNumberToObject(o, "viseme_weight", f->viseme_weight);
-    cJSON_AddNumberToObject(o, "viseme_until_ms", (double)f->viseme_until_ms);
-    cJSON_AddNumberToObject(o, "blink_until_ms", (double)f->blink_until_ms);
-    return o;
+    json_out_str(o, "caption", f->caption);
+    json_out_int(o, "caption_until_ms", f->caption_until_ms);
+    json_out_str(o, "viseme", f->viseme);
+    json_out_float(o, "viseme_weight", f->viseme_weight);
+    json_out_int(o, "viseme_until_ms", f->viseme_until_ms);
+    json_out_int(o, "blink_until_ms", f->blink_until_ms);
+    json_out_close(o);
 }
 
-static esp_err_t send_json(httpd_req_t *req, cJSON *obj) {
-    char *s = cJSON_PrintUnformatted(obj);
-    if (!s) return ESP_ERR_NO_MEM;
+static esp_err_t send_reply(httpd_req_t *req, json_out_t *o) {
+    size_t len = json_out_finish(o);
+    if (len == 0) {
+        ESP_LOGW(TAG, "reply did not fit in %u bytes", (unsigned)o->cap);
+        json_out_init(o, o->buf, o->cap);
+        json_out_bool(o, "ok", false);
+        json_out_str(o, "error", "reply_too_large");
+        len = json_out_finish(o);
+    }
 
     httpd_ws_frame_t frame = {
         .type = HTTPD_WS_TYPE_TEXT,
-        .payload = (uint8_t *)s,
-        .len = strlen(s),
+        .payload = (uint8_t *)o->buf,
+        .len = len,
     };
+    return httpd_ws_send_frame(req, &frame);
+}
+
+static void add_ack(json_out_t *o, const char *cmd, bool ok) {
+    json_out_bool(o, "ok", ok);
+    json_out_str(o, "type", "ack");
+    json_out_str(o, "cmd", cmd);
+}
+
+static void set_ok(ws_cmd_t *c, bool ok) {
+    c->ok = ok;
+    json_out_bool(c->out, "ok", ok);
+}
+
+static void add_cmd_ack(ws_cmd_t *c, bool ok) {
+    set_ok(c, ok);
+    json_out_str(c->out, "type", "ack");
+    json_out_str(c->out, "cmd", c->name);
+}
+
+static void add_audio_queue_info(json_out_t *o) {
+    audio_stats_t st;
+    if (audio_get_stats(&st) == ESP_OK) {
+        json_out_int(o, "queued_ms", st.queued_ms);
+    }
+}
+
+static const char *audio_err_str(esp_err_t e) {
+    switch (e) {
+        case ESP_ERR_TIMEOUT: return "audio_queue_full";
+        case ESP_ERR_NOT_SUPPORTED: return "unsupported_codec";
+        case ESP_ERR_INVALID_ARG: return "bad_payload";
+        default: return esp_err_to_name(e);
+    }
+}
+
+// 0 = output rate; anything else must be within what the playout resampler handles.
+static bool sample_rate_ok(double hz) {
+    return hz == 0 || (hz >= AUDIO_RESAMPLE_MIN_RATE && hz <= AUDIO_RESAMPLE_MAX_RATE);
+}
+
+static esp_err_t send_bin_ack(httpd_req_t *req, const speak_frame_hdr_t *hdr, const char *error) {
+    const ws_session_t *sess = get_session(req);
+    if (!error && sess && sess->ack == WS_ACK_NONE) return ESP_OK;
+
+    const ws_lane_t *lane = lane_of(req);
+    json_out_t o;
+    json_out_init(&o, lane->out, lane->out_cap);
+    add_ack(&o, "speak_bin", error == NULL);
+    if (hdr) {
+        json_out_int(&o, "stream", hdr->stream_id);
+        json_out_int(&o, "seq", hdr->seq);
+    }
+    if (error) json_out_str(&o, "error", error);
+    add_audio_queue_info(&o);
+    return send_reply(req, &o);
+}
 
-    esp_err_t err = httpd_ws_send_frame(req, &frame);
-    free(s);
+// Read the next `n` payload bytes of the frame whose header ws_handle_frame() already consumed.
+// With frame.len non-zero httpd_ws_recv_frame() skips the header and unmasks from mask offset 0,
+// so every slice but the frame's last must be a multiple of 4 bytes (WS_RX_SLICE is).
+static esp_err_t ws_recv_slice(httpd_req_t *req, uint8_t *dst, size_t n) {
+    httpd_ws_frame_t f = {
+        .type = HTTPD_WS_TYPE_BINARY,
+        .payload = dst,
+        .len = n,
+    };
+    esp_err_t err = httpd_ws_recv_frame(req, &f, n);
+    if (err != ESP_OK) ESP_LOGW(TAG, "ws recv (slice) failed: %s", esp_err_to_name(err));
     return err;
 }
 
-static esp_err_t ws_handler(httpd_req_t *req) {
-    if (req->method == HTTP_GET) {
-        ESP_LOGI(TAG, "WS handshake OK");
-        return ESP_OK;
+// Drop the rest of a frame we are not going to use, so the next read starts on a frame header.
+static esp_err_t ws_discard(httpd_req_t *req, size_t left) {
+    uint8_t *const rx = lane_of(req)->rx_buf;
+    while (left > 0) {
+        const size_t n = left < WS_RX_SLICE ? left : WS_RX_SLICE;
+        ESP_RETURN_ON_ERROR(ws_recv_slice(req, rx, n), TAG, "discard");
+        left -= n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t send_ota_ack(httpd_req_t *req, const char *error) {
+    const ws_session_t *sess = get_session(req);
+    if (!error && sess && sess->ack == WS_ACK_NONE) return ESP_OK;
+
+    ota_status_t st;
+    ota_get_status(&st);
+    json_out_t o;
+    json_out_init(&o, s_ctl_lane.out, s_ctl_lane.out_cap);
+    add_ack(&o, "ota_data", error == NULL);
+    json_out_int(&o, "offset", st.written);
+    json_out_int(&o, "size", st.size);
+    if (error) json_out_str(&o, "error", error);
+    return send_reply(req, &o);
+}
+
+static const char *ota_err_str(esp_err_t e) {
+    switch (e) {
+        case ESP_ERR_INVALID_STATE: return "no_update";
+        case ESP_ERR_INVALID_ARG: return "bad_offset";
+        case ESP_ERR_INVALID_SIZE: return "too_large";
+        case ESP_ERR_NOT_FOUND: return "no_ota_slot";
+        case ESP_ERR_INVALID_CRC: return "sha256_mismatch";
+        default: return esp_err_to_name(e);
+    }
+}
+
+// Firmware image frame: every slice goes straight to esp_ota_write(). `have` bytes (header
+// included) are already in the /ws rx buffer, `left` are still on the socket.
+static esp_err_t handle_ota_frame(httpd_req_t *req, size_t have, size_t left) {
+    uint8_t *const rx = s_ctl_lane.rx_buf;
+    ota_frame_hdr_t hdr = {0};
+    memcpy(&hdr, rx, have < sizeof(hdr) ? have : sizeof(hdr));
+    const char *error = NULL;
+    if (have < OTA_FRAME_HDR_LEN || hdr.hdr_len < OTA_FRAME_HDR_LEN || hdr.hdr_len > have) {
+        error = "bad_header";
+    } else {
+        uint32_t off = hdr.offset;
+        size_t n = have - hdr.hdr_len;
+        const uint8_t *p = rx + hdr.hdr_len;
+        for (;;) {
+            esp_err_t oe = ota_write(off, p, n);
+            if (oe != ESP_OK) {
+                error = ota_err_str(oe);
+                break;
+            }
+            off += n;
+            if (left == 0) break;
+            n = left < WS_RX_SLICE ? left : WS_RX_SLICE;
+            esp_err_t err = ws_recv_slice(req, rx, n);
+            if (err != ESP_OK) return err;
+            left -= n;
+            p = rx;
+        }
+    }
+    ESP_RETURN_ON_ERROR(ws_discard(req, left), TAG, "ota frame");
+    return send_ota_ack(req, error);
+}
+
+// Binary speech chunk: fixed header + PCM16/ADPCM/Opus payload, queued without any JSON/base64 step.
+// The frame is read in WS_RX_SLICE pieces and every run of whole decode units goes straight into
+// the playback queue, so frame size is unbounded and RAM use is one slice plus a partial unit.
+static esp_err_t handle_binary_frame(httpd_req_t *req, size_t frame_len) {
+    const ws_lane_t *lane = lane_of(req);
+    uint8_t *const rx = lane->rx_buf;
+    size_t have = frame_len < WS_RX_SLICE ? frame_len : WS_RX_SLICE;
+    size_t left = frame_len - have; // still on the socket
+    esp_err_t err = ws_recv_slice(req, rx, have);
+    if (err != ESP_OK) return err;
+    if (lane->control && rx[0] == OTA_FRAME_MAGIC) return handle_ota_frame(req, have, left);
+
+    const char *error = NULL;
+    const speak_frame_hdr_t *ack_hdr = NULL; // stream/seq are echoed once the header is sane
+    speak_frame_hdr_t hdr = {0};
+    memcpy(&hdr, rx, have < sizeof(hdr) ? have : sizeof(hdr));
+    ws_session_t *sess = get_session(req);
+    if (rx[0] == OTA_FRAME_MAGIC) {
+        error = "wrong_lane"; // firmware goes to /ws
+    } else if (sess && sess->role == WS_ROLE_OBSERVER) {
+        error = "observer";
+    } else if (frame_len < SPEAK_FRAME_HDR_MIN_LEN) {
+        error = "short_frame";
+    } else if (hdr.magic != SPEAK_FRAME_MAGIC || hdr.hdr_len < SPEAK_FRAME_HDR_MIN_LEN || hdr.hdr_len > have) {
+        error = "bad_header";
+    } else {
+        // Fields past hdr_len are payload bytes from an older host.
+        if (hdr.hdr_len < sizeof(hdr)) memset((uint8_t *)&hdr + hdr.hdr_len, 0, sizeof(hdr) - hdr.hdr_len);
+        ack_hdr = &hdr;
+        if (!audio_codec_supported((audio_codec_t)hdr.codec)) {
+            error = "unsupported_codec";
+        } else if (!sample_rate_ok(hdr.sample_rate)) {
+            error = "unsupported_rate";
+        } else if (frame_len == hdr.hdr_len && !(hdr.flags & SPEAK_FLAG_END)) {
+            error = "empty_payload";
+        }
+    }
+    if (error) {
+        ESP_RETURN_ON_ERROR(ws_discard(req, left), TAG, "binary frame");
+        return send_bin_ack(req, ack_hdr, error);
+    }
+
+    if (sess && sess->role == WS_ROLE_AUTO && lane->control) sess->role = WS_ROLE_CONTROLLER;
+
+    audio_chunk_info_t info = {
+        .stream_id = hdr.stream_id,
+        .seq = hdr.seq,
+        .codec = hdr.codec,
+        .sample_rate = hdr.sample_rate,
+    };
+    if (hdr.hdr_len >= SPEAK_FRAME_HDR_TIMED_LEN) {
+        info.flags |= AUDIO_CHUNK_F_TIMED;
+        info.ts_ms = hdr.ts_ms;
+    }
+    const bool end = hdr.flags & SPEAK_FLAG_END;
+
+    // The payload is copied into the playback queue, so its alignment here doesn't matter.
+    have -= hdr.hdr_len;
+    memmove(rx, rx + hdr.hdr_len, have);
+
+    bool started = false;
+    bool dropped = false;
+    for (;;) {
+        const bool last = left == 0;
+        // Mid-frame, hold back a trailing partial ADPCM block / Opus packet until the next slice.
+        const size_t n = last ? have : audio_codec_unit_prefix((audio_codec_t)info.codec, rx, have);
+        if (n > 0 || (last && end)) {
+            audio_chunk_info_t part = info;
+            if (started) part.flags |= AUDIO_CHUNK_F_CONT;
+            if (last && end) part.flags |= AUDIO_CHUNK_F_END;
+            esp_err_t ae = audio_enqueue_chunk(&part, rx, n, WS_AUDIO_ENQUEUE_TIMEOUT_MS, &dropped);
+            started = true;
+            if (ae != ESP_OK) {
+                error = audio_err_str(ae);
+                break;
+            }
+            if (dropped) break;
+            have -= n;
+            memmove(rx, rx + n, have);
+        }
+        if (last) break;
+
+        if (have + WS_RX_SLICE > WS_MAX_FRAME_LEN) {
+            // A "unit" longer than the buffer: garbage Opus framing.
+            error = "bad_payload";
+            break;
+        }
+        const size_t r = left < WS_RX_SLICE ? left : WS_RX_SLICE;
+        err = ws_recv_slice(req, rx + have, r);
+        if (err != ESP_OK) return err;
+        left -= r;
+        have += r;
+    }
+
+    ESP_RETURN_ON_ERROR(ws_discard(req, left), TAG, "binary frame");
+    return send_bin_ack(req, &hdr, error ? error : (dropped ? "dropped" : NULL));
+}
+
+// ---------- Commands ----------
+
+static void cmd_ping(ws_cmd_t *c) {
+    set_ok(c, true);
+    json_out_str(c->out, "type", "pong");
+    json_out_int(c->out, "ts_ms", c->now);
+}
+
+static void cmd_get_state(ws_cmd_t *c) {
+    set_ok(c, true);
+    json_out_str(c->out, "type", "state");
+    if (s_face) {
+        face_view(&s_view);
+        add_face_state(c->out, &s_view);
+    } else {
+        json_out_str(c->out, "error", "face_unavailable");
+    }
+}
+
+static void cmd_beep(ws_cmd_t *c) {
+    double freq = 880, dur = 140;
+    get_num(c->doc, c->obj, "freq_hz", &freq);
+    get_num(c->doc, c->obj, "duration_ms", &dur);
+    esp_err_t ae = audio_beep((int)freq, (int)dur);
+    add_cmd_ack(c, ae == ESP_OK);
+    if (ae != ESP_OK) json_out_str(c->out, "error", esp_err_to_name(ae));
+}
+
+static void cmd_audio_flush(ws_cmd_t *c) {
+    // Cancel speech: drop queued audio and stop the current chunk.
+    audio_flush();
+    add_cmd_ack(c, true);
+}
+
+static void cmd_audio_stats(ws_cmd_t *c) {
+    audio_stats_t st;
+    esp_err_t ae = audio_get_stats(&st);
+    set_ok(c, ae == ESP_OK);
+    json_out_str(c->out, "type", "audio_stats");
+    if (ae == ESP_OK) {
+        audio_jitter_config_t jc;
+        audio_get_jitter_config(&jc);
+        json_out_int(c->out, "queued_ms", st.queued_ms);
+        json_out_int(c->out, "capacity_ms", st.capacity_ms);
+        json_out_int(c->out, "target_ms", jc.target_ms);
+        json_out_int(c->out, "underruns", st.underruns);
+        json_out_int(c->out, "late", st.late_chunks);
+        json_out_int(c->out, "dropped", st.dropped_chunks);
+        json_out_int(c->out, "concealed_ms", st.concealed_ms);
+    } else {
+        json_out_str(c->out, "error", esp_err_to_name(ae));
+    }
+    bool reset = false;
+    if (get_bool(c->doc, c->obj, "reset", &reset) && reset) audio_reset_stats();
+}
+
+// {"type":"udp_stats","reset":false}: UDP face channel counters (see udp_ctl.h).
+static void cmd_udp_stats(ws_cmd_t *c) {
+    udp_ctl_stats_t st;
+    udp_ctl_get_stats(&st);
+    set_ok(c, true);
+    json_out_str(c->out, "type", "udp_stats");
+    json_out_bool(c->out, "running", st.running);
+    json_out_int(c->out, "port", st.port);
+    json_out_int(c->out, "rx", st.rx);
+    json_out_int(c->out, "applied", st.applied);
+    json_out_int(c->out, "stale", st.stale);
+    json_out_int(c->out, "malformed", st.malformed);
+    json_out_int(c->out, "coalesced", st.coalesced);
+    json_out_int(c->out, "busy", st.busy);
+    json_out_int(c->out, "streams", st.streams);
+    bool reset = false;
+    if (get_bool(c->doc, c->obj, "reset", &reset) && reset) udp_ctl_reset_stats();
+}
+
+// {"type":"perf","reset":false}: render/flush/WS/audio timing counters.
+// Time stats are in microseconds; "hist" counts samples per perf_hist_bounds_us bucket.
+// "sprites" is the face sprite cache (count, PSRAM bytes).
+static void cmd_perf(ws_cmd_t *c) {
+    set_ok(c, true);
+    json_out_str(c->out, "type", "perf");
+    json_out_int(c->out, "uptime_ms", (int64_t)(esp_timer_get_time() / 1000));
+
+    json_out_arr(c->out, "hist_bounds_us");
+    for (int i = 0; i < PERF_HIST_BUCKETS - 1; i++) json_out_item_int(c->out, perf_hist_bounds_us[i]);
+    json_out_close(c->out);
+
+    for (int id = 0; id < PERF_ID_COUNT; id++) {
+        perf_stat_t st;
+        perf_get((perf_id_t)id, &st);
+        json_out_obj(c->out, perf_name((perf_id_t)id));
+        json_out_int(c->out, "count", st.count);
+        json_out_int(c->out, "avg", st.count ? (int64_t)(st.total / st.count) : 0);
+        json_out_int(c->out, "max", st.max);
+        if (perf_is_time((perf_id_t)id)) {
+            json_out_arr(c->out, "hist");
+            for (int b = 0; b < PERF_HIST_BUCKETS; b++) json_out_item_int(c->out, st.hist[b]);
+            json_out_close(c->out);
+        }
+        json_out_close(c->out);
+    }
+
+    uint32_t sprites = 0, sprite_bytes = 0;
+    face_sprites_usage(&sprites, &sprite_bytes);
+    json_out_obj(c->out, "sprites");
+    json_out_int(c->out, "count", sprites);
+    json_out_int(c->out, "bytes", sprite_bytes);
+    json_out_close(c->out);
+
+    bool reset = false;
+    if (get_bool(c->doc, c->obj, "reset", &reset) && reset) perf_reset();
+}
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+#define WS_MAX_TASKS 40
+
+static const char *task_state_str(eTaskState s) {
+    switch (s) {
+        case eRunning: return "run";
+        case eReady: return "ready";
+        case eBlocked: return "blocked";
+        case eSuspended: return "suspended";
+        case eDeleted: return "deleted";
+        default: return "?";
+    }
+}
+#endif
+
+// {"type":"tasks"}: every FreeRTOS task with priority, core, free stack (bytes) and, with
+// CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS, "cpu" = % of one core used since the previous call.
+static void cmd_tasks(ws_cmd_t *c) {
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    static TaskStatus_t tasks[WS_MAX_TASKS];
+    static struct {
+        UBaseType_t num;
+        uint32_t run;
+    } prev[WS_MAX_TASKS];
+    static int nprev;
+    static uint32_t prev_total;
+
+    uint32_t total = 0;
+    const UBaseType_t n = uxTaskGetSystemState(tasks, WS_MAX_TASKS, &total);
+    if (n == 0) {
+        set_ok(c, false);
+        json_out_str(c->out, "type", "tasks");
+        json_out_str(c->out, "error", "too_many_tasks");
+        return;
+    }
+
+    set_ok(c, true);
+    json_out_str(c->out, "type", "tasks");
+    json_out_int(c->out, "count", n);
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    const uint32_t dt = total - prev_total;
+    json_out_int(c->out, "window_ms", (nprev ? dt : total) / 1000);
+#endif
+    json_out_arr(c->out, "tasks");
+    for (UBaseType_t i = 0; i < n; i++) {
+        const TaskStatus_t *t = &tasks[i];
+        const BaseType_t core = xTaskGetCoreID(t->xHandle);
+        json_out_item_obj(c->out);
+        json_out_str(c->out, "name", t->pcTaskName);
+        json_out_int(c->out, "prio", t->uxCurrentPriority);
+        json_out_int(c->out, "core", core == tskNO_AFFINITY ? -1 : core);
+        json_out_str(c->out, "state", task_state_str(t->eCurrentState));
+        json_out_int(c->out, "stack_free", t->usStackHighWaterMark);
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+        uint32_t run = t->ulRunTimeCounter;
+        for (int k = 0; k < nprev; k++) {
+            if (prev[k].num == t->xTaskNumber) {
+                run -= prev[k].run;
+                break;
+            }
+        }
+        const uint32_t window = nprev ? dt : total;
+        json_out_float(c->out, "cpu", window ? 100.0f * (float)run / (float)window : 0.0f);
+#endif
+        json_out_close(c->out);
+    }
+    json_out_close(c->out);
+
+    nprev = (int)n;
+    for (UBaseType_t i = 0; i < n; i++) {
+        prev[i].num = tasks[i].xTaskNumber;
+        prev[i].run = tasks[i].ulRunTimeCounter;
+    }
+    prev_total = total;
+#else
+    set_ok(c, false);
+    json_out_str(c->out, "type", "tasks");
+    json_out_str(c->out, "error", "trace_facility_disabled");
+#endif
+}
+
+// {"type":"volume","percent":60,"mix":{"tone":40}}; "percent" is the speaker volume, "mix"
+// the per-voice gains (speech, clip, tone). Without either it just reports the current values.
+static void cmd_volume(ws_cmd_t *c) {
+    float pct;
+    esp_err_t ae = ESP_OK;
+    if (get_unit(c->doc, c->obj, "percent", 0.0f, 100.0f, &pct)) ae = audio_set_volume((int)(pct + 0.5f));
+    const int mix = json_get(c->doc, c->obj, "mix");
+    for (int v = 0; v < AUDIO_VOICE_COUNT; v++) {
+        if (json_is(c->doc, mix, JSON_OBJECT) &&
+            get_unit(c->doc, mix, audio_voice_name((audio_voice_t)v), 0.0f, 100.0f, &pct)) {
+            audio_set_voice_gain((audio_voice_t)v, (int)(pct + 0.5f));
+        }
+    }
+    add_cmd_ack(c, ae == ESP_OK);
+    json_out_int(c->out, "percent", audio_get_volume());
+    json_out_obj(c->out, "mix");
+    for (int v = 0; v < AUDIO_VOICE_COUNT; v++) {
+        json_out_int(c->out, audio_voice_name((audio_voice_t)v), audio_get_voice_gain((audio_voice_t)v));
+    }
+    json_out_close(c->out);
+    if (ae != ESP_OK) json_out_str(c->out, "error", esp_err_to_name(ae));
+}
+
+// {"type":"play_clip","id":"chime","flush":false}: play a sound clip from the asset pack over
+// any speech; "id" is the clip name or its index in the pack. "flush" cuts off speech first.
+static void cmd_play_clip(ws_cmd_t *c) {
+    const json_doc_t *d = c->doc;
+    const int id_tok = json_get(d, c->obj, "id");
+    asset_t a;
+    bool found = false;
+    double idx;
+    if (json_is(d, id_tok, JSON_STRING)) {
+        char name[ASSET_NAME_LEN];
+        json_strcpy(d, id_tok, name, sizeof(name));
+        found = assets_find(name, ASSET_CLIP, &a);
+    } else if (json_number(d, id_tok, &idx)) {
+        found = assets_get((int)idx, &a) && a.type == ASSET_CLIP;
+    }
+    if (!found) {
+        add_cmd_ack(c, false);
+        json_out_str(c->out, "error", assets_count() ? "unknown_clip" : "no_assets");
+        return;
+    }
+    if (a.param != (uint32_t)audio_get_sample_rate()) {
+        add_cmd_ack(c, false);
+        json_out_str(c->out, "error", "bad_sample_rate");
+        return;
+    }
+
+    bool flush = false;
+    get_bool(d, c->obj, "flush", &flush);
+    if (flush) audio_flush();
+
+    // Mixed straight from mapped flash on the clip voice.
+    esp_err_t ae = audio_play_clip(a.data, a.size, (audio_codec_t)a.codec);
+    add_cmd_ack(c, ae == ESP_OK);
+    json_out_str(c->out, "id", a.name);
+    if (ae != ESP_OK) json_out_str(c->out, "error", audio_err_str(ae));
+}
+
+// {"type":"assets"}: contents of the asset pack.
+static void cmd_assets(ws_cmd_t *c) {
+    set_ok(c, true);
+    json_out_str(c->out, "type", "assets");
+    json_out_arr(c->out, "assets");
+    asset_t a;
+    for (int i = 0; assets_get(i, &a); i++) {
+        json_out_item_obj(c->out);
+        json_out_int(c->out, "id", i);
+        json_out_str(c->out, "name", a.name);
+        json_out_str(c->out, "kind", asset_type_name(a.type));
+        json_out_int(c->out, "size", (int64_t)a.size);
+        if (a.type == ASSET_CLIP) {
+            json_out_str(c->out, "codec", audio_codec_name((audio_codec_t)a.codec));
+            json_out_int(c->out, "sample_rate", a.param);
+        }
+        json_out_close(c->out);
+    }
+    json_out_close(c->out);
+}
+
+// {"type":"audio_bench","ms":1000}: CPU cost of the audio output stage (see audio_bench()).
+static void cmd_audio_bench(ws_cmd_t *c) {
+    double ms = 1000;
+    get_num(c->doc, c->obj, "ms", &ms);
+    audio_bench_t b;
+    esp_err_t ae = audio_bench((uint32_t)ms, &b);
+    set_ok(c, ae == ESP_OK);
+    json_out_str(c->out, "type", "audio_bench");
+    if (ae != ESP_OK) {
+        json_out_str(c->out, "error", esp_err_to_name(ae));
+        return;
+    }
+    json_out_int(c->out, "audio_ms", b.audio_ms);
+    json_out_int(c->out, "cpu_mhz", b.cpu_mhz);
+    json_out_bool(c->out, "mono_slot", b.mono_slot);
+    const struct { const char *name; uint32_t cycles; int bytes_per_frame; } cases[] = {
+        {"stereo_copy", b.stereo_copy, 4},
+        {"mono", b.mono, 2},
+        {"mono_mixed", b.mono_mixed, 2},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        json_out_obj(c->out, cases[i].name);
+        json_out_int(c->out, "cycles_per_s", cases[i].cycles);
+        json_out_float(c->out, "cpu_pct", (float)cases[i].cycles / ((float)b.cpu_mhz * 10000.0f));
+        json_out_int(c->out, "dma_bytes_per_s", (int64_t)audio_get_sample_rate() * cases[i].bytes_per_frame);
+        json_out_close(c->out);
+    }
+}
+
+// {"type":"i2c_stats","reset":false}: per-device transaction counters on the shared I2C bus.
+static void cmd_i2c_stats(ws_cmd_t *c) {
+    set_ok(c, true);
+    json_out_str(c->out, "type", "i2c_stats");
+    json_out_int(c->out, "clk_hz", i2c_bus_clk_hz());
+    json_out_obj(c->out, "devices");
+    for (int i = 0; i < I2C_DEV_COUNT; i++) {
+        i2c_bus_stats_t st;
+        i2c_bus_get_stats((i2c_bus_dev_t)i, &st);
+        json_out_obj(c->out, i2c_bus_dev_name((i2c_bus_dev_t)i));
+        json_out_int(c->out, "ok", st.ok);
+        json_out_int(c->out, "errors", st.errors);
+        json_out_int(c->out, "retries", st.retries);
+        json_out_int(c->out, "lock_timeouts", st.lock_timeouts);
+        json_out_int(c->out, "max_wait_us", st.max_wait_us);
+        json_out_close(c->out);
+    }
+    json_out_close(c->out);
+    bool reset = false;
+    if (get_bool(c->doc, c->obj, "reset", &reset) && reset) i2c_bus_reset_stats();
+}
+
+// 64 hex digits -> 32 bytes.
+static bool parse_sha256(const json_doc_t *d, int i, uint8_t out[32]) {
+    size_t len = 0;
+    const char *s = json_raw(d, i, &len);
+    if (!s || len != 64) return false;
+    for (int k = 0; k < 64; k++) {
+        const char ch = s[k];
+        int v;
+        if (ch >= '0' && ch <= '9') v = ch - '0';
+        else if (ch >= 'a' && ch <= 'f') v = ch - 'a' + 10;
+        else if (ch >= 'A' && ch <= 'F') v = ch - 'A' + 10;
+        else return false;
+        if (k & 1) out[k / 2] |= (uint8_t)v;
+        else out[k / 2] = (uint8_t)(v << 4);
+    }
+    return true;
+}
+
+static void add_ota_status(ws_cmd_t *c) {
+    ota_status_t st;
+    ota_get_status(&st);
+    json_out_str(c->out, "phase", ota_phase_name(st.phase));
+    json_out_int(c->out, "offset", st.written);
+    json_out_int(c->out, "size", st.size);
+    if (st.target[0]) json_out_str(c->out, "target", st.target);
+    json_out_str(c->out, "running", st.running);
+    json_out_str(c->out, "version", st.version);
+    json_out_bool(c->out, "pending_verify", st.pending_verify);
+}
+
+// {"type":"ota_begin","size":N,"sha256":"<hex>"}: open (or resume) an update; image bytes then
+// follow as OTA binary frames starting at the returned offset.
+static void cmd_ota_begin(ws_cmd_t *c) {
+    double size = 0;
+    uint8_t sha[32];
+    esp_err_t oe = ESP_ERR_INVALID_ARG;
+    uint32_t offset = 0;
+    if (get_num(c->doc, c->obj, "size", &size) && size >= 1 && size <= UINT32_MAX &&
+        parse_sha256(c->doc, json_get(c->doc, c->obj, "sha256"), sha)) {
+        oe = ota_begin((uint32_t)size, sha, &offset);
+    }
+    add_cmd_ack(c, oe == ESP_OK);
+    add_ota_status(c);
+    if (oe != ESP_OK) json_out_str(c->out, "error", oe == ESP_ERR_INVALID_ARG ? "bad_args" : ota_err_str(oe));
+}
+
+// {"type":"ota_end","reboot":true}: verify the received image and boot into it.
+static void cmd_ota_end(ws_cmd_t *c) {
+    bool reboot = true;
+    get_bool(c->doc, c->obj, "reboot", &reboot);
+    esp_err_t oe = ota_finish();
+    add_cmd_ack(c, oe == ESP_OK);
+    add_ota_status(c);
+    if (oe != ESP_OK) {
+        json_out_str(c->out, "error", oe == ESP_ERR_INVALID_STATE ? "incomplete" : ota_err_str(oe));
+    } else if (reboot) {
+        json_out_bool(c->out, "rebooting", true);
+        ota_restart_after(500);
     }
+}
+
+static void cmd_ota_abort(ws_cmd_t *c) {
+    ota_abort();
+    add_cmd_ack(c, true);
+}
+
+static void cmd_ota_status(ws_cmd_t *c) {
+    set_ok(c, true);
+    json_out_str(c->out, "type", "ota_status");
+    add_ota_status(c);
+}
+
+static void add_wifi_stats(ws_cmd_t *c) {
+    wifi_stats_t st;
+    wifi_manager_get_stats(&st);
+    json_out_str(c->out, "profile", wifi_profile_name(wifi_manager_get_profile()));
+    json_out_bool(c->out, "connected", st.connected);
+    if (st.connected) {
+        char bssid[18];
+        snprintf(bssid, sizeof(bssid), "%02x:%02x:%02x:%02x:%02x:%02x",
+                 st.bssid[0], st.bssid[1], st.bssid[2], st.bssid[3], st.bssid[4], st.bssid[5]);
+        json_out_int(c->out, "rssi", st.rssi);
+        json_out_int(c->out, "channel", st.channel);
+        json_out_str(c->out, "bssid", bssid);
+        json_out_int(c->out, "uptime_ms", st.uptime_ms);
+    }
+    json_out_int(c->out, "connects", st.connects);
+    json_out_int(c->out, "fast_connects", st.fast_connects);
+    json_out_int(c->out, "disconnects", st.disconnects);
+    json_out_int(c->out, "last_reason", st.last_reason);
+    json_out_int(c->out, "last_connect_ms", st.last_connect_ms);
+    json_out_int(c->out, "roam_queries", st.roam_queries);
+}
+
+// {"type":"wifi"}: link stats and the current connection profile.
+static void cmd_wifi(ws_cmd_t *c) {
+    set_ok(c, true);
+    json_out_str(c->out, "type", "wifi");
+    add_wifi_stats(c);
+}
+
+// {"type":"wifi_profile","profile":"realtime"}: switch (and save) the connection profile;
+// replies with the same stats as "wifi".
+static void cmd_wifi_profile(ws_cmd_t *c) {
+    esp_err_t we = ESP_ERR_INVALID_ARG;
+    const int profile_tok = json_get(c->doc, c->obj, "profile");
+    if (json_is(c->doc, profile_tok, JSON_STRING)) {
+        char name[12];
+        wifi_profile_t p;
+        json_strcpy(c->doc, profile_tok, name, sizeof(name));
+        if (wifi_profile_from_name(name, &p)) we = wifi_manager_set_profile(p);
+    }
+
+    set_ok(c, we == ESP_OK);
+    json_out_str(c->out, "type", "wifi_profile");
+    add_wifi_stats(c);
+    if (we != ESP_OK) json_out_str(c->out, "error", we == ESP_ERR_INVALID_ARG ? "bad_profile" : esp_err_to_name(we));
+}
 
+// {"type":"lipsync","enable":true}: mouth follows the speech envelope on-device while audio
+// plays; optional attack_ms / release_ms / full_scale tune the follower.
+static void cmd_lipsync(ws_cmd_t *c) {
+    audio_lipsync_config_t lc;
+    audio_get_lipsync_config(&lc);
+    float v;
+    get_bool(c->doc, c->obj, "enable", &lc.enabled);
+    if (get_unit(c->doc, c->obj, "attack_ms", 0.0f, 500.0f, &v)) lc.attack_ms = (uint16_t)v;
+    if (get_unit(c->doc, c->obj, "release_ms", 0.0f, 2000.0f, &v)) lc.release_ms = (uint16_t)v;
+    if (get_unit(c->doc, c->obj, "full_scale", 500.0f, 32767.0f, &v)) lc.full_scale = (uint16_t)v;
+    esp_err_t ae = audio_set_lipsync_config(&lc);
+    add_cmd_ack(c, ae == ESP_OK);
+    json_out_bool(c->out, "enabled", lc.enabled);
+    json_out_int(c->out, "attack_ms", lc.attack_ms);
+    json_out_int(c->out, "release_ms", lc.release_ms);
+    json_out_int(c->out, "full_scale", lc.full_scale);
+    if (ae != ESP_OK) json_out_str(c->out, "error", esp_err_to_name(ae));
+}
+
+static void cmd_audio_config(ws_cmd_t *c) {
+    audio_jitter_config_t jc;
+    audio_get_jitter_config(&jc);
+    float v;
+    if (get_unit(c->doc, c->obj, "target_ms", 0.0f, 2000.0f, &v)) jc.target_ms = (uint16_t)v;
+    if (get_unit(c->doc, c->obj, "fade_ms", 0.0f, 100.0f, &v)) jc.fade_ms = (uint16_t)v;
+    if (get_unit(c->doc, c->obj, "hold_ms", 0.0f, 5000.0f, &v)) jc.hold_ms = (uint16_t)v;
+    esp_err_t ae = audio_set_jitter_config(&jc);
+    add_cmd_ack(c, ae == ESP_OK);
+    json_out_int(c->out, "target_ms", jc.target_ms);
+    json_out_int(c->out, "fade_ms", jc.fade_ms);
+    json_out_int(c->out, "hold_ms", jc.hold_ms);
+    if (ae != ESP_OK) json_out_str(c->out, "error", esp_err_to_name(ae));
+}
+
+static const char *sub_add(int fd, float hz, bool touch, ws_sub_t **out);
+
+// Per-connection defaults, e.g. {"type":"session","ack":"minimal","role":"observer"}.
+// Becoming an observer also subscribes the connection to state pushes at the default rate.
+static void cmd_session(ws_cmd_t *c) {
+    if (!c->sess) {
+        add_cmd_ack(c, false);
+        json_out_str(c->out, "error", "no_mem");
+        return;
+    }
+    const json_doc_t *d = c->doc;
+    const int role_tok = json_get(d, c->obj, "role");
+    ws_role_t role = c->sess->role;
+    const char *error = NULL;
+    if (role_tok >= 0) {
+        if (!c->lane->control) error = "wrong_lane";
+        else if (json_eq(d, role_tok, "controller")) role = WS_ROLE_CONTROLLER;
+        else if (json_eq(d, role_tok, "observer")) role = WS_ROLE_OBSERVER;
+        else if (json_eq(d, role_tok, "auto")) role = WS_ROLE_AUTO;
+        else error = "bad_role";
+    }
+    const int fd = httpd_req_to_sockfd(c->req);
+    if (!error && role == WS_ROLE_OBSERVER && !sub_find(fd)) {
+        ws_sub_t *sub;
+        error = sub_add(fd, CONFIG_LITTLEAI_WS_PUSH_MAX_HZ, true, &sub);
+    }
+    if (error) {
+        add_cmd_ack(c, false);
+        json_out_str(c->out, "error", error);
+        return;
+    }
+
+    ws_ack_mode_t m;
+    if (parse_ack_mode(d, c->obj, &m)) c->sess->ack = m;
+    c->sess->role = role;
+    add_cmd_ack(c, true);
+    json_out_str(c->out, "ack", ack_mode_str(c->sess->ack));
+    if (c->lane->control) {
+        json_out_str(c->out, "role", role_str(role));
+        json_out_bool(c->out, "subscribed", sub_find(fd) != NULL);
+    }
+}
+
+static void add_clients(json_out_t *o, httpd_handle_t hd, const ws_lane_t *lane, size_t cap) {
+    if (!hd) return;
+    size_t n = cap;
+    int fds[WS_LIST_MAX];
+    if (httpd_get_client_list(hd, &n, fds) != ESP_OK) return;
+    const int64_t now_us = esp_timer_get_time();
+    for (size_t i = 0; i < n; i++) {
+        json_out_item_obj(o);
+        json_out_int(o, "fd", fds[i]);
+        json_out_str(o, "lane", lane->control ? "control" : "audio");
+        // Sessions of the other server belong to its task; only list our own.
+        const ws_session_t *s = lane->control ? (const ws_session_t *)httpd_sess_get_ctx(hd, fds[i]) : NULL;
+        if (s) {
+            json_out_str(o, "role", role_str(s->role));
+            json_out_bool(o, "subscribed", sub_find(fds[i]) != NULL);
+            json_out_int(o, "idle_ms", (now_us - s->last_rx_us) / 1000);
+        }
+        json_out_close(o);
+    }
+}
+
+// {"type":"clients"}: open connections on both lanes ("self" is the caller's fd).
+static void cmd_clients(ws_cmd_t *c) {
+    set_ok(c, true);
+    json_out_str(c->out, "type", "clients");
+    json_out_int(c->out, "self", httpd_req_to_sockfd(c->req));
+    json_out_int(c->out, "max", WS_MAX_CLIENTS);
+    json_out_arr(c->out, "clients");
+    add_clients(c->out, s_httpd, &s_ctl_lane, WS_MAX_CLIENTS + 1);
+    add_clients(c->out, s_audio_httpd, &s_audio_lane, WS_AUDIO_MAX_CLIENTS);
+    json_out_close(c->out);
+}
+
+// ---------- State push ----------
+
+// Fields of `cur` that differ from `prev`.
+static void add_state_delta(json_out_t *o, const face_state_t *prev, const face_state_t *cur) {
+    json_out_obj(o, "delta");
+    if (cur->expression != prev->expression) json_out_str(o, "expression", expr_to_str(cur->expression));
+    if (cur->intensity != prev->intensity) json_out_float(o, "intensity", cur->intensity);
+    if (cur->gaze_x != prev->gaze_x) json_out_float(o, "gaze_x", cur->gaze_x);
+    if (cur->gaze_y != prev->gaze_y) json_out_float(o, "gaze_y", cur->gaze_y);
+    if (cur->eye_open != prev->eye_open) json_out_float(o, "eye_open", cur->eye_open);
+    if (cur->eye_open_override != prev->eye_open_override) json_out_bool(o, "eye_open_override", cur->eye_open_override);
+    if (cur->mouth_open != prev->mouth_open) json_out_float(o, "mouth_open", cur->mouth_open);
+    if (cur->mouth_open_override != prev->mouth_open_override) json_out_bool(o, "mouth_open_override", cur->mouth_open_override);
+    if (strcmp(cur->caption, prev->caption) != 0) json_out_str(o, "caption", cur->caption);
+    if (cur->caption_until_ms != prev->caption_until_ms) json_out_int(o, "caption_until_ms", cur->caption_until_ms);
+    if (strcmp(cur->viseme, prev->viseme) != 0) json_out_str(o, "viseme", cur->viseme);
+    if (cur->viseme_weight != prev->viseme_weight) json_out_float(o, "viseme_weight", cur->viseme_weight);
+    if (cur->viseme_until_ms != prev->viseme_until_ms) json_out_int(o, "viseme_until_ms", cur->viseme_until_ms);
+    if (cur->blink_until_ms != prev->blink_until_ms) json_out_int(o, "blink_until_ms", cur->blink_until_ms);
+    json_out_close(o);
+}
+
+static void push_schedule(void);
+
+// Send the first `len` bytes of s_push_out to a subscriber; drops the subscription if the
+// connection is gone.
+static bool sub_send(ws_sub_t *sub, size_t len) {
+    if (httpd_ws_get_fd_info(s_httpd, sub->fd) != HTTPD_WS_CLIENT_WEBSOCKET) {
+        sub->active = false;
+        return false;
+    }
+    httpd_ws_frame_t frame = {
+        .type = HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t *)s_push_out,
+        .len = len,
+    };
+    if (httpd_ws_send_frame_async(s_httpd, sub->fd, &frame) != ESP_OK) {
+        ESP_LOGW(TAG, "push to fd %d failed; unsubscribing", sub->fd);
+        sub->active = false;
+        return false;
+    }
+    return true;
+}
+
+// httpd work item: send each subscriber a delta if the state moved on since its last push and
+// its rate limit allows; otherwise re-arm the timer for the earliest subscriber that is due.
+static void push_work(void *arg) {
+    portENTER_CRITICAL(&s_push_lock);
+    s_push_queued = false;
+    portEXIT_CRITICAL(&s_push_lock);
+
+    if (!s_face) return;
+
+    face_state_t *snap = &s_view;
+    const uint8_t expired = face_view(snap);
+
+    const int64_t now_us = esp_timer_get_time();
+    int64_t next_us = INT64_MAX;
+
+    // Subscribers last sent the same snapshot (same version and expiry bits) get the same
+    // delta, so observers that subscribed at the same rate share one encoding per push.
+    bool built = false;
+    uint32_t built_version = 0;
+    uint8_t built_expired = 0;
+    size_t built_len = 0;
+
+    for (int i = 0; i < WS_MAX_SUBS; i++) {
+        ws_sub_t *sub = &s_subs[i];
+        if (!sub->active || (sub->sent.version == snap->version && sub->sent_expired == expired)) continue;
+
+        const int64_t due_us = sub->last_push_us + (int64_t)sub->interval_ms * 1000;
+        if (now_us < due_us) {
+            if (due_us < next_us) next_us = due_us;
+            continue;
+        }
+
+        if (!built || built_version != sub->sent.version || built_expired != sub->sent_expired) {
+            json_out_t o;
+            json_out_init(&o, s_push_out, sizeof(s_push_out));
+            json_out_str(&o, "type", "state_delta");
+            json_out_int(&o, "version", snap->version);
+            json_out_int(&o, "ts_ms", (uint32_t)(now_us / 1000));
+            add_state_delta(&o, &sub->sent, snap);
+            built_len = json_out_finish(&o);
+            built = true;
+            built_version = sub->sent.version;
+            built_expired = sub->sent_expired;
+        }
+        const size_t len = built_len;
+        if (len == 0 || !sub_send(sub, len)) continue;
+        sub->sent = *snap;
+        sub->sent_expired = expired;
+        sub->last_push_us = now_us;
+    }
+
+    if (next_us != INT64_MAX) {
+        esp_timer_stop(s_push_timer);
+        esp_timer_start_once(s_push_timer, (uint64_t)(next_us - now_us));
+    }
+}
+
+static void push_schedule(void) {
+    if (!s_httpd) return;
+
+    bool queue = false;
+    portENTER_CRITICAL(&s_push_lock);
+    bool any = false;
+    for (int i = 0; i < WS_MAX_SUBS; i++) any |= s_subs[i].active;
+    if (any && !s_push_queued) {
+        s_push_queued = true;
+        queue = true;
+    }
+    portEXIT_CRITICAL(&s_push_lock);
+
+    if (queue && httpd_queue_work(s_httpd, push_work, NULL) != ESP_OK) {
+        portENTER_CRITICAL(&s_push_lock);
+        s_push_queued = false;
+        portEXIT_CRITICAL(&s_push_lock);
+    }
+}
+
+static void push_timer_cb(void *arg) {
+    push_schedule();
+}
+
+void ws_server_notify_face_changed(void) {
+    push_schedule();
+}
+
+// httpd work item: send every queued touch gesture to the subscribers that want them.
+static void event_work(void *arg) {
+    while (1) {
+        ws_touch_event_t ev;
+        portENTER_CRITICAL(&s_push_lock);
+        const bool have = s_event_count > 0;
+        if (have) {
+            ev = s_events[s_event_head];
+            s_event_head = (uint8_t)((s_event_head + 1) % WS_EVENT_QUEUE);
+            s_event_count--;
+        } else {
+            s_event_queued = false;
+        }
+        portEXIT_CRITICAL(&s_push_lock);
+        if (!have) return;
+
+        json_out_t o;
+        json_out_init(&o, s_push_out, sizeof(s_push_out));
+        json_out_str(&o, "type", "touch");
+        json_out_str(&o, "gesture", touch_gesture_name((touch_gesture_type_t)ev.g.type));
+        if (ev.g.type == TOUCH_GESTURE_SWIPE) json_out_str(&o, "dir", touch_dir_name((touch_dir_t)ev.g.dir));
+        if (ev.g.type == TOUCH_GESTURE_PET) json_out_int(&o, "strokes", ev.g.strokes);
+        json_out_int(&o, "x", ev.g.x);
+        json_out_int(&o, "y", ev.g.y);
+        json_out_int(&o, "dx", ev.g.dx);
+        json_out_int(&o, "dy", ev.g.dy);
+        json_out_int(&o, "duration_ms", ev.g.duration_ms);
+        json_out_int(&o, "ts_ms", ev.ts_ms);
+        const size_t len = json_out_finish(&o);
+        if (len == 0) continue;
+
+        for (int i = 0; i < WS_MAX_SUBS; i++) {
+            if (s_subs[i].active && s_subs[i].touch) sub_send(&s_subs[i], len);
+        }
+    }
+}
+
+void ws_server_notify_touch(const touch_gesture_t *g) {
+    if (!s_httpd || !g) return;
+
+    bool queue = false;
+    portENTER_CRITICAL(&s_push_lock);
+    bool any = false;
+    for (int i = 0; i < WS_MAX_SUBS; i++) any |= s_subs[i].active && s_subs[i].touch;
+    if (any) {
+        if (s_event_count == WS_EVENT_QUEUE) {
+            s_event_head = (uint8_t)((s_event_head + 1) % WS_EVENT_QUEUE);
+            s_event_count--;
+        }
+        ws_touch_event_t *ev = &s_events[(s_event_head + s_event_count) % WS_EVENT_QUEUE];
+        ev->g = *g;
+        ev->ts_ms = now_ms();
+        s_event_count++;
+        if (!s_event_queued) {
+            s_event_queued = true;
+            queue = true;
+        }
+    }
+    portEXIT_CRITICAL(&s_push_lock);
+
+    if (queue && httpd_queue_work(s_httpd, event_work, NULL) != ESP_OK) {
+        portENTER_CRITICAL(&s_push_lock);
+        s_event_queued = false;
+        s_event_count = 0;
+        portEXIT_CRITICAL(&s_push_lock);
+    }
+}
+
+// A WS command changed the face: wake the renderer and any subscribers.
+static void face_changed(void) {
+    if (s_on_face_changed) s_on_face_changed();
+    push_schedule();
+}
+
+// httpd work item: apply the merged stream update to the working copy and publish it.
+static void stream_work(void *arg) {
+    portENTER_CRITICAL(&s_push_lock);
+    const ws_stream_update_t u = s_stream;
+    s_stream.mask = 0;
+    s_stream_queued = false;
+    portEXIT_CRITICAL(&s_push_lock);
+
+    if (!s_face || !u.mask) return;
+
+    face_state_t *f = &s_draft;
+    if (u.mask & WS_STREAM_GAZE) {
+        f->gaze_x = clampf(u.gaze_x, -1.0f, 1.0f);
+        f->gaze_y = clampf(u.gaze_y, -1.0f, 1.0f);
+        face_anim_cancel(f, FACE_CH_GAZE_X);
+        face_anim_cancel(f, FACE_CH_GAZE_Y);
+    }
+    if (u.mask & WS_STREAM_MOUTH) {
+        f->mouth_open = clampf(u.mouth_open, 0.0f, 1.0f);
+        f->mouth_open_override = true;
+        face_anim_cancel(f, FACE_CH_MOUTH_OPEN);
+    }
+    if (u.mask & WS_STREAM_EYES) {
+        f->eye_open = clampf(u.eye_open, 0.0f, 1.0f);
+        f->eye_open_override = true;
+        face_anim_cancel(f, FACE_CH_EYE_OPEN);
+    }
+    face_publish();
+    face_changed();
+}
+
+esp_err_t ws_server_submit_stream(const ws_stream_update_t *u, bool *coalesced) {
+    if (!u) return ESP_ERR_INVALID_ARG;
+    if (!s_httpd) return ESP_ERR_INVALID_STATE;
+
+    bool queue = false;
+    portENTER_CRITICAL(&s_push_lock);
+    const bool merged = s_stream.mask != 0;
+    if (u->mask & WS_STREAM_GAZE) {
+        s_stream.gaze_x = u->gaze_x;
+        s_stream.gaze_y = u->gaze_y;
+    }
+    if (u->mask & WS_STREAM_MOUTH) s_stream.mouth_open = u->mouth_open;
+    if (u->mask & WS_STREAM_EYES) s_stream.eye_open = u->eye_open;
+    s_stream.mask |= u->mask;
+    if (!s_stream_queued) {
+        s_stream_queued = true;
+        queue = true;
+    }
+    portEXIT_CRITICAL(&s_push_lock);
+    if (coalesced) *coalesced = merged;
+
+    if (queue) {
+        esp_err_t err = httpd_queue_work(s_httpd, stream_work, NULL);
+        if (err != ESP_OK) {
+            portENTER_CRITICAL(&s_push_lock);
+            s_stream.mask = 0;
+            s_stream_queued = false;
+            portEXIT_CRITICAL(&s_push_lock);
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+// {"type":"subscribe","max_hz":10}: ack carries the full state; later changes arrive as
+// {"type":"state_delta","version":N,"delta":{...}} with only the fields that changed, and
+// touch gestures as {"type":"touch",...} unless "touch":false.
+// Subscribe connection `fd`, or update its subscription. Returns an error code or NULL.
+static const char *sub_add(int fd, float hz, bool touch, ws_sub_t **out) {
+    ws_sub_t *sub = sub_find(fd);
+    for (int i = 0; i < WS_MAX_SUBS && !sub; i++) {
+        if (!s_subs[i].active) sub = &s_subs[i];
+    }
+    if (!sub) return "too_many_subscribers";
+    if (!s_face) return "face_unavailable";
+
+    sub->fd = fd;
+    sub->interval_ms = (uint32_t)(1000.0f / hz);
+    sub->last_push_us = esp_timer_get_time();
+    sub->sent_expired = face_view(&sub->sent);
+    sub->touch = touch;
+    sub->active = true;
+    *out = sub;
+    return NULL;
+}
+
+static void cmd_subscribe(ws_cmd_t *c) {
+    float hz = CONFIG_LITTLEAI_WS_PUSH_MAX_HZ;
+    get_unit(c->doc, c->obj, "max_hz", 1.0f, 60.0f, &hz);
+    bool touch = true;
+    get_bool(c->doc, c->obj, "touch", &touch);
+
+    ws_sub_t *sub;
+    const char *error = sub_add(httpd_req_to_sockfd(c->req), hz, touch, &sub);
+    if (error) {
+        add_cmd_ack(c, false);
+        json_out_str(c->out, "error", error);
+        return;
+    }
+
+    add_cmd_ack(c, true);
+    json_out_float(c->out, "max_hz", hz);
+    json_out_bool(c->out, "touch", touch);
+    add_face_state(c->out, &sub->sent);
+}
+
+static void cmd_unsubscribe(ws_cmd_t *c) {
+    unsubscribe_fd(httpd_req_to_sockfd(c->req));
+    add_cmd_ack(c, true);
+}
+
+// Speech chunk (base64 payload). "speak" takes an optional codec (pcm16 | adpcm | opus);
+// speak_pcm is the original PCM16-only name. Use multiple messages to stream longer speech.
+static void cmd_speak(ws_cmd_t *c) {
+    const json_doc_t *d = c->doc;
+    const int codec_tok = json_get(d, c->obj, "codec");
+    audio_codec_t codec = AUDIO_CODEC_PCM16;
+    bool codec_ok = true;
+    if (json_is(d, codec_tok, JSON_STRING)) {
+        char name[8];
+        json_strcpy(d, codec_tok, name, sizeof(name));
+        codec_ok = audio_codec_from_name(name, &codec);
+    }
+
+    size_t in_len = 0;
+    const char *b64 = json_raw(d, json_get(d, c->obj, "data_b64"), &in_len);
+    if (!b64) {
+        add_cmd_ack(c, false);
+        json_out_str(c->out, "error", "missing_data_b64");
+        return;
+    }
+    if (!codec_ok || !audio_codec_supported(codec)) {
+        add_cmd_ack(c, false);
+        json_out_str(c->out, "error", "unsupported_codec");
+        return;
+    }
+
+    size_t out_len = 0;
+    uint8_t *const pcm = c->lane->pcm_buf;
+    int mbed = mbedtls_base64_decode(pcm, WS_PCM_LEN, &out_len, (const unsigned char *)b64, in_len);
+    if (mbed != 0) {
+        add_cmd_ack(c, false);
+        json_out_str(c->out, "error", "bad_base64");
+        return;
+    }
+
+    double rate = 0;
+    get_num(d, c->obj, "sample_rate", &rate);
+    if (!sample_rate_ok(rate)) {
+        add_cmd_ack(c, false);
+        json_out_str(c->out, "error", "unsupported_rate");
+        return;
+    }
+
+    // Optional jitter-buffer fields: stream, seq, ts_ms (timed when seq+ts_ms given), end.
+    double stream = 0, seq = 0, ts = 0;
+    bool end = false;
+    get_num(d, c->obj, "stream", &stream);
+    const bool has_seq = get_num(d, c->obj, "seq", &seq);
+    const bool has_ts = get_num(d, c->obj, "ts_ms", &ts);
+    get_bool(d, c->obj, "end", &end);
+    audio_chunk_info_t info = {
+        .stream_id = (uint16_t)stream,
+        .seq = (uint32_t)seq,
+        .ts_ms = (uint32_t)ts,
+        .codec = (uint8_t)codec,
+        .sample_rate = (uint32_t)rate,
+    };
+    if (has_seq && has_ts) info.flags |= AUDIO_CHUNK_F_TIMED;
+    if (end) info.flags |= AUDIO_CHUNK_F_END;
+
+    bool dropped = false;
+    esp_err_t ae = audio_enqueue_chunk(&info, pcm, out_len, WS_AUDIO_ENQUEUE_TIMEOUT_MS, &dropped);
+    add_cmd_ack(c, ae == ESP_OK && !dropped);
+    if (ae != ESP_OK) json_out_str(c->out, "error", audio_err_str(ae));
+    else if (dropped) json_out_str(c->out, "error", "dropped");
+    add_audio_queue_info(c->out);
+}
+
+// ---------- Face commands (edit the working copy; return true if state changed) ----------
+
+static bool face_set_expression(ws_cmd_t *c, face_state_t *f) {
+    bool updated = false;
+    const int expr = json_get(c->doc, c->obj, "expression");
+    if (json_is(c->doc, expr, JSON_STRING)) {
+        f->expression = parse_expr(c->doc, expr);
+        updated = true;
+    }
+    if (get_unit(c->doc, c->obj, "intensity", 0.0f, 1.0f, &f->intensity)) updated = true;
+    return updated;
+}
+
+static bool face_gaze(ws_cmd_t *c, face_state_t *f) {
+    bool updated = false;
+    if (get_unit(c->doc, c->obj, "x", -1.0f, 1.0f, &f->gaze_x)) {
+        face_anim_cancel(f, FACE_CH_GAZE_X);
+        updated = true;
+    }
+    if (get_unit(c->doc, c->obj, "y", -1.0f, 1.0f, &f->gaze_y)) {
+        face_anim_cancel(f, FACE_CH_GAZE_Y);
+        updated = true;
+    }
+    return updated;
+}
+
+static bool set_ttl(const json_doc_t *d, int obj, const char *key, uint32_t now, uint32_t *until) {
+    double ttl;
+    if (!get_num(d, obj, key, &ttl)) return false;
+    const uint32_t ttl_ms = (uint32_t)ttl;
+    *until = ttl_ms ? (now + ttl_ms) : 0;
+    return true;
+}
+
+static bool face_caption(ws_cmd_t *c, face_state_t *f) {
+    bool updated = false;
+    if (json_strcpy(c->doc, json_get(c->doc, c->obj, "text"), f->caption, sizeof(f->caption))) updated = true;
+    if (set_ttl(c->doc, c->obj, "ttl_ms", c->now, &f->caption_until_ms)) updated = true;
+    return updated;
+}
+
+static bool face_viseme(ws_cmd_t *c, face_state_t *f) {
+    bool updated = false;
+    if (json_strcpy(c->doc, json_get(c->doc, c->obj, "name"), f->viseme, sizeof(f->viseme))) updated = true;
+    if (get_unit(c->doc, c->obj, "weight", 0.0f, 1.0f, &f->viseme_weight)) updated = true;
+    if (set_ttl(c->doc, c->obj, "ttl_ms", c->now, &f->viseme_until_ms)) updated = true;
+    return updated;
+}
+
+static bool face_blink(ws_cmd_t *c, face_state_t *f) {
+    double dur = 150;
+    get_num(c->doc, c->obj, "duration_ms", &dur);
+    uint32_t d = (uint32_t)dur;
+    if (d > 2000) d = 2000;
+    f->blink_until_ms = c->now + d;
+    return true;
+}
+
+static bool face_eyes(ws_cmd_t *c, face_state_t *f) {
+    bool updated = false;
+    if (get_unit(c->doc, c->obj, "open", 0.0f, 1.0f, &f->eye_open)) {
+        face_anim_cancel(f, FACE_CH_EYE_OPEN);
+        f->eye_open_override = true;
+        updated = true;
+    }
+    if (get_bool(c->doc, c->obj, "override", &f->eye_open_override)) updated = true;
+    return updated;
+}
+
+static bool face_mouth(ws_cmd_t *c, face_state_t *f) {
+    bool updated = false;
+    if (get_unit(c->doc, c->obj, "open", 0.0f, 1.0f, &f->mouth_open)) {
+        face_anim_cancel(f, FACE_CH_MOUTH_OPEN);
+        f->mouth_open_override = true;
+        updated = true;
+    }
+    if (get_bool(c->doc, c->obj, "override", &f->mouth_open_override)) updated = true;
+    return updated;
+}
+
+static bool face_rig(ws_cmd_t *c, face_state_t *f) {
+    // Set both eye_open and mouth_open in one message
+    bool updated = false;
+    if (get_unit(c->doc, c->obj, "eye_open", 0.0f, 1.0f, &f->eye_open)) {
+        face_anim_cancel(f, FACE_CH_EYE_OPEN);
+        f->eye_open_override = true;
+        updated = true;
+    }
+    if (get_unit(c->doc, c->obj, "mouth_open", 0.0f, 1.0f, &f->mouth_open)) {
+        face_anim_cancel(f, FACE_CH_MOUTH_OPEN);
+        f->mouth_open_override = true;
+        updated = true;
+    }
+    return updated;
+}
+
+static bool face_rig_clear(ws_cmd_t *c, face_state_t *f) {
+    face_anim_cancel(f, FACE_CH_EYE_OPEN);
+    face_anim_cancel(f, FACE_CH_MOUTH_OPEN);
+    f->eye_open_override = false;
+    f->mouth_open_override = false;
+    return true;
+}
+
+// Animatable channels, indexed by face_channel_t, with their value ranges.
+static const struct {
+    const char *name;
+    float lo;
+    float hi;
+} k_anim_channels[FACE_CH_COUNT] = {
+    {"gaze_x", -1.0f, 1.0f},
+    {"gaze_y", -1.0f, 1.0f},
+    {"eye_open", 0.0f, 1.0f},
+    {"mouth_open", 0.0f, 1.0f},
+};
+
+static face_ease_t parse_ease(const json_doc_t *d, int tok) {
+    if (json_eq(d, tok, "in")) return FACE_EASE_IN;
+    if (json_eq(d, tok, "out")) return FACE_EASE_OUT;
+    if (json_eq(d, tok, "in_out")) return FACE_EASE_IN_OUT;
+    if (json_eq(d, tok, "step")) return FACE_EASE_STEP;
+    return FACE_EASE_LINEAR;
+}
+
+// {"to":v,"duration_ms":ms,"ease":"linear|in|out|in_out|step"}
+static bool parse_anim_key(const json_doc_t *d, int obj, face_channel_t ch, face_anim_key_t *k) {
+    float to, ms = 0;
+    if (!get_unit(d, obj, "to", k_anim_channels[ch].lo, k_anim_channels[ch].hi, &to)) return false;
+    get_unit(d, obj, "duration_ms", 0.0f, 10000.0f, &ms);
+    k->value = to;
+    k->duration_ms = (uint16_t)ms;
+    k->ease = (uint8_t)parse_ease(d, json_get(d, obj, "ease"));
+    return true;
+}
+
+// {"type":"animate","gaze_x":{"to":0.5,"duration_ms":300,"ease":"out"},
+//  "eye_open":{"keys":[{"to":0.1,"duration_ms":80},{"to":0.9,"duration_ms":200,"ease":"in_out"}]}}
+// Each channel (gaze_x, gaze_y, eye_open, mouth_open) takes one segment or up to
+// FACE_ANIM_MAX_KEYS; the renderer interpolates them on-device, starting from wherever the
+// channel is now.
+static bool face_animate(ws_cmd_t *c, face_state_t *f) {
+    const json_doc_t *d = c->doc;
+    bool updated = false;
+    for (int ch = 0; ch < FACE_CH_COUNT; ch++) {
+        const int spec = json_get(d, c->obj, k_anim_channels[ch].name);
+        if (!json_is(d, spec, JSON_OBJECT)) continue;
+
+        face_anim_key_t keys[FACE_ANIM_MAX_KEYS];
+        int n = 0;
+        bool ok = true;
+        const int arr = json_get(d, spec, "keys");
+        if (json_is(d, arr, JSON_ARRAY)) {
+            for (int i = arr + 1; i < d->tok[arr].next && ok; i = d->tok[i].next) {
+                ok = n < FACE_ANIM_MAX_KEYS && json_is(d, i, JSON_OBJECT) &&
+                     parse_anim_key(d, i, (face_channel_t)ch, &keys[n]);
+                n++;
+            }
+        } else {
+            ok = parse_anim_key(d, spec, (face_channel_t)ch, &keys[n++]);
+        }
+        if (ok && face_anim_start(f, (face_channel_t)ch, keys, n, c->now)) updated = true;
+    }
+    return updated;
+}
+
+static bool face_set_state(ws_cmd_t *c, face_state_t *f) {
+    // Convenience: set multiple fields at once.
+    const json_doc_t *d = c->doc;
+    const int st = json_get(d, c->obj, "state");
+    if (!json_is(d, st, JSON_OBJECT)) return false;
+
+    bool updated = false;
+    const int expr = json_get(d, st, "expression");
+    if (json_is(d, expr, JSON_STRING)) { f->expression = parse_expr(d, expr); updated = true; }
+    if (get_unit(d, st, "intensity", 0.0f, 1.0f, &f->intensity)) updated = true;
+    // A direct set of an animated channel stops its animation.
+    if (get_unit(d, st, "gaze_x", -1.0f, 1.0f, &f->gaze_x)) { face_anim_cancel(f, FACE_CH_GAZE_X); updated = true; }
+    if (get_unit(d, st, "gaze_y", -1.0f, 1.0f, &f->gaze_y)) { face_anim_cancel(f, FACE_CH_GAZE_Y); updated = true; }
+
+    if (get_unit(d, st, "eye_open", 0.0f, 1.0f, &f->eye_open)) { face_anim_cancel(f, FACE_CH_EYE_OPEN); updated = true; }
+    if (get_bool(d, st, "eye_open_override", &f->eye_open_override)) updated = true;
+    if (get_unit(d, st, "mouth_open", 0.0f, 1.0f, &f->mouth_open)) { face_anim_cancel(f, FACE_CH_MOUTH_OPEN); updated = true; }
+    if (get_bool(d, st, "mouth_open_override", &f->mouth_open_override)) updated = true;
+
+    if (json_strcpy(d, json_get(d, st, "caption"), f->caption, sizeof(f->caption))) updated = true;
+    if (set_ttl(d, st, "caption_ttl_ms", c->now, &f->caption_until_ms)) updated = true;
+    return updated;
+}
+
+// ---------- Dispatch ----------
+
+static void cmd_batch(ws_cmd_t *c);
+
+#define WS_CMD_QUERY 0x01 // always answered, even with ack:false
+#define WS_CMD_READ 0x02  // changes nothing: allowed for observers, keeps an auto session auto
+#define WS_CMD_AUDIO 0x04 // also accepted on /ws/audio (runs on that lane's task)
+
+typedef struct {
+    const char *name;
+    void (*fn)(ws_cmd_t *c);                       // replies on its own
+    bool (*face_fn)(ws_cmd_t *c, face_state_t *f); // face update; acked with the new state
+    uint8_t flags;                                 // WS_CMD_*
+} ws_cmd_entry_t;
+
+// Sorted by name (strcmp order) for bsearch.
+static const ws_cmd_entry_t s_cmds[] = {
+    {"animate", NULL, face_animate, 0},
+    {"assets", cmd_assets, NULL, WS_CMD_QUERY | WS_CMD_READ},
+    {"audio_bench", cmd_audio_bench, NULL, WS_CMD_QUERY | WS_CMD_READ},
+    {"audio_config", cmd_audio_config, NULL, 0},
+    {"audio_flush", cmd_audio_flush, NULL, WS_CMD_AUDIO},
+    {"audio_stats", cmd_audio_stats, NULL, WS_CMD_QUERY | WS_CMD_READ | WS_CMD_AUDIO},
+    {"batch", cmd_batch, NULL, 0},
+    {"beep", cmd_beep, NULL, 0},
+    {"blink", NULL, face_blink, 0},
+    {"caption", NULL, face_caption, 0},
+    {"clients", cmd_clients, NULL, WS_CMD_QUERY | WS_CMD_READ},
+    {"eyes", NULL, face_eyes, 0},
+    {"gaze", NULL, face_gaze, 0},
+    {"get_state", cmd_get_state, NULL, WS_CMD_QUERY | WS_CMD_READ},
+    {"i2c_stats", cmd_i2c_stats, NULL, WS_CMD_QUERY | WS_CMD_READ},
+    {"lipsync", cmd_lipsync, NULL, 0},
+    {"mouth", NULL, face_mouth, 0},
+    {"ota_abort", cmd_ota_abort, NULL, 0},
+    {"ota_begin", cmd_ota_begin, NULL, WS_CMD_QUERY},
+    {"ota_end", cmd_ota_end, NULL, WS_CMD_QUERY},
+    {"ota_status", cmd_ota_status, NULL, WS_CMD_QUERY | WS_CMD_READ},
+    {"perf", cmd_perf, NULL, WS_CMD_QUERY | WS_CMD_READ},
+    {"ping", cmd_ping, NULL, WS_CMD_QUERY | WS_CMD_READ | WS_CMD_AUDIO},
+    {"play_clip", cmd_play_clip, NULL, 0},
+    {"rig", NULL, face_rig, 0},
+    {"rig_clear", NULL, face_rig_clear, 0},
+    {"session", cmd_session, NULL, WS_CMD_QUERY | WS_CMD_READ | WS_CMD_AUDIO},
+    {"set_expression", NULL, face_set_expression, 0},
+    {"set_state", NULL, face_set_state, 0},
+    {"speak", cmd_speak, NULL, WS_CMD_AUDIO},
+    {"speak_pcm", cmd_speak, NULL, WS_CMD_AUDIO},
+    {"subscribe", cmd_subscribe, NULL, WS_CMD_QUERY | WS_CMD_READ},
+    {"tasks", cmd_tasks, NULL, WS_CMD_QUERY | WS_CMD_READ},
+    {"udp_stats", cmd_udp_stats, NULL, WS_CMD_QUERY | WS_CMD_READ},
+    {"unsubscribe", cmd_unsubscribe, NULL, WS_CMD_QUERY | WS_CMD_READ},
+    {"viseme", NULL, face_viseme, 0},
+    {"volume", cmd_volume, NULL, 0},
+    {"wifi", cmd_wifi, NULL, WS_CMD_QUERY | WS_CMD_READ},
+    {"wifi_profile", cmd_wifi_profile, NULL, WS_CMD_QUERY},
+};
+
+typedef struct {
+    const char *s;
+    size_t len;
+} ws_name_t;
+
+static int cmd_cmp(const void *key, const void *elem) {
+    const ws_name_t *k = (const ws_name_t *)key;
+    const char *name = ((const ws_cmd_entry_t *)elem)->name;
+    const int r = strncmp(k->s, name, k->len);
+    if (r != 0) return r;
+    return name[k->len] == 0 ? 0 : -1;
+}
+
+static const ws_cmd_entry_t *find_cmd(const json_doc_t *d, int type_tok) {
+    size_t len = 0;
+    const char *s = json_is(d, type_tok, JSON_STRING) ? json_raw(d, type_tok, &len) : NULL;
+    if (!s || d->tok[type_tok].escaped) return NULL;
+    const ws_name_t key = {s, len};
+    return (const ws_cmd_entry_t *)bsearch(&key, s_cmds, sizeof(s_cmds) / sizeof(s_cmds[0]), sizeof(s_cmds[0]), cmd_cmp);
+}
+
+// Face commands (and unknown ones, fn == NULL) ack with the resulting face state.
+static void run_face_cmd(ws_cmd_t *c, bool (*fn)(ws_cmd_t *c, face_state_t *f)) {
+    if (!s_face) {
+        set_ok(c, false);
+        json_out_str(c->out, "error", "face_unavailable");
+        return;
+    }
+
+    const bool updated = fn ? fn(c, &s_draft) : false;
+    if (updated) face_publish();
+    set_ok(c, updated);
+    if (!updated) {
+        json_out_str(c->out, "error", "unknown_or_invalid_command");
+    }
+    json_out_str(c->out, "type", "ack");
+    json_out_str(c->out, "cmd", c->name);
+    json_out_int(c->out, "ts_ms", c->now);
+    if (c->ack == WS_ACK_FULL) {
+        face_view(&s_view);
+        add_face_state(c->out, &s_view);
+    }
+    if (updated) face_changed();
+}
+
+// {"type":"batch","cmds":[{...},{...}]}: face sub-commands applied in order to the working
+// copy and published once, so the renderer sees all of them in the same frame.
+static void cmd_batch(ws_cmd_t *c) {
+    const json_doc_t *d = c->doc;
+    const int cmds = json_get(d, c->obj, "cmds");
+    if (!json_is(d, cmds, JSON_ARRAY)) {
+        add_cmd_ack(c, false);
+        json_out_str(c->out, "error", "missing_cmds");
+        return;
+    }
+    if (!s_face) {
+        add_cmd_ack(c, false);
+        json_out_str(c->out, "error", "face_unavailable");
+        return;
+    }
+
+    // Entries that were unknown, not face commands or invalid (first few reported by index).
+    int failed[16];
+    int count = 0, nfailed = 0;
+    for (int i = cmds + 1; i < d->tok[cmds].next; i = d->tok[i].next, count++) {
+        const ws_cmd_entry_t *e = json_is(d, i, JSON_OBJECT) ? find_cmd(d, json_get(d, i, "type")) : NULL;
+        ws_cmd_t sub = *c;
+        sub.obj = i;
+        if (!e || !e->face_fn || !e->face_fn(&sub, &s_draft)) {
+            if (nfailed < (int)(sizeof(failed) / sizeof(failed[0]))) failed[nfailed] = count;
+            nfailed++;
+        }
+    }
+
+    if (nfailed < count) face_publish();
+    add_cmd_ack(c, nfailed == 0);
+    json_out_int(c->out, "count", count);
+    json_out_int(c->out, "applied", count - nfailed);
+    if (nfailed) {
+        json_out_arr(c->out, "failed");
+        for (int k = 0; k < nfailed && k < (int)(sizeof(failed) / sizeof(failed[0])); k++) {
+            json_out_item_int(c->out, failed[k]);
+        }
+        json_out_close(c->out);
+    }
+    json_out_int(c->out, "ts_ms", c->now);
+    if (c->ack == WS_ACK_FULL) {
+        face_view(&s_view);
+        add_face_state(c->out, &s_view);
+    }
+    if (nfailed < count) face_changed();
+}
+
+static esp_err_t ws_handle_frame(httpd_req_t *req) {
+    ws_lane_t *lane = lane_of(req);
     httpd_ws_frame_t frame = {0};
     frame.type = HTTPD_WS_TYPE_TEXT;
 
@@ -115,296 +1931,196 @@ static esp_err_t ws_handler(httpd_req_t *req) {
         return ESP_OK;
     }
 
-    if (frame.len > 16384) {
-        ESP_LOGW(TAG, "ws payload too large: %u", (unsigned)frame.len);
-        return ESP_OK;
+    if (frame.type == HTTPD_WS_TYPE_BINARY) {
+        return handle_binary_frame(req, frame.len);
     }
 
-    char *buf = (char *)calloc(1, frame.len + 1);
-    if (!buf) return ESP_ERR_NO_MEM;
+    if (frame.len > WS_MAX_FRAME_LEN) {
+        // The tokenizer needs the whole document; skip the payload so the stream stays in sync.
+        ESP_LOGW(TAG, "ws payload too large: %u", (unsigned)frame.len);
+        ESP_RETURN_ON_ERROR(ws_discard(req, frame.len), TAG, "oversized frame");
+        json_out_t out;
+        json_out_init(&out, lane->out, lane->out_cap);
+        json_out_bool(&out, "ok", false);
+        json_out_str(&out, "error", "frame_too_large");
+        return send_reply(req, &out);
+    }
 
-    frame.payload = (uint8_t *)buf;
-    err = httpd_ws_recv_frame(req, &frame, frame.len);
+    frame.payload = lane->rx_buf;
+    err = httpd_ws_recv_frame(req, &frame, WS_MAX_FRAME_LEN);
     if (err != ESP_OK) {
         ESP_LOGW(TAG, "ws recv failed: %s", esp_err_to_name(err));
-        free(buf);
         return err;
     }
-    buf[frame.len] = 0;
-
-    cJSON *root = cJSON_Parse(buf);
-    free(buf);
 
-    cJSON *resp = cJSON_CreateObject();
+    json_out_t out;
+    json_out_init(&out, lane->out, lane->out_cap);
 
-    if (!root || !cJSON_IsObject(root)) {
-        cJSON_AddBoolToObject(resp, "ok", false);
-        cJSON_AddStringToObject(resp, "error", "invalid_json");
-        cJSON_Delete(root);
-        esp_err_t se = send_json(req, resp);
-        cJSON_Delete(resp);
-        return se;
+    json_doc_t doc;
+    if (!json_parse(&doc, (const char *)lane->rx_buf, frame.len, lane->tok, lane->tok_cap) ||
+        !json_is(&doc, 0, JSON_OBJECT)) {
+        json_out_bool(&out, "ok", false);
+        json_out_str(&out, "error", "invalid_json");
+        return send_reply(req, &out);
     }
 
-    const cJSON *type = cJSON_GetObjectItem(root, "type");
-    const char *t = cJSON_IsString(type) ? type->valuestring : NULL;
-
-    if (!t) {
-        cJSON_AddBoolToObject(resp, "ok", false);
-        cJSON_AddStringToObject(resp, "error", "missing_type");
-        cJSON_Delete(root);
-        esp_err_t se = send_json(req, resp);
-        cJSON_Delete(resp);
-        return se;
+    const int type_tok = json_get(&doc, 0, "type");
+    if (!json_is(&doc, type_tok, JSON_STRING)) {
+        json_out_bool(&out, "ok", false);
+        json_out_str(&out, "error", "missing_type");
+        return send_reply(req, &out);
     }
 
-    // ---------- Commands ----------
-    uint32_t n = now_ms();
+    ws_cmd_t c = {
+        .req = req,
+        .doc = &doc,
+        .obj = 0,
+        .out = &out,
+        .lane = lane,
+        .sess = get_session(req),
+        .now = now_ms(),
+    };
+    c.ack = c.sess ? c.sess->ack : WS_ACK_FULL;
+    parse_ack_mode(&doc, 0, &c.ack);
 
-    if (str_eq(t, "ping")) {
-        cJSON_AddBoolToObject(resp, "ok", true);
-        cJSON_AddStringToObject(resp, "type", "pong");
-        cJSON_AddNumberToObject(resp, "ts_ms", (double)n);
-    } else if (str_eq(t, "get_state")) {
-        cJSON_AddBoolToObject(resp, "ok", true);
-        cJSON_AddStringToObject(resp, "type", "state");
-        if (s_face && s_face_mux && xSemaphoreTake(s_face_mux, pdMS_TO_TICKS(50)) == pdTRUE) {
-            cJSON_AddItemToObject(resp, "state", face_to_json(s_face));
-            xSemaphoreGive(s_face_mux);
-        } else {
-            cJSON_AddStringToObject(resp, "error", "face_unavailable");
-        }
-    } else if (str_eq(t, "beep")) {
-        const cJSON *freq = cJSON_GetObjectItem(root, "freq_hz");
-        const cJSON *dur = cJSON_GetObjectItem(root, "duration_ms");
-        int f = cJSON_IsNumber(freq) ? (int)freq->valuedouble : 880;
-        int d = cJSON_IsNumber(dur) ? (int)dur->valuedouble : 140;
-        esp_err_t ae = audio_beep(f, d);
-        cJSON_AddBoolToObject(resp, "ok", ae == ESP_OK);
-        cJSON_AddStringToObject(resp, "type", "ack");
-        cJSON_AddStringToObject(resp, "cmd", "beep");
-        if (ae != ESP_OK) cJSON_AddStringToObject(resp, "error", esp_err_to_name(ae));
-    } else if (str_eq(t, "speak_pcm")) {
-        // PCM16 LE mono chunk (base64). Use multiple messages to stream longer speech.
-        const cJSON *b64 = cJSON_GetObjectItem(root, "data_b64");
-        if (!cJSON_IsString(b64) || !b64->valuestring) {
-            cJSON_AddBoolToObject(resp, "ok", false);
-            cJSON_AddStringToObject(resp, "type", "ack");
-            cJSON_AddStringToObject(resp, "cmd", "speak_pcm");
-            cJSON_AddStringToObject(resp, "error", "missing_data_b64");
-        } else {
-            size_t in_len = strlen(b64->valuestring);
-            size_t out_len = 0;
-            // upper bound: 3/4 of input + a little
-            size_t out_cap = (in_len / 4) * 3 + 8;
-            uint8_t *out = (uint8_t *)calloc(1, out_cap);
-            if (!out) {
-                cJSON_AddBoolToObject(resp, "ok", false);
-                cJSON_AddStringToObject(resp, "type", "ack");
-                cJSON_AddStringToObject(resp, "cmd", "speak_pcm");
-                cJSON_AddStringToObject(resp, "error", "no_mem");
-            } else {
-                int mbed = mbedtls_base64_decode(out, out_cap, &out_len, (const unsigned char *)b64->valuestring, in_len);
-                if (mbed != 0 || out_len < 2) {
-                    cJSON_AddBoolToObject(resp, "ok", false);
-                    cJSON_AddStringToObject(resp, "type", "ack");
-                    cJSON_AddStringToObject(resp, "cmd", "speak_pcm");
-                    cJSON_AddStringToObject(resp, "error", "bad_base64");
-                } else {
-                    // Ensure 16-bit alignment
-                    out_len &= ~((size_t)1);
-                    esp_err_t ae = audio_play_pcm16_mono((const int16_t *)out, out_len / 2);
-                    cJSON_AddBoolToObject(resp, "ok", ae == ESP_OK);
-                    cJSON_AddStringToObject(resp, "type", "ack");
-                    cJSON_AddStringToObject(resp, "cmd", "speak_pcm");
-                    if (ae != ESP_OK) cJSON_AddStringToObject(resp, "error", esp_err_to_name(ae));
-                }
-                free(out);
-            }
+    const ws_cmd_entry_t *e = find_cmd(&doc, type_tok);
+    const ws_role_t role = c.sess ? c.sess->role : WS_ROLE_AUTO;
+    if (e && (!lane->control || role == WS_ROLE_OBSERVER) &&
+        !(e->flags & (lane->control ? WS_CMD_READ : WS_CMD_AUDIO))) {
+        // Face, OTA and settings commands go to /ws; observers only read.
+        c.name = e->name;
+        add_cmd_ack(&c, false);
+        json_out_str(&out, "error", lane->control ? "observer" : "wrong_lane");
+    } else if (e) {
+        if (c.sess && lane->control && role == WS_ROLE_AUTO && !(e->flags & WS_CMD_READ)) {
+            c.sess->role = WS_ROLE_CONTROLLER;
         }
+        c.name = e->name;
+        if (e->fn) e->fn(&c);
+        else run_face_cmd(&c, e->face_fn);
+    } else if (!lane->control) {
+        // No face fallback on /ws/audio: the working copy belongs to the /ws task.
+        char name[32];
+        json_strcpy(&doc, type_tok, name, sizeof(name));
+        c.name = name;
+        add_cmd_ack(&c, false);
+        json_out_str(&out, "error", "wrong_lane");
     } else {
-        bool updated = false;
-        if (!s_face || !s_face_mux) {
-            cJSON_AddBoolToObject(resp, "ok", false);
-            cJSON_AddStringToObject(resp, "error", "face_unavailable");
-        } else if (xSemaphoreTake(s_face_mux, pdMS_TO_TICKS(50)) != pdTRUE) {
-            cJSON_AddBoolToObject(resp, "ok", false);
-            cJSON_AddStringToObject(resp, "error", "face_busy");
-        } else {
-            if (str_eq(t, "set_expression")) {
-                const cJSON *expr = cJSON_GetObjectItem(root, "expression");
-                const cJSON *intensity = cJSON_GetObjectItem(root, "intensity");
-                if (cJSON_IsString(expr)) {
-                    s_face->expression = parse_expr(expr->valuestring);
-                    updated = true;
-                }
-                if (cJSON_IsNumber(intensity)) {
-                    s_face->intensity = clampf((float)intensity->valuedouble, 0.0f, 1.0f);
-                    updated = true;
-                }
-            } else if (str_eq(t, "gaze")) {
-                const cJSON *x = cJSON_GetObjectItem(root, "x");
-                const cJSON *y = cJSON_GetObjectItem(root, "y");
-                if (cJSON_IsNumber(x)) { s_face->gaze_x = clampf((float)x->valuedouble, -1.0f, 1.0f); updated = true; }
-                if (cJSON_IsNumber(y)) { s_face->gaze_y = clampf((float)y->valuedouble, -1.0f, 1.0f); updated = true; }
-            } else if (str_eq(t, "caption")) {
-                const cJSON *text = cJSON_GetObjectItem(root, "text");
-                const cJSON *ttl = cJSON_GetObjectItem(root, "ttl_ms");
-                if (cJSON_IsString(text)) {
-                    strncpy(s_face->caption, text->valuestring, sizeof(s_face->caption) - 1);
-                    s_face->caption[sizeof(s_face->caption) - 1] = 0;
-                    updated = true;
-                }
-                if (cJSON_IsNumber(ttl)) {
-                    uint32_t ttl_ms = (uint32_t)ttl->valuedouble;
-                    s_face->caption_until_ms = ttl_ms ? (n + ttl_ms) : 0;
-                    updated = true;
-                }
-            } else if (str_eq(t, "viseme")) {
-                const cJSON *name = cJSON_GetObjectItem(root, "name");
-                const cJSON *weight = cJSON_GetObjectItem(root, "weight");
-                const cJSON *ttl = cJSON_GetObjectItem(root, "ttl_ms");
-                if (cJSON_IsString(name)) {
-                    strncpy(s_face->viseme, name->valuestring, sizeof(s_face->viseme) - 1);
-                    s_face->viseme[sizeof(s_face->viseme) - 1] = 0;
-                    updated = true;
-                }
-                if (cJSON_IsNumber(weight)) {
-                    s_face->viseme_weight = clampf((float)weight->valuedouble, 0.0f, 1.0f);
-                    updated = true;
-                }
-                if (cJSON_IsNumber(ttl)) {
-                    uint32_t ttl_ms = (uint32_t)ttl->valuedouble;
-                    s_face->viseme_until_ms = ttl_ms ? (n + ttl_ms) : 0;
-                    updated = true;
-                }
-            } else if (str_eq(t, "blink")) {
-                const cJSON *dur = cJSON_GetObjectItem(root, "duration_ms");
-                uint32_t d = cJSON_IsNumber(dur) ? (uint32_t)dur->valuedouble : 150;
-                if (d > 2000) d = 2000;
-                s_face->blink_until_ms = n + d;
-                updated = true;
-            } else if (str_eq(t, "eyes")) {
-                const cJSON *open = cJSON_GetObjectItem(root, "open");
-                const cJSON *ovr = cJSON_GetObjectItem(root, "override");
-                if (cJSON_IsNumber(open)) {
-                    s_face->eye_open = clampf((float)open->valuedouble, 0.0f, 1.0f);
-                    s_face->eye_open_override = true;
-                    updated = true;
-                }
-                if (cJSON_IsBool(ovr)) {
-                    s_face->eye_open_override = cJSON_IsTrue(ovr);
-                    updated = true;
-                }
-            } else if (str_eq(t, "mouth")) {
-                const cJSON *open = cJSON_GetObjectItem(root, "open");
-                const cJSON *ovr = cJSON_GetObjectItem(root, "override");
-                if (cJSON_IsNumber(open)) {
-                    s_face->mouth_open = clampf((float)open->valuedouble, 0.0f, 1.0f);
-                    s_face->mouth_open_override = true;
-                    updated = true;
-                }
-                if (cJSON_IsBool(ovr)) {
-                    s_face->mouth_open_override = cJSON_IsTrue(ovr);
-                    updated = true;
-                }
-            } else if (str_eq(t, "rig")) {
-                // Set both eye_open and mouth_open in one message
-                const cJSON *eo = cJSON_GetObjectItem(root, "eye_open");
-                const cJSON *mo = cJSON_GetObjectItem(root, "mouth_open");
-                if (cJSON_IsNumber(eo)) {
-                    s_face->eye_open = clampf((float)eo->valuedouble, 0.0f, 1.0f);
-                    s_face->eye_open_override = true;
-                    updated = true;
-                }
-                if (cJSON_IsNumber(mo)) {
-                    s_face->mouth_open = clampf((float)mo->valuedouble, 0.0f, 1.0f);
-                    s_face->mouth_open_override = true;
-                    updated = true;
-                }
-            } else if (str_eq(t, "rig_clear")) {
-                s_face->eye_open_override = false;
-                s_face->mouth_open_override = false;
-                updated = true;
-            } else if (str_eq(t, "set_state")) {
-                // Convenience: set multiple fields at once.
-                const cJSON *st = cJSON_GetObjectItem(root, "state");
-                if (cJSON_IsObject(st)) {
-                    const cJSON *expr = cJSON_GetObjectItem(st, "expression");
-                    const cJSON *intensity = cJSON_GetObjectItem(st, "intensity");
-                    const cJSON *gx = cJSON_GetObjectItem(st, "gaze_x");
-                    const cJSON *gy = cJSON_GetObjectItem(st, "gaze_y");
-                    const cJSON *cap = cJSON_GetObjectItem(st, "caption");
-                    const cJSON *cap_ttl = cJSON_GetObjectItem(st, "caption_ttl_ms");
-                    const cJSON *eo = cJSON_GetObjectItem(st, "eye_open");
-                    const cJSON *eo_ovr = cJSON_GetObjectItem(st, "eye_open_override");
-                    const cJSON *mo = cJSON_GetObjectItem(st, "mouth_open");
-                    const cJSON *mo_ovr = cJSON_GetObjectItem(st, "mouth_open_override");
-
-                    if (cJSON_IsString(expr)) { s_face->expression = parse_expr(expr->valuestring); updated = true; }
-                    if (cJSON_IsNumber(intensity)) { s_face->intensity = clampf((float)intensity->valuedouble, 0.0f, 1.0f); updated = true; }
-                    if (cJSON_IsNumber(gx)) { s_face->gaze_x = clampf((float)gx->valuedouble, -1.0f, 1.0f); updated = true; }
-                    if (cJSON_IsNumber(gy)) { s_face->gaze_y = clampf((float)gy->valuedouble, -1.0f, 1.0f); updated = true; }
-
-                    if (cJSON_IsNumber(eo)) { s_face->eye_open = clampf((float)eo->valuedouble, 0.0f, 1.0f); updated = true; }
-                    if (cJSON_IsBool(eo_ovr)) { s_face->eye_open_override = cJSON_IsTrue(eo_ovr); updated = true; }
-                    if (cJSON_IsNumber(mo)) { s_face->mouth_open = clampf((float)mo->valuedouble, 0.0f, 1.0f); updated = true; }
-                    if (cJSON_IsBool(mo_ovr)) { s_face->mouth_open_override = cJSON_IsTrue(mo_ovr); updated = true; }
-
-                    if (cJSON_IsString(cap)) {
-                        strncpy(s_face->caption, cap->valuestring, sizeof(s_face->caption) - 1);
-                        s_face->caption[sizeof(s_face->caption) - 1] = 0;
-                        updated = true;
-                    }
-                    if (cJSON_IsNumber(cap_ttl)) {
-                        uint32_t ttl_ms = (uint32_t)cap_ttl->valuedouble;
-                        s_face->caption_until_ms = ttl_ms ? (n + ttl_ms) : 0;
-                        updated = true;
-                    }
-                }
-            } else {
-                // Unknown command
-            }
+        // Unknown command: echo the name back with a failed ack.
+        char name[32];
+        json_strcpy(&doc, type_tok, name, sizeof(name));
+        c.name = name;
+        run_face_cmd(&c, NULL);
+    }
 
-            cJSON_AddBoolToObject(resp, "ok", updated);
-            if (!updated) {
-                cJSON_AddStringToObject(resp, "error", "unknown_or_invalid_command");
-            }
+    // Fire-and-forget: successful commands get no reply; failures are still reported.
+    if (c.ack == WS_ACK_NONE && c.ok && !(e && (e->flags & WS_CMD_QUERY))) return ESP_OK;
+    return send_reply(req, &out);
+}
 
-            cJSON_AddStringToObject(resp, "type", "ack");
-            cJSON_AddStringToObject(resp, "cmd", t);
-            cJSON_AddNumberToObject(resp, "ts_ms", (double)n);
-            cJSON_AddItemToObject(resp, "state", face_to_json(s_face));
-            xSemaphoreGive(s_face_mux);
-        }
+static esp_err_t ws_handler(httpd_req_t *req) {
+    if (req->method == HTTP_GET) {
+        ESP_LOGI(TAG, "WS handshake OK");
+        return ESP_OK;
     }
 
-    cJSON_Delete(root);
+    const int64_t t0 = esp_timer_get_time();
+    ws_session_t *sess = get_session(req);
+    if (sess) sess->last_rx_us = t0;
+    esp_err_t err = ws_handle_frame(req);
+    perf_record_since(lane_of(req)->perf, t0);
+    return err;
+}
 
-    esp_err_t send_err = send_json(req, resp);
-    cJSON_Delete(resp);
-    return send_err;
+static esp_err_t lane_alloc(ws_lane_t *lane) {
+    if (!lane->rx_buf) {
+        lane->rx_buf = (uint8_t *)heap_caps_malloc(WS_MAX_FRAME_LEN, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!lane->rx_buf) lane->rx_buf = (uint8_t *)malloc(WS_MAX_FRAME_LEN);
+    }
+    if (!lane->pcm_buf) {
+        lane->pcm_buf = (uint8_t *)heap_caps_malloc(WS_PCM_LEN, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!lane->pcm_buf) lane->pcm_buf = (uint8_t *)malloc(WS_PCM_LEN);
+    }
+    return lane->rx_buf && lane->pcm_buf ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+// Second server for speech on :8081/ws/audio, below the control task's priority. Without it
+// speech still works on /ws, just on the same task as face commands.
+static esp_err_t start_audio_lane(void) {
+    ESP_RETURN_ON_ERROR(lane_alloc(&s_audio_lane), TAG, "audio lane buffers");
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.core_id = CONFIG_LITTLEAI_WS_TASK_CORE < 0 ? tskNO_AFFINITY : CONFIG_LITTLEAI_WS_TASK_CORE;
+    config.task_priority = CONFIG_LITTLEAI_WS_AUDIO_TASK_PRIORITY;
+    config.server_port = 8081;
+    config.ctrl_port = 32770;
+    config.max_open_sockets = WS_AUDIO_MAX_CLIENTS;
+    config.lru_purge_enable = true;
+
+    ESP_LOGI(TAG, "Starting WS audio lane on :%d/ws/audio", config.server_port);
+    esp_err_t err = httpd_start(&s_audio_httpd, &config);
+    if (err != ESP_OK) {
+        s_audio_httpd = NULL;
+        return err;
+    }
+
+    httpd_uri_t ws = {
+        .uri = "/ws/audio",
+        .method = HTTP_GET,
+        .handler = ws_handler,
+        .user_ctx = &s_audio_lane,
+        .is_websocket = true,
+    };
+    return httpd_register_uri_handler(s_audio_httpd, &ws);
 }
 
 esp_err_t ws_server_start(const ws_server_config_t *cfg) {
     if (s_httpd) return ESP_OK;
 
-    if (!cfg || !cfg->face || !cfg->face_mutex) {
-        ESP_LOGE(TAG, "ws_server_start: missing cfg/face/mutex");
+    if (!cfg || !cfg->face) {
+        ESP_LOGE(TAG, "ws_server_start: missing cfg/face");
         return ESP_ERR_INVALID_ARG;
     }
 
+    for (size_t i = 1; i < sizeof(s_cmds) / sizeof(s_cmds[0]); i++) {
+        if (strcmp(s_cmds[i - 1].name, s_cmds[i].name) >= 0) {
+            ESP_LOGE(TAG, "command table not sorted at '%s'", s_cmds[i].name);
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+
     s_face = cfg->face;
-    s_face_mux = cfg->face_mutex;
+    face_store_read(s_face, &s_draft);
+    s_on_face_changed = cfg->on_face_changed;
+
+    if (lane_alloc(&s_ctl_lane) != ESP_OK) {
+        ESP_LOGE(TAG, "ws buffer alloc failed");
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err;
+
+    const esp_timer_create_args_t push_timer_args = {
+        .callback = push_timer_cb,
+        .name = "ws_push",
+    };
+    err = esp_timer_create(&push_timer_args, &s_push_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "push timer create failed: %s", esp_err_to_name(err));
+        return err;
+    }
 
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.core_id = CONFIG_LITTLEAI_WS_TASK_CORE < 0 ? tskNO_AFFINITY : CONFIG_LITTLEAI_WS_TASK_CORE;
+    config.task_priority = CONFIG_LITTLEAI_WS_TASK_PRIORITY;
     config.server_port = 8080;
     config.ctrl_port = 32769;
-    config.lru_purge_enable = true;
+    config.max_open_sockets = WS_MAX_CLIENTS + 1; // one spare, see ws_open()
+    config.open_fn = ws_open;
 
     ESP_LOGI(TAG, "Starting WS server on :%d/ws", config.server_port);
 
-    esp_err_t err = httpd_start(&s_httpd, &config);
+    err = httpd_start(&s_httpd, &config);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "httpd_start failed: %s", esp_err_to_name(err));
         s_httpd = NULL;
@@ -415,10 +2131,13 @@ esp_err_t ws_server_start(const ws_server_config_t *cfg) {
         .uri = "/ws",
         .method = HTTP_GET,
         .handler = ws_handler,
-        .user_ctx = NULL,
+        .user_ctx = &s_ctl_lane,
         .is_websocket = true,
     };
     httpd_register_uri_handler(s_httpd, &ws);
 
+    err = start_audio_lane();
+    if (err != ESP_OK) ESP_LOGW(TAG, "audio lane unavailable (%s); speech stays on /ws", esp_err_to_name(err));
+
     return ESP_OK;
 }
@@ -1,24 +1,91 @@
 #pragma once
 
 #include "esp_err.h"
-#include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
 
+#include "audio_codec.h"
 #include "face_protocol.h"
+#include "touch_gesture.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 typedef struct {
-    face_state_t *face;
-    SemaphoreHandle_t face_mutex;
+    // Published face state. The WS server is its only writer; it seeds its working copy from
+    // the store at start, so initialise the store first.
+    face_store_t *face;
+    // Optional: called on the httpd task after a command published a new state (e.g. to wake the renderer).
+    void (*on_face_changed)(void);
 } ws_server_config_t;
 
+// Binary speech frames (HTTPD_WS_TYPE_BINARY on /ws):
+//   [speak_frame_hdr_t][payload]
+// All multi-byte fields are little-endian. hdr_len is the payload offset, so newer hosts
+// can append header fields; the device skips anything it does not know about.
+// Headers shorter than SPEAK_FRAME_HDR_TIMED_LEN (but at least SPEAK_FRAME_HDR_MIN_LEN)
+// carry no ts_ms and are played untimed; without sample_rate the payload is at 16 kHz.
+#define SPEAK_FRAME_MAGIC 0x53 // 'S'
+#define SPEAK_FRAME_HDR_MIN_LEN 12
+#define SPEAK_FRAME_HDR_TIMED_LEN 16
+
+#define SPEAK_FLAG_END 0x01 // last chunk of the stream (payload may be empty)
+
+typedef struct __attribute__((packed)) {
+    uint8_t magic;      // SPEAK_FRAME_MAGIC
+    uint8_t hdr_len;    // bytes from start of frame to payload (>= SPEAK_FRAME_HDR_MIN_LEN)
+    uint8_t codec;      // audio_codec_t (0 = PCM16 LE mono, 1 = IMA-ADPCM, 2 = Opus)
+    uint8_t flags;      // SPEAK_FLAG_*
+    uint16_t stream_id; // host-chosen id for one utterance
+    uint16_t reserved;
+    uint32_t seq;       // chunk sequence number within the stream
+    uint32_t ts_ms;     // stream time of the first sample (jitter buffer scheduling)
+    uint32_t sample_rate; // PCM16/ADPCM source rate in Hz (8000..48000, 0 = 16 kHz); resampled on device
+} speak_frame_hdr_t;
+
+// Firmware update frames (HTTPD_WS_TYPE_BINARY on /ws, after {"type":"ota_begin"}):
+//   [ota_frame_hdr_t][image bytes starting at `offset`]
+// Frames may be any size; each is written to flash as it is received and acked with the
+// next expected offset.
+#define OTA_FRAME_MAGIC 0x4F // 'O'
+#define OTA_FRAME_HDR_LEN 8
+
+typedef struct __attribute__((packed)) {
+    uint8_t magic;     // OTA_FRAME_MAGIC
+    uint8_t hdr_len;   // bytes from start of frame to payload (>= OTA_FRAME_HDR_LEN)
+    uint16_t reserved;
+    uint32_t offset;   // image offset of the first payload byte
+} ota_frame_hdr_t;
+
 // Start a WebSocket server on http://<ip>:8080/ws
-// Incoming JSON commands update the provided face state.
+// Incoming JSON commands update and publish the face state; binary frames carry speech audio.
 esp_err_t ws_server_start(const ws_server_config_t *cfg);
 
+// Tell subscribers the observable face state changed without a publish (a TTL ran out).
+// Cheap and safe from any task.
+void ws_server_notify_face_changed(void);
+
+// Push a recognized touch gesture to subscribers (those that did not subscribe with
+// "touch":false) as {"type":"touch","gesture":...}. Non-blocking; safe from any task.
+void ws_server_notify_touch(const touch_gesture_t *g);
+
+// Latest-value face update from a lossy stream (the UDP channel, see udp_ctl.h).
+#define WS_STREAM_GAZE 0x01  // gaze_x, gaze_y
+#define WS_STREAM_MOUTH 0x02 // mouth_open
+#define WS_STREAM_EYES 0x04  // eye_open
+
+typedef struct {
+    uint8_t mask; // WS_STREAM_*
+    float gaze_x, gaze_y;
+    float mouth_open;
+    float eye_open;
+} ws_stream_update_t;
+
+// Apply an update on the /ws task, with the same effect as the matching gaze/mouth/eyes
+// commands. Updates submitted before that task gets to them are merged (newer values win),
+// so a burst costs one publish; *coalesced (optional) tells the caller this one was merged.
+// Non-blocking; safe from any task.
+esp_err_t ws_server_submit_stream(const ws_stream_update_t *u, bool *coalesced);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,216 @@
+// Host-side tests for the WS JSON tokenizer/writer (src/ws_json.c): pio test -e native
+#include <string.h>
+
+#include <unity.h>
+
+#include "ws_json.h"
+
+#define NTOK 64
+
+static json_doc_t s_doc;
+static json_tok_t s_tok[NTOK];
+
+static bool parse(const char *js) {
+    return json_parse(&s_doc, js, strlen(js), s_tok, NTOK);
+}
+
+void setUp(void) {
+    memset(&s_doc, 0, sizeof(s_doc));
+}
+
+void tearDown(void) {}
+
+// ---------- Tokenizer ----------
+
+static void test_parse_command(void) {
+    TEST_ASSERT_TRUE(parse(" {\"type\":\"gaze\", \"x\":-0.25, \"y\":1e-1, \"on\":true, \"n\":null, \"a\":[1,{\"b\":2}]} "));
+    TEST_ASSERT_EQUAL(JSON_OBJECT, s_tok[0].type);
+    TEST_ASSERT_EQUAL(s_doc.ntok, s_tok[0].next);
+
+    TEST_ASSERT_TRUE(json_eq(&s_doc, json_get(&s_doc, 0, "type"), "gaze"));
+    double v = 0;
+    TEST_ASSERT_TRUE(json_number(&s_doc, json_get(&s_doc, 0, "x"), &v));
+    TEST_ASSERT_EQUAL_FLOAT(-0.25f, (float)v);
+    TEST_ASSERT_TRUE(json_number(&s_doc, json_get(&s_doc, 0, "y"), &v));
+    TEST_ASSERT_EQUAL_FLOAT(0.1f, (float)v);
+    TEST_ASSERT_TRUE(json_is_true(&s_doc, json_get(&s_doc, 0, "on")));
+    TEST_ASSERT_TRUE(json_is(&s_doc, json_get(&s_doc, 0, "n"), JSON_NULL));
+
+    // Keys inside nested values are not found from the root, and missing keys give -1.
+    const int a = json_get(&s_doc, 0, "a");
+    TEST_ASSERT_TRUE(json_is(&s_doc, a, JSON_ARRAY));
+    TEST_ASSERT_EQUAL(-1, json_get(&s_doc, 0, "b"));
+    TEST_ASSERT_EQUAL(-1, json_get(&s_doc, 0, "missing"));
+    TEST_ASSERT_EQUAL(-1, json_get(&s_doc, a, "b")); // not an object
+    TEST_ASSERT_FALSE(json_number(&s_doc, json_get(&s_doc, 0, "type"), &v));
+}
+
+static void test_rejects_every_truncation(void) {
+    static const char *docs[] = {
+        "{\"type\":\"caption\",\"text\":\"a\\\"b\\u00e9\",\"ttl_ms\":1500,\"cmds\":[{\"x\":-1.5e+2},true,false,null]}",
+        "[1,22,-3.25,\"s\",{},[]]",
+    };
+    for (size_t k = 0; k < sizeof(docs) / sizeof(docs[0]); k++) {
+        const size_t len = strlen(docs[k]);
+        TEST_ASSERT_TRUE(json_parse(&s_doc, docs[k], len, s_tok, NTOK));
+        for (size_t n = 0; n < len; n++) {
+            TEST_ASSERT_FALSE_MESSAGE(json_parse(&s_doc, docs[k], n, s_tok, NTOK), docs[k]);
+            TEST_ASSERT_EQUAL(0, s_doc.ntok);
+        }
+    }
+}
+
+static void test_rejects_malformed(void) {
+    static const char *bad[] = {
+        "", " ", "{", "}", "{\"a\"}", "{\"a\":}", "{\"a\":1,}", "[1,]", "{a:1}", "{\"a\":1}x", "{\"a\":1}{}",
+        "01x", "-", "1.", "1e", "1e+", ".5", "tru", "nul", "\"abc", "\"a\\\"", "\"\\x\"", "\"\\u12\"",
+        "\"\\u12g4\"", "\"a\nb\"", "[\"\\",
+    };
+    for (size_t k = 0; k < sizeof(bad) / sizeof(bad[0]); k++) {
+        TEST_ASSERT_FALSE_MESSAGE(parse(bad[k]), bad[k]);
+        TEST_ASSERT_EQUAL(0, s_doc.ntok);
+    }
+}
+
+static void test_nesting_limit(void) {
+    // 8 levels of containers are accepted, the 9th is not (objects and arrays alike).
+    TEST_ASSERT_TRUE(parse("[[[[[[[[1]]]]]]]]"));
+    TEST_ASSERT_FALSE(parse("[[[[[[[[[1]]]]]]]]]"));
+    TEST_ASSERT_TRUE(parse("{\"a\":{\"a\":{\"a\":{\"a\":{\"a\":{\"a\":{\"a\":{\"a\":1}}}}}}}}"));
+    TEST_ASSERT_FALSE(parse("{\"a\":{\"a\":{\"a\":{\"a\":{\"a\":{\"a\":{\"a\":{\"a\":{\"a\":1}}}}}}}}}"));
+    TEST_ASSERT_FALSE(parse("{\"a\":[{\"a\":[{\"a\":[{\"a\":[{\"a\":1}]}]}]}]}"));
+
+    // Deep garbage is cut off at the limit instead of recursing through all of it.
+    char deep[4096];
+    memset(deep, '[', sizeof(deep));
+    TEST_ASSERT_FALSE(json_parse(&s_doc, deep, sizeof(deep), s_tok, NTOK));
+}
+
+static void test_token_overflow(void) {
+    const char *js = "{\"a\":[1,2,3],\"b\":\"c\"}"; // 1 + 2 + 3 + 2 = 8 tokens
+    TEST_ASSERT_TRUE(json_parse(&s_doc, js, strlen(js), s_tok, 8));
+    TEST_ASSERT_EQUAL(8, s_doc.ntok);
+    TEST_ASSERT_FALSE(json_parse(&s_doc, js, strlen(js), s_tok, 7));
+    TEST_ASSERT_EQUAL(0, s_doc.ntok);
+    TEST_ASSERT_FALSE(json_parse(&s_doc, js, strlen(js), s_tok, 0));
+
+    // The tokenizer never writes past cap.
+    json_tok_t guard[9];
+    memset(guard, 0xA5, sizeof(guard));
+    TEST_ASSERT_FALSE(json_parse(&s_doc, js, strlen(js), guard, 4));
+    for (int i = 4; i < 9; i++) TEST_ASSERT_EQUAL_HEX8(0xA5, guard[i].type);
+}
+
+static void test_string_escapes(void) {
+    TEST_ASSERT_TRUE(parse("{\"t\":\"a\\\"b\\\\c\\/d\\n\\t\\u00e9\\u20ac\\ud83d\\ude00\",\"plain\":\"gaze\",\"e\":\"ga\\u007ae\"}"));
+    const int t = json_get(&s_doc, 0, "t");
+    TEST_ASSERT_EQUAL(1, s_tok[t].escaped);
+
+    char out[64];
+    TEST_ASSERT_TRUE(json_strcpy(&s_doc, t, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("a\"b\\c/d\n\t\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80", out);
+
+    // Escaped strings never compare equal, even if they decode to the key.
+    TEST_ASSERT_TRUE(json_eq(&s_doc, json_get(&s_doc, 0, "plain"), "gaze"));
+    TEST_ASSERT_FALSE(json_eq(&s_doc, json_get(&s_doc, 0, "e"), "gaze"));
+
+    // Truncation keeps the NUL and never splits a UTF-8 sequence.
+    TEST_ASSERT_TRUE(json_strcpy(&s_doc, t, out, 11));
+    TEST_ASSERT_EQUAL_STRING("a\"b\\c/d\n\t", out);
+    TEST_ASSERT_TRUE(json_strcpy(&s_doc, t, out, 1));
+    TEST_ASSERT_EQUAL_STRING("", out);
+    TEST_ASSERT_FALSE(json_strcpy(&s_doc, 0, out, sizeof(out))); // not a string
+    TEST_ASSERT_EQUAL_STRING("", out);
+
+    // A lone high surrogate is kept as a 3-byte sequence rather than read past the string.
+    TEST_ASSERT_TRUE(parse("\"\\ud83d\""));
+    TEST_ASSERT_TRUE(json_strcpy(&s_doc, 0, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("\xed\xa0\xbd", out);
+}
+
+static void test_embedded_nul_is_data(void) {
+    // Frames are length-delimited; a NUL inside a string is a control character, after the
+    // value it is trailing garbage.
+    static const char a[] = "{\"a\":\"x\0y\"}";
+    TEST_ASSERT_FALSE(json_parse(&s_doc, a, sizeof(a) - 1, s_tok, NTOK));
+    static const char b[] = "{\"a\":1}\0";
+    TEST_ASSERT_FALSE(json_parse(&s_doc, b, sizeof(b) - 1, s_tok, NTOK));
+}
+
+// ---------- Writer ----------
+
+static void test_writer_nesting_and_escapes(void) {
+    char buf[256];
+    json_out_t o;
+    json_out_init(&o, buf, sizeof(buf));
+    json_out_str(&o, "type", "say \"hi\"\\\n");
+    json_out_int(&o, "min", INT64_MIN);
+    json_out_float(&o, "f", -0.125f);
+    json_out_bool(&o, "b", false);
+    json_out_arr(&o, "a");
+    json_out_item_int(&o, 1);
+    json_out_item_obj(&o);
+    json_out_int(&o, "x", 2);
+    json_out_close(&o);
+    json_out_close(&o);
+    json_out_obj(&o, "o"); // left open: finish closes it
+    json_out_str(&o, "k", NULL);
+    const size_t n = json_out_finish(&o);
+    const char *want = "{\"type\":\"say \\\"hi\\\"\\\\\\u000a\",\"min\":-9223372036854775808,\"f\":-0.125,"
+                       "\"b\":false,\"a\":[1,{\"x\":2}],\"o\":{\"k\":\"\"}}";
+    TEST_ASSERT_EQUAL_STRING(want, buf);
+    TEST_ASSERT_EQUAL(strlen(want), n);
+
+    // The output parses back.
+    TEST_ASSERT_TRUE(json_parse(&s_doc, buf, n, s_tok, NTOK));
+    char s[32];
+    TEST_ASSERT_TRUE(json_strcpy(&s_doc, json_get(&s_doc, 0, "type"), s, sizeof(s)));
+    TEST_ASSERT_EQUAL_STRING("say \"hi\"\\\n", s);
+}
+
+static void test_writer_overflow(void) {
+    char buf[16];
+    json_out_t o;
+    json_out_init(&o, buf, sizeof(buf));
+    json_out_str(&o, "type", "0123456789abcdef");
+    TEST_ASSERT_EQUAL(0, json_out_finish(&o));
+    TEST_ASSERT_EQUAL_STRING("", buf);
+
+    // Exactly full (15 chars + NUL) fits; one more byte does not.
+    json_out_init(&o, buf, sizeof(buf));
+    json_out_str(&o, "k", "0123456");
+    TEST_ASSERT_EQUAL(15, json_out_finish(&o));
+    json_out_init(&o, buf, sizeof(buf));
+    json_out_str(&o, "k", "01234567");
+    TEST_ASSERT_EQUAL(0, json_out_finish(&o));
+}
+
+static void test_writer_depth_limit(void) {
+    char buf[256];
+    json_out_t o;
+    json_out_init(&o, buf, sizeof(buf));
+    for (int i = 0; i < 7; i++) json_out_obj(&o, "a"); // root + 7 = 8 levels
+    TEST_ASSERT_FALSE(o.overflow);
+    TEST_ASSERT_EQUAL(1 + 7 * 5 + 8, json_out_finish(&o));
+    TEST_ASSERT_TRUE(json_parse(&s_doc, buf, strlen(buf), s_tok, NTOK));
+
+    json_out_init(&o, buf, sizeof(buf));
+    for (int i = 0; i < 8; i++) json_out_arr(&o, "a");
+    TEST_ASSERT_TRUE(o.overflow);
+    TEST_ASSERT_EQUAL(0, json_out_finish(&o));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_command);
+    RUN_TEST(test_rejects_every_truncation);
+    RUN_TEST(test_rejects_malformed);
+    RUN_TEST(test_nesting_limit);
+    RUN_TEST(test_token_overflow);
+    RUN_TEST(test_string_escapes);
+    RUN_TEST(test_embedded_nul_is_data);
+    RUN_TEST(test_writer_nesting_and_escapes);
+    RUN_TEST(test_writer_overflow);
+    RUN_TEST(test_writer_depth_limit);
+    return UNITY_END();
+}
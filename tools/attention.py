@@ -21,6 +21,7 @@ Modes:
 import argparse
 import asyncio
 import base64
+import json
 import os
 import subprocess
 import tempfile
@@ -29,6 +30,8 @@ import array
 
 import websockets
 
+from pacing import pace
+
 SAMPLE_RATE = 16000
 CHUNK_SAMPLES = 800  # 50ms @ 16kHz
 
@@ -96,6 +99,7 @@ async def stream_wav(ws, wav_path: str):
             rep = await ws.recv()
             if '"ok":true' not in rep:
                 print(rep)
+            await pace(rep)
 
     await ws_send(ws, {"type": "mouth", "open": 0.0})
     await ws_send(ws, {"type": "rig_clear"})
@@ -122,11 +126,13 @@ async def run(ip: str, text: str, mode: str, beep: bool, speak: bool):
         await ws_send(ws, {"type": "caption", "text": sanitize_text(text), "ttl_ms": 12000})
         await ws_send(ws, {"type": "set_expression", "expression": expr})
 
-        # A little eye movement to make it feel alive
-        if mode == "urgent":
-            await ws_send(ws, {"type": "gaze", "x": -0.55, "y": -0.05})
-        else:
-            await ws_send(ws, {"type": "gaze", "x": 0.35, "y": -0.1})
+        # A little eye movement to make it feel alive (eased on-device)
+        gx, gy = (-0.55, -0.05) if mode == "urgent" else (0.35, -0.1)
+        await ws_send(ws, {
+            "type": "animate",
+            "gaze_x": {"to": gx, "duration_ms": 220, "ease": "out"},
+            "gaze_y": {"to": gy, "duration_ms": 220, "ease": "out"},
+        })
         await ws_send(ws, {"type": "blink", "duration_ms": blink_ms})
 
         # Beep pattern (optional)
@@ -145,7 +151,11 @@ async def run(ip: str, text: str, mode: str, beep: bool, speak: bool):
         # Reset expression back to neutral after a beat
         await asyncio.sleep(0.4)
         await ws_send(ws, {"type": "set_expression", "expression": "neutral"})
-        await ws_send(ws, {"type": "gaze", "x": 0.0, "y": 0.0})
+        await ws_send(ws, {
+            "type": "animate",
+            "gaze_x": {"to": 0.0, "duration_ms": 300, "ease": "in_out"},
+            "gaze_y": {"to": 0.0, "duration_ms": 300, "ease": "in_out"},
+        })
         # Ensure rig overrides aren't left sticky if we didn't speak
         await ws_send(ws, {"type": "rig_clear"})
 
@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""Find littleAI devices on the LAN via mDNS/DNS-SD (service type _littleai._tcp).
+
+Usage:
+  python3 tools/discover.py                        # table: name, host, IP, version, features
+  python3 tools/discover.py --json                 # full TXT records
+  python3 tools/discover.py --hosts > fleet.txt    # one IP per line, for ota_push.py --hosts
+  python3 tools/discover.py --cap speech --udp     # only devices offering speech and the UDP channel
+
+Notes:
+- Needs `pip install zeroconf`.
+- Each device is advertised under its FACE_DEVICE_NAME (platformio.ini) as <name>-<mac6>.local,
+  with TXT records: proto, id (MAC), ver, path (/ws), audio (port of /ws/audio), codecs, rates,
+  caps, panel and udp (UDP face channel port, only when it is running). See README "Discovery".
+"""
+
+import argparse
+import json
+import time
+
+from zeroconf import ServiceBrowser, ServiceListener, Zeroconf
+
+SERVICE_TYPE = "_littleai._tcp.local."
+
+
+class _Collector(ServiceListener):
+    def __init__(self):
+        self.names = set()
+
+    def add_service(self, zc, type_, name):
+        self.names.add(name)
+
+    def update_service(self, zc, type_, name):
+        self.names.add(name)
+
+    def remove_service(self, zc, type_, name):
+        self.names.discard(name)
+
+
+def browse(timeout: float = 3.0) -> list:
+    """Devices that answered within `timeout` s, sorted by name. Each is a dict:
+    name, host, ip, port, txt (str -> str), caps (list)."""
+    zc = Zeroconf()
+    try:
+        listener = _Collector()
+        ServiceBrowser(zc, SERVICE_TYPE, listener)
+        time.sleep(timeout)
+        devices = []
+        for name in sorted(listener.names):
+            info = zc.get_service_info(SERVICE_TYPE, name, timeout=2000)
+            if not info:
+                continue
+            addrs = info.parsed_addresses()
+            txt = {k.decode(): (v or b"").decode() for k, v in info.properties.items()}
+            devices.append({
+                "name": name[:-len(SERVICE_TYPE) - 1] if name.endswith("." + SERVICE_TYPE) else name,
+                "host": (info.server or "").rstrip("."),
+                "ip": addrs[0] if addrs else None,
+                "port": info.port,
+                "txt": txt,
+                "caps": [c for c in txt.get("caps", "").split(",") if c],
+            })
+        return devices
+    finally:
+        zc.close()
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--timeout", type=float, default=3.0, help="seconds to listen for answers")
+    ap.add_argument("--cap", action="append", default=[], help="only devices with this capability (repeatable)")
+    ap.add_argument("--udp", action="store_true", help="only devices with the UDP face channel running")
+    out = ap.add_mutually_exclusive_group()
+    out.add_argument("--json", action="store_true", help="print the devices as JSON")
+    out.add_argument("--hosts", action="store_true", help="print one IP per line")
+    args = ap.parse_args()
+
+    devices = [d for d in browse(args.timeout)
+               if d["ip"] and all(c in d["caps"] for c in args.cap) and (d["txt"].get("udp") or not args.udp)]
+
+    if args.json:
+        print(json.dumps(devices, indent=2))
+    elif args.hosts:
+        for d in devices:
+            print(d["ip"])
+    else:
+        for d in devices:
+            t = d["txt"]
+            print(f"{d['name']:<24} {d['host']:<28} {d['ip']:<15} {t.get('ver', '?'):<12} "
+                  f"codecs={t.get('codecs', '')} udp={t.get('udp') or '-'} caps={t.get('caps', '')}")
+        print(f"{len(devices)} device(s)")
+    raise SystemExit(0 if devices else 1)
+
+
+if __name__ == "__main__":
+    main()
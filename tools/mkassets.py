@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""Build the flash asset pack (fonts, images, sound clips) for the "assets" partition.
+
+Usage:
+  python3 tools/mkassets.py -o assets.bin --font caption=caption_20.bin \
+      --image logo=logo.bin --clip chime=chime.wav --clip boot=boot.wav --adpcm
+  parttool.py --port /dev/ttyACM0 write_partition --partition-name assets --input assets.bin
+
+Notes:
+- Fonts: LVGL binary fonts (lv_font_conv --format bin). "caption" and "mouth" replace the
+  built-in font of those labels.
+- Images: LVGL binary images (4-byte lv_img_header_t + pixels, e.g. LVGL's image converter
+  with "Binary" output, RGB565 to match the panel).
+- Clips: 16-bit mono WAV at the device rate (16000 Hz); stored as PCM16 or, with --adpcm,
+  IMA-ADPCM. Play with {"type":"play_clip","id":"chime"}.
+- Layout is in include/assets.h.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import wave
+
+PACK_MAGIC = 0x4B50414C  # "LAPK"
+PACK_VERSION = 1
+PACK_HDR = struct.Struct("<IHHI")      # magic, version, count, total_size
+ENTRY = struct.Struct("<24sBBHIII")    # name, type, codec, reserved, offset, size, param
+NAME_LEN = 24
+PARTITION_SIZE = 4 * 1024 * 1024       # partitions.csv
+
+ASSET_FONT, ASSET_IMAGE, ASSET_CLIP = 1, 2, 3
+CODEC_PCM16, CODEC_ADPCM = 0, 1        # audio_codec_t
+SAMPLE_RATE = 16000
+
+
+def named(arg: str):
+    name, sep, path = arg.partition("=")
+    if not sep or not name or not path:
+        raise argparse.ArgumentTypeError(f"expected name=file, got {arg!r}")
+    if len(name.encode()) >= NAME_LEN:
+        raise argparse.ArgumentTypeError(f"name {name!r} is longer than {NAME_LEN - 1} bytes")
+    return name, path
+
+
+def load_clip(path: str, adpcm: bool):
+    with wave.open(path, "rb") as w:
+        if w.getnchannels() != 1 or w.getsampwidth() != 2:
+            raise SystemExit(f"{path}: need 16-bit mono WAV")
+        if w.getframerate() != SAMPLE_RATE:
+            raise SystemExit(f"{path}: {w.getframerate()} Hz, device plays {SAMPLE_RATE} Hz")
+        pcm = w.readframes(w.getnframes())
+    if adpcm:
+        # Same encoder as the speech streamer (imports websockets, so only when needed).
+        sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+        from speak_ws import AdpcmEncoder
+        return AdpcmEncoder().encode(pcm), CODEC_ADPCM
+    return pcm, CODEC_PCM16
+
+
+def build(entries) -> bytes:
+    # entries: (name, type, codec, param, data)
+    names = [e[0] for e in entries]
+    dup = {n for n in names if names.count(n) > 1}
+    if dup:
+        raise SystemExit(f"duplicate asset names: {', '.join(sorted(dup))}")
+
+    offset = PACK_HDR.size + ENTRY.size * len(entries)
+    index, blobs = [], []
+    for name, kind, codec, param, data in entries:
+        offset = (offset + 3) & ~3
+        index.append(ENTRY.pack(name.encode(), kind, codec, 0, offset, len(data), param))
+        blobs.append((offset, data))
+        offset += len(data)
+
+    out = bytearray(PACK_HDR.pack(PACK_MAGIC, PACK_VERSION, len(entries), offset) + b"".join(index))
+    for off, data in blobs:
+        out += bytes(off - len(out)) + data
+    return bytes(out)
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("-o", "--out", required=True, help="pack to write (assets.bin)")
+    ap.add_argument("--font", type=named, action="append", default=[], metavar="NAME=FILE")
+    ap.add_argument("--image", type=named, action="append", default=[], metavar="NAME=FILE")
+    ap.add_argument("--clip", type=named, action="append", default=[], metavar="NAME=WAV")
+    ap.add_argument("--adpcm", action="store_true", help="store clips as IMA-ADPCM (4:1)")
+    args = ap.parse_args()
+
+    entries = []
+    for name, path in args.font:
+        with open(path, "rb") as f:
+            entries.append((name, ASSET_FONT, 0, 0, f.read()))
+    for name, path in args.image:
+        with open(path, "rb") as f:
+            entries.append((name, ASSET_IMAGE, 0, 0, f.read()))
+    for name, path in args.clip:
+        data, codec = load_clip(path, args.adpcm)
+        entries.append((name, ASSET_CLIP, codec, SAMPLE_RATE, data))
+    if not entries:
+        ap.error("nothing to pack: use --font, --image and/or --clip")
+
+    pack = build(entries)
+    if len(pack) > PARTITION_SIZE:
+        raise SystemExit(f"pack is {len(pack)} bytes, the assets partition holds {PARTITION_SIZE}")
+    with open(args.out, "wb") as f:
+        f.write(pack)
+    print(f"{args.out}: {len(entries)} assets, {len(pack)} bytes")
+
+
+if __name__ == "__main__":
+    main()
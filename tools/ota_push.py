@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Push a firmware image to one or many devices over the WebSocket API (dual-slot OTA).
+
+Usage:
+  python3 tools/ota_push.py --bin .pio/build/esp32-s3-amoled18/firmware.bin --ip 192.168.1.40 --ip 192.168.1.41
+  python3 tools/ota_push.py --bin firmware.bin --hosts fleet.txt --parallel 8
+
+Notes:
+- Device expects WS: ws://<ip>:8080/ws
+- Protocol (see README "Firmware update (OTA)"):
+    {"type":"ota_begin","size":N,"sha256":"<hex>"} -> {"offset":...} (non-zero when resuming)
+    binary frames: 8-byte header (magic 0x4F, hdr_len, reserved, u32 LE offset) + image bytes
+    {"type":"ota_end"} -> device verifies SHA-256, switches slot and reboots
+- A dropped connection is retried and the transfer resumes where the device left off.
+- The new image confirms itself once it is back on Wi-Fi; otherwise the device rolls back.
+"""
+
+import argparse
+import asyncio
+import hashlib
+import json
+import struct
+import time
+
+import websockets
+
+OTA_FRAME_MAGIC = 0x4F
+OTA_HDR = struct.Struct("<BBHI")  # magic, hdr_len, reserved, offset
+
+
+def ota_frame(offset: int, payload: bytes) -> bytes:
+    return OTA_HDR.pack(OTA_FRAME_MAGIC, OTA_HDR.size, 0, offset) + payload
+
+
+async def recv_reply(ws, *names: str, timeout: float = 30.0) -> dict:
+    # Skip state pushes, touch events and replies meant for other commands.
+    while True:
+        rep = json.loads(await asyncio.wait_for(ws.recv(), timeout))
+        if rep.get("cmd") in names or rep.get("type") in names:
+            return rep
+
+
+async def push_once(ip: str, image: bytes, sha: str, chunk: int, log) -> None:
+    async with websockets.connect(f"ws://{ip}:8080/ws", max_size=None) as ws:
+        await ws.send(json.dumps({"type": "ota_begin", "size": len(image), "sha256": sha}))
+        rep = await recv_reply(ws, "ota_begin")
+        if not rep.get("ok"):
+            raise RuntimeError(f"ota_begin: {rep.get('error')}")
+        offset = rep.get("offset", 0)
+        log(f"{'resuming at ' + str(offset) if offset else 'started'} -> {rep.get('target')} "
+            f"(running {rep.get('running')} {rep.get('version')})")
+
+        last_pct = -1
+        while offset < len(image):
+            await ws.send(ota_frame(offset, image[offset:offset + chunk]))
+            rep = await recv_reply(ws, "ota_data")
+            if not rep.get("ok") and rep.get("error") != "bad_offset":
+                raise RuntimeError(f"ota_data at {offset}: {rep.get('error')}")
+            offset = rep.get("offset", offset)  # bad_offset: device tells us where it is
+            pct = offset * 100 // len(image)
+            if pct // 10 != last_pct // 10:
+                log(f"{pct}%")
+                last_pct = pct
+
+        await ws.send(json.dumps({"type": "ota_end", "reboot": True}))
+        rep = await recv_reply(ws, "ota_end", timeout=60.0)
+        if not rep.get("ok"):
+            raise RuntimeError(f"ota_end: {rep.get('error')}")
+
+
+async def wait_confirmed(ip: str, timeout: float, log) -> bool:
+    deadline = time.monotonic() + timeout
+    await asyncio.sleep(5)
+    while time.monotonic() < deadline:
+        try:
+            async with websockets.connect(f"ws://{ip}:8080/ws", open_timeout=5) as ws:
+                await ws.send('{"type":"ota_status"}')
+                rep = await recv_reply(ws, "ota_status", timeout=5)
+                if not rep.get("pending_verify"):
+                    log(f"back up: running {rep.get('running')} {rep.get('version')}")
+                    return True
+        except (OSError, asyncio.TimeoutError, websockets.WebSocketException):
+            pass
+        await asyncio.sleep(2)
+    log("did not come back confirmed")
+    return False
+
+
+async def push_device(ip: str, image: bytes, sha: str, args, sem: asyncio.Semaphore) -> bool:
+    def log(msg: str) -> None:
+        print(f"[{ip}] {msg}", flush=True)
+
+    async with sem:
+        for attempt in range(1, args.retries + 1):
+            try:
+                await push_once(ip, image, sha, args.chunk, log)
+                break
+            except (OSError, asyncio.TimeoutError, websockets.WebSocketException) as e:
+                log(f"connection lost ({e!r}); retry {attempt}/{args.retries}")
+                await asyncio.sleep(2)
+            except RuntimeError as e:
+                log(f"failed: {e}")
+                return False
+        else:
+            log("giving up")
+            return False
+
+        log("image verified; rebooting into it")
+        return await wait_confirmed(ip, args.confirm_timeout, log) if args.wait else True
+
+
+async def push_fleet(ips, image: bytes, args) -> int:
+    sha = hashlib.sha256(image).hexdigest()
+    print(f"{len(image)} bytes, sha256 {sha}, {len(ips)} device(s), {args.parallel} at a time")
+    sem = asyncio.Semaphore(args.parallel)
+    results = await asyncio.gather(*(push_device(ip, image, sha, args, sem) for ip in ips))
+    failed = [ip for ip, ok in zip(ips, results) if not ok]
+    print(f"done: {len(ips) - len(failed)} ok, {len(failed)} failed" + (f" ({', '.join(failed)})" if failed else ""))
+    return 1 if failed else 0
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--bin", required=True, help="app image (firmware.bin)")
+    ap.add_argument("--ip", action="append", default=[], help="device IP (repeatable)")
+    ap.add_argument("--hosts", help="file with one device IP per line (# comments allowed)")
+    ap.add_argument("--parallel", type=int, default=4, help="devices updated concurrently")
+    ap.add_argument("--chunk", type=int, default=64 * 1024, help="image bytes per binary frame")
+    ap.add_argument("--retries", type=int, default=5, help="reconnect attempts per device")
+    ap.add_argument("--no-wait", dest="wait", action="store_false",
+                    help="don't wait for devices to reboot and confirm the new image")
+    ap.add_argument("--confirm-timeout", type=float, default=120.0)
+    args = ap.parse_args()
+
+    ips = list(args.ip)
+    if args.hosts:
+        with open(args.hosts) as f:
+            ips += [ln.split("#", 1)[0].strip() for ln in f if ln.split("#", 1)[0].strip()]
+    if not ips:
+        ap.error("no devices: use --ip and/or --hosts")
+
+    with open(args.bin, "rb") as f:
+        image = f.read()
+    if not image or image[0] != 0xE9:
+        ap.error(f"{args.bin} is not an ESP app image")
+
+    raise SystemExit(asyncio.run(push_fleet(ips, image, args)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""Stream gaze/mouth/eye values to one or many devices over the UDP face channel.
+
+Usage:
+  python3 tools/udp_face.py --ip 192.168.1.40 --gaze circle --hz 100 --duration 10
+  python3 tools/udp_face.py --discover --gaze circle --mouth talk     # every device found via mDNS
+  python3 tools/udp_face.py --ip A --ip B --mouth talk --loss 0.2 --reorder 0.1 --stats
+
+Notes:
+- Datagram (see README "UDP face channel"): 12-byte little-endian header
+    magic:u8=0x55, hdr_len:u8=12, fields:u8 (bit0 gaze x,y; bit1 mouth; bit2 eyes), reserved:u8,
+    stream_id:u16, reserved:u16, seq:u32
+  then one float32 LE per value, in bit order.
+- Latest value wins: nothing is acked, and the device drops any datagram whose seq is not newer
+  than the last one it applied from the same (address, port, stream_id).
+- --loss / --reorder simulate a bad link; --stats reads {"type":"udp_stats"} over /ws afterwards.
+"""
+
+import argparse
+import asyncio
+import json
+import math
+import random
+import socket
+import struct
+import time
+
+UDP_CTL_MAGIC = 0x55
+UDP_HDR = struct.Struct("<BBBBHHI")  # magic, hdr_len, fields, reserved, stream_id, reserved, seq
+F_GAZE, F_MOUTH, F_EYES = 0x01, 0x02, 0x04
+DEFAULT_PORT = 8082
+
+
+def datagram(stream_id: int, seq: int, gaze=None, mouth=None, eyes=None) -> bytes:
+    fields, values = 0, []
+    if gaze is not None:
+        fields |= F_GAZE
+        values += list(gaze)
+    if mouth is not None:
+        fields |= F_MOUTH
+        values.append(mouth)
+    if eyes is not None:
+        fields |= F_EYES
+        values.append(eyes)
+    hdr = UDP_HDR.pack(UDP_CTL_MAGIC, UDP_HDR.size, fields, 0, stream_id, 0, seq & 0xFFFFFFFF)
+    return hdr + struct.pack(f"<{len(values)}f", *values)
+
+
+def gaze_at(pattern: str, t: float):
+    if pattern == "circle":
+        return 0.8 * math.cos(t * 2 * math.pi * 0.5), 0.5 * math.sin(t * 2 * math.pi * 0.5)
+    if pattern == "scan":
+        return math.sin(t * 2 * math.pi * 0.25), 0.0
+    return None
+
+
+def mouth_at(pattern: str, t: float):
+    if pattern == "talk":
+        # Syllable-ish: a 4 Hz envelope with some irregularity.
+        return max(0.0, math.sin(t * 2 * math.pi * 4.0) * (0.6 + 0.4 * math.sin(t * 2 * math.pi * 0.7)))
+    if pattern == "hold":
+        return 0.5
+    return None
+
+
+def targets_from_args(args) -> list:
+    targets = [(ip, args.port) for ip in args.ip]
+    if args.discover:
+        from discover import browse  # needs zeroconf
+        for d in browse(args.discover_timeout):
+            port = d["txt"].get("udp")
+            if not port:
+                print(f"[{d['name']}] UDP channel off; skipped")
+                continue
+            targets.append((d["ip"], int(port)))
+    return targets
+
+
+async def read_stats(ip: str, reset: bool) -> dict:
+    import websockets
+    async with websockets.connect(f"ws://{ip}:8080/ws") as ws:
+        await ws.send(json.dumps({"type": "session", "role": "observer", "ack": "minimal"}))
+        await ws.send(json.dumps({"type": "udp_stats", "reset": reset}))
+        while True:
+            rep = json.loads(await asyncio.wait_for(ws.recv(), 5))
+            if rep.get("type") == "udp_stats":
+                return rep
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--ip", action="append", default=[], help="device IP (repeatable)")
+    ap.add_argument("--port", type=int, default=DEFAULT_PORT, help="UDP port for --ip devices")
+    ap.add_argument("--discover", action="store_true", help="also send to every device found via mDNS")
+    ap.add_argument("--discover-timeout", type=float, default=3.0)
+    ap.add_argument("--gaze", choices=["circle", "scan", "off"], default="circle")
+    ap.add_argument("--mouth", choices=["talk", "hold", "off"], default="off")
+    ap.add_argument("--eyes", type=float, help="also send this eye openness (0..1) in every datagram")
+    ap.add_argument("--hz", type=float, default=60.0, help="datagrams per second per device")
+    ap.add_argument("--duration", type=float, default=10.0, help="seconds to stream")
+    ap.add_argument("--stream-id", type=int, default=random.randrange(1, 0xFFFF))
+    ap.add_argument("--loss", type=float, default=0.0, help="drop this fraction of datagrams")
+    ap.add_argument("--reorder", type=float, default=0.0, help="send this fraction one period late")
+    ap.add_argument("--stats", action="store_true", help="print udp_stats of each --ip device at the end")
+    args = ap.parse_args()
+
+    targets = targets_from_args(args)
+    if not targets:
+        ap.error("no devices: use --ip and/or --discover")
+    if args.gaze == "off" and args.mouth == "off" and args.eyes is None:
+        ap.error("nothing to send: --gaze, --mouth or --eyes")
+
+    if args.stats:
+        for ip, _ in targets:
+            asyncio.run(read_stats(ip, reset=True))
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    period = 1.0 / args.hz
+    t0 = time.monotonic()
+    seq = sent = dropped = late = 0
+    held = []  # (send_at, payload, addr) delayed to arrive after newer datagrams
+    print(f"streaming to {len(targets)} device(s) at {args.hz:g} Hz for {args.duration:g} s "
+          f"(stream {args.stream_id})")
+
+    while True:
+        now = time.monotonic()
+        t = now - t0
+        if t >= args.duration:
+            break
+        seq += 1
+        payload = datagram(args.stream_id, seq, gaze=gaze_at(args.gaze, t), mouth=mouth_at(args.mouth, t),
+                           eyes=args.eyes)
+        for addr in targets:
+            r = random.random()
+            if r < args.loss:
+                dropped += 1
+            elif r < args.loss + args.reorder:
+                held.append((now + period * 1.5, payload, addr))
+                late += 1
+            else:
+                sock.sendto(payload, addr)
+                sent += 1
+        for item in [h for h in held if h[0] <= now]:
+            sock.sendto(item[1], item[2])
+            sent += 1
+            held.remove(item)
+        time.sleep(max(0.0, t0 + seq * period - time.monotonic()))
+
+    print(f"sent {sent} datagrams ({late} reordered), dropped {dropped} on purpose")
+    if args.stats:
+        for ip, _ in targets:
+            st = asyncio.run(read_stats(ip, reset=False))
+            print(f"[{ip}] rx={st.get('rx')} applied={st.get('applied')} stale={st.get('stale')} "
+                  f"malformed={st.get('malformed')} coalesced={st.get('coalesced')} busy={st.get('busy')}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,535 @@
+#!/usr/bin/env python3
+"""Load generator and latency benchmark for the device's WebSocket API.
+
+Usage:
+  python3 tools/ws_bench.py --ip DEVICE_IP --scenario tools/scenarios/production.json --json run.json --csv run.csv
+  python3 tools/ws_bench.py --ip DEVICE_IP --clients 2 --rate 100 --speech --duration 20
+  python3 tools/ws_bench.py --compare before.json after.json
+
+Notes:
+- A scenario is a JSON file listing client groups (see tools/scenarios/*.json):
+    {"name": "...", "duration_s": 30, "seed": 1, "stats_interval_s": 1,
+     "groups": [
+       {"name": "gaze", "kind": "control", "count": 2, "rate_hz": 50,
+        "mix": {"gaze": 8, "mouth": 2}, "ack": "minimal", "max_inflight": 32},
+       {"name": "watchers", "kind": "observer", "count": 2},
+       {"name": "tts", "kind": "speech", "count": 1, "codec": "adpcm", "sample_rate": 16000,
+        "lane": "audio", "utterance_s": 4, "gap_s": 1}],
+     "limits": {"p99_ms": {"gaze": 60, "*": 150}, "max_error_pct": 0.1, "max_underruns": 0}}
+- Control clients send commands open-loop at rate_hz (1..200), picked from `mix` by weight
+  with a seeded RNG, so two runs of one scenario send the same command sequence.
+- Latency is end to end: send -> matching reply (acks come back in order on a connection).
+- Observers take the observer role and count the state pushes they receive.
+- Speech clients stream a synthetic voice-like signal in real time (like speak_ws.py) to
+  :8081/ws/audio, or to /ws with "lane":"control".
+- A separate stats connection resets audio_stats/perf at the start, samples audio_stats
+  every stats_interval_s and reads both at the end (underruns, late/dropped chunks, handler times).
+- With "limits" the run exits non-zero when one is exceeded (release qualification).
+"""
+
+import argparse
+import asyncio
+import collections
+import csv
+import json
+import math
+import random
+import sys
+import time
+
+import websockets
+
+from pacing import pace
+from speak_ws import (chunk_samples_for, make_encoder, speak_frame, speak_json)
+
+CTL_PORT = 8080
+AUDIO_PORT = 8081
+EXPRESSIONS = ["neutral", "happy", "sad", "angry", "surprised", "thinking", "sleeping"]
+# Reply types that don't carry "cmd" (the reply type names the command otherwise).
+REPLY_CMD = {"pong": "ping", "state": "get_state"}
+PUSH_TYPES = {"state_delta", "touch"}
+PERCENTILES = [50, 90, 99, 99.9]
+
+
+# ---------- Command mix ----------
+
+def make_cmd(name: str, rng: random.Random, n: int) -> dict:
+    if name == "gaze":
+        return {"type": "gaze", "x": round(rng.uniform(-1, 1), 3), "y": round(rng.uniform(-1, 1), 3)}
+    if name == "mouth":
+        return {"type": "mouth", "open": round(rng.random(), 3)}
+    if name == "blink":
+        return {"type": "blink", "duration_ms": 120}
+    if name == "set_expression":
+        return {"type": "set_expression", "expression": rng.choice(EXPRESSIONS), "intensity": 1.0}
+    if name == "caption":
+        return {"type": "caption", "text": f"bench {n}", "ttl_ms": 1000}
+    if name == "viseme":
+        return {"type": "viseme", "name": rng.choice(["aa", "ee", "oh", "mm"]), "weight": 0.8, "ttl_ms": 200}
+    if name == "batch":
+        return {"type": "batch", "cmds": [make_cmd("gaze", rng, n), make_cmd("mouth", rng, n)]}
+    if name in ("ping", "get_state", "audio_stats", "perf"):
+        return {"type": name}
+    raise ValueError(f"unknown command in mix: {name}")
+
+
+def percentile(sorted_ms, p: float) -> float:
+    # Nearest rank.
+    if not sorted_ms:
+        return float("nan")
+    k = max(0, min(len(sorted_ms) - 1, math.ceil(p / 100.0 * len(sorted_ms)) - 1))
+    return sorted_ms[k]
+
+
+def latency_summary(ms) -> dict:
+    s = sorted(ms)
+    out = {f"p{p:g}": round(percentile(s, p), 3) for p in PERCENTILES}
+    out["max"] = round(s[-1], 3) if s else float("nan")
+    out["mean"] = round(sum(s) / len(s), 3) if s else float("nan")
+    return out
+
+
+# ---------- Connections ----------
+
+class CmdStats:
+    def __init__(self):
+        self.sent = 0
+        self.replied = 0
+        self.ok = 0
+        self.lost = 0
+        self.errors = collections.Counter()
+        self.lat_ms = []
+
+    def merge(self, o: "CmdStats") -> None:
+        self.sent += o.sent
+        self.replied += o.replied
+        self.ok += o.ok
+        self.lost += o.lost
+        self.errors.update(o.errors)
+        self.lat_ms += o.lat_ms
+
+    def to_dict(self, duration_s: float) -> dict:
+        return {
+            "sent": self.sent, "replied": self.replied, "ok": self.ok, "lost": self.lost,
+            "errors": dict(self.errors), "replies_per_s": round(self.replied / duration_s, 2),
+            "latency_ms": latency_summary(self.lat_ms),
+        }
+
+
+class Conn:
+    """One WebSocket; a reader task matches replies to requests in send order."""
+
+    def __init__(self, ws):
+        self.ws = ws
+        self.pending = collections.deque()  # (cmd, t_send, future | None)
+        self.stats = collections.defaultdict(CmdStats)
+        self.pushes = collections.Counter()
+        self.unmatched = 0
+        self.reader = asyncio.ensure_future(self._read())
+
+    async def send(self, cmd: str, msg, want_reply: bool = False):
+        fut = asyncio.get_running_loop().create_future() if want_reply else None
+        self.pending.append((cmd, time.perf_counter(), fut))
+        self.stats[cmd].sent += 1
+        await self.ws.send(msg)
+        return fut
+
+    async def request(self, msg: dict, timeout: float = 10.0) -> dict:
+        fut = await self.send(msg["type"], json.dumps(msg), want_reply=True)
+        return await asyncio.wait_for(fut, timeout)
+
+    def inflight(self) -> int:
+        return len(self.pending)
+
+    async def _read(self) -> None:
+        try:
+            async for raw in self.ws:
+                now = time.perf_counter()
+                try:
+                    rep = json.loads(raw)
+                except (TypeError, ValueError):
+                    continue
+                typ = rep.get("type")
+                if typ in PUSH_TYPES:
+                    self.pushes[typ] += 1
+                    continue
+                name = rep.get("cmd") or REPLY_CMD.get(typ, typ)
+                # Replies come back in order; anything skipped over was never answered.
+                while self.pending and name and self.pending[0][0] != name and \
+                        any(p[0] == name for p in self.pending):
+                    lost, _, fut = self.pending.popleft()
+                    self.stats[lost].lost += 1
+                    if fut and not fut.done():
+                        fut.set_exception(RuntimeError("reply lost"))
+                if not self.pending:
+                    self.unmatched += 1
+                    continue
+                cmd, t0, fut = self.pending.popleft()
+                st = self.stats[cmd]
+                st.replied += 1
+                st.lat_ms.append((now - t0) * 1000.0)
+                if rep.get("ok"):
+                    st.ok += 1
+                else:
+                    st.errors[rep.get("error", "unknown")] += 1
+                if fut and not fut.done():
+                    fut.set_result(rep)
+        except websockets.WebSocketException:
+            pass
+
+    async def close(self) -> None:
+        # Give outstanding replies a moment, then count the rest as lost.
+        for _ in range(20):
+            if not self.pending:
+                break
+            await asyncio.sleep(0.05)
+        for cmd, _, fut in self.pending:
+            self.stats[cmd].lost += 1
+            if fut and not fut.done():
+                fut.cancel()
+        self.pending.clear()
+        await self.ws.close()
+        self.reader.cancel()
+
+
+async def connect(ip: str, port: int, path: str) -> Conn:
+    ws = await websockets.connect(f"ws://{ip}:{port}{path}", max_size=None, open_timeout=10)
+    return Conn(ws)
+
+
+# ---------- Clients ----------
+
+async def run_control(conn: Conn, g: dict, rng: random.Random, deadline: float, out: dict) -> None:
+    mix = g.get("mix", {"gaze": 1})
+    names, weights = list(mix), list(mix.values())
+    rate = max(1.0, min(200.0, float(g.get("rate_hz", 20))))
+    max_inflight = int(g.get("max_inflight", 32))
+    period = 1.0 / rate
+    n = 0
+    next_t = time.perf_counter()
+    while True:
+        now = time.perf_counter()
+        if now >= deadline:
+            break
+        if next_t > now:
+            await asyncio.sleep(next_t - now)
+        elif now - next_t > 1.0:
+            out["behind"] += 1  # host fell a second behind schedule; restart the clock
+            next_t = now
+        next_t += period
+        if conn.inflight() >= max_inflight:
+            out["throttled"] += 1
+            continue
+        name = rng.choices(names, weights)[0]
+        await conn.send(name, json.dumps(make_cmd(name, rng, n)))
+        n += 1
+
+
+def synth_voice(seconds: float, rate: int, rng: random.Random) -> bytes:
+    # Vowel-like harmonics under a ~4 Hz syllable envelope, so on-device lip sync has work to do.
+    f0 = rng.uniform(110, 220)
+    n = int(seconds * rate)
+    pcm = bytearray()
+    for i in range(n):
+        t = i / rate
+        env = 0.5 - 0.5 * math.cos(2 * math.pi * 4.0 * t)
+        v = sum(math.sin(2 * math.pi * f0 * h * t) / h for h in (1, 2, 3, 5))
+        pcm += int(max(-32767, min(32767, 9000 * env * v))).to_bytes(2, "little", signed=True)
+    return bytes(pcm)
+
+
+def encode_utterance(g: dict, seed) -> list:
+    # Synthesized and encoded before the run starts, so the host's CPU time doesn't land in
+    # the latencies being measured. Returns [(ts_ms, payload)].
+    codec = g.get("codec", "adpcm")
+    rate = int(g.get("sample_rate", 16000))
+    pcm = synth_voice(float(g.get("utterance_s", 4)), rate, random.Random(f"{seed}:{g['name']}"))
+    encoder = make_encoder(codec, int(g.get("bitrate", 16000)), rate)
+    chunk_bytes = chunk_samples_for(codec, rate) * 2
+    return [((off // 2) * 1000 // rate, encoder.encode(pcm[off:off + chunk_bytes]))
+            for off in range(0, len(pcm), chunk_bytes)]
+
+
+async def run_speech(conn: Conn, g: dict, rng: random.Random, deadline: float, out: dict) -> None:
+    codec = g.get("codec", "adpcm")
+    rate = int(g.get("sample_rate", 16000))
+    binary = g.get("transport", "binary") == "binary"
+    chunks = out["utterance"]
+    gap_s = float(g.get("gap_s", 1))
+    name = "speak_bin" if binary else "speak"
+
+    while time.perf_counter() < deadline:
+        stream_id = rng.randrange(1, 0x10000)
+        for seq, (ts_ms, payload) in enumerate(chunks):
+            end = seq == len(chunks) - 1
+            msg = (speak_frame(stream_id, seq, ts_ms, payload, end, codec, rate) if binary
+                   else speak_json(stream_id, seq, ts_ms, payload, end, codec, rate))
+            try:
+                rep = await asyncio.wait_for(await conn.send(name, msg, want_reply=True), 10.0)
+            except (asyncio.TimeoutError, RuntimeError):
+                out["speech_timeouts"] += 1
+                continue
+            await pace(rep)  # stay at most MAX_LEAD_MS ahead of playout, as a real TTS host would
+            if time.perf_counter() >= deadline:
+                break
+        out["utterances"] += 1
+        await asyncio.sleep(gap_s)
+
+
+async def run_observer(conn: Conn, deadline: float) -> None:
+    await asyncio.sleep(max(0.0, deadline - time.perf_counter()))
+
+
+async def run_client(ip: str, g: dict, idx: int, seed: int, deadline: float, group_out: dict) -> None:
+    kind = g.get("kind", "control")
+    rng = random.Random(f"{seed}:{g['name']}:{idx}")
+    try:
+        if kind == "speech" and g.get("lane", "audio") == "audio":
+            conn = await connect(ip, AUDIO_PORT, "/ws/audio")
+        else:
+            conn = await connect(ip, CTL_PORT, "/ws")
+    except (OSError, asyncio.TimeoutError, websockets.WebSocketException) as e:
+        group_out["connect_errors"].append(repr(e))
+        return
+    try:
+        session = {"type": "session", "ack": g.get("ack", "minimal")}
+        if kind in ("control", "observer"):
+            session["role"] = "observer" if kind == "observer" else g.get("role", "controller")
+        rep = await conn.request(session)
+        if not rep.get("ok"):
+            group_out["connect_errors"].append(f"session: {rep.get('error')}")
+            return
+        if kind == "control":
+            await run_control(conn, g, rng, deadline, group_out)
+        elif kind == "speech":
+            await run_speech(conn, g, rng, deadline, group_out)
+        else:
+            await run_observer(conn, deadline)
+    except (OSError, asyncio.TimeoutError, websockets.WebSocketException) as e:
+        group_out["disconnects"].append(repr(e))
+    finally:
+        await conn.close()
+        group_out["conns"].append(conn)
+
+
+async def sample_stats(conn: Conn, interval: float, deadline: float, t0: float, series: list) -> None:
+    while time.perf_counter() < deadline:
+        await asyncio.sleep(interval)
+        try:
+            st = await conn.request({"type": "audio_stats"})
+        except (asyncio.TimeoutError, RuntimeError):
+            continue
+        series.append({"t_s": round(time.perf_counter() - t0, 2),
+                       **{k: st.get(k) for k in ("queued_ms", "underruns", "late", "dropped", "concealed_ms")}})
+
+
+# ---------- Run ----------
+
+async def run(ip: str, sc: dict, label: str) -> dict:
+    duration = float(sc.get("duration_s", 30))
+    seed = sc.get("seed", 1)
+
+    stats_conn = await connect(ip, CTL_PORT, "/ws")
+    ota = await stats_conn.request({"type": "ota_status"})
+    await stats_conn.request({"type": "audio_stats", "reset": True})
+    await stats_conn.request({"type": "perf", "reset": True})
+
+    t0 = time.perf_counter()
+    deadline = t0 + duration
+    groups = []
+    tasks = []
+    for g in sc["groups"]:
+        out = {"name": g["name"], "kind": g.get("kind", "control"), "spec": g, "conns": [],
+               "connect_errors": [], "disconnects": [], "throttled": 0, "behind": 0,
+               "utterances": 0, "speech_timeouts": 0}
+        if out["kind"] == "speech":
+            out["utterance"] = encode_utterance(g, seed)
+        groups.append(out)
+        for i in range(int(g.get("count", 1))):
+            tasks.append(run_client(ip, g, i, seed, deadline, out))
+    series = []
+    tasks.append(sample_stats(stats_conn, float(sc.get("stats_interval_s", 1)), deadline, t0, series))
+    await asyncio.gather(*tasks)
+    elapsed = time.perf_counter() - t0
+
+    audio = await stats_conn.request({"type": "audio_stats"})
+    perf = await stats_conn.request({"type": "perf"})
+    await stats_conn.close()
+
+    res = {
+        "label": label,
+        "scenario": sc,
+        "device": {"ip": ip, "version": ota.get("version"), "running": ota.get("running")},
+        "started": time.strftime("%Y-%m-%dT%H:%M:%S%z"),
+        "duration_s": round(elapsed, 2),
+        "groups": [],
+        "audio": {k: audio.get(k) for k in ("underruns", "late", "dropped", "concealed_ms", "queued_ms")},
+        "perf": {k: {f: perf[k].get(f) for f in ("count", "avg", "max")}
+                 for k in ("ws_handler", "ws_audio", "audio_write", "frame") if isinstance(perf.get(k), dict)},
+        "audio_series": series,
+    }
+    for out in groups:
+        merged = collections.defaultdict(CmdStats)
+        pushes = collections.Counter()
+        for c in out["conns"]:
+            for cmd, st in c.stats.items():
+                merged[cmd].merge(st)
+            pushes.update(c.pushes)
+        res["groups"].append({
+            "name": out["name"], "kind": out["kind"], "clients": len(out["conns"]),
+            "cmds": {cmd: st.to_dict(elapsed) for cmd, st in sorted(merged.items()) if cmd != "session"},
+            "pushes_per_s": {k: round(v / elapsed, 2) for k, v in pushes.items()},
+            "throttled": out["throttled"], "behind": out["behind"],
+            "utterances": out["utterances"], "speech_timeouts": out["speech_timeouts"],
+            "connect_errors": out["connect_errors"], "disconnects": out["disconnects"],
+        })
+    return res
+
+
+def check_limits(res: dict) -> list:
+    lim = res["scenario"].get("limits", {})
+    fails = []
+    p99 = lim.get("p99_ms", {})
+    sent = errors = 0
+    for g in res["groups"]:
+        if g["connect_errors"]:
+            fails.append(f"{g['name']}: connect errors {g['connect_errors']}")
+        for cmd, st in g["cmds"].items():
+            sent += st["sent"]
+            errors += st["sent"] - st["ok"]
+            limit = p99.get(cmd, p99.get("*"))
+            if limit is not None and not st["latency_ms"]["p99"] <= limit:
+                fails.append(f"{g['name']}/{cmd}: p99 {st['latency_ms']['p99']} ms > {limit} ms")
+    if "max_error_pct" in lim and sent and errors * 100.0 / sent > lim["max_error_pct"]:
+        fails.append(f"errors {errors}/{sent} ({errors * 100.0 / sent:.3f}%) > {lim['max_error_pct']}%")
+    if "max_underruns" in lim and (res["audio"].get("underruns") or 0) > lim["max_underruns"]:
+        fails.append(f"underruns {res['audio']['underruns']} > {lim['max_underruns']}")
+    return fails
+
+
+# ---------- Output ----------
+
+CSV_FIELDS = ["label", "version", "group", "kind", "clients", "cmd", "sent", "replied", "ok", "lost", "errors",
+              "replies_per_s"] + [f"p{p:g}_ms" for p in PERCENTILES] + ["max_ms", "mean_ms"]
+
+
+def csv_rows(res: dict):
+    for g in res["groups"]:
+        for cmd, st in g["cmds"].items():
+            lat = st["latency_ms"]
+            row = {"label": res["label"], "version": res["device"]["version"], "group": g["name"], "kind": g["kind"],
+                   "clients": g["clients"], "cmd": cmd, "sent": st["sent"], "replied": st["replied"], "ok": st["ok"],
+                   "lost": st["lost"], "errors": ";".join(f"{k}={v}" for k, v in st["errors"].items()),
+                   "replies_per_s": st["replies_per_s"], "max_ms": lat["max"], "mean_ms": lat["mean"]}
+            row.update({f"p{p:g}_ms": lat[f"p{p:g}"] for p in PERCENTILES})
+            yield row
+
+
+def print_summary(res: dict) -> None:
+    d = res["device"]
+    print(f"{res['label'] or res['scenario'].get('name', 'run')}: {d['version']} ({d['running']}) "
+          f"at {d['ip']}, {res['duration_s']} s")
+    print(f"{'group/cmd':<24}{'sent':>8}{'ok':>8}{'/s':>8}{'p50':>8}{'p90':>8}{'p99':>8}{'max':>8}  errors")
+    for g in res["groups"]:
+        for cmd, st in g["cmds"].items():
+            lat = st["latency_ms"]
+            errs = ", ".join(f"{k}={v}" for k, v in st["errors"].items())
+            if st["lost"]:
+                errs += (", " if errs else "") + f"lost={st['lost']}"
+            print(f"{g['name'] + '/' + cmd:<24}{st['sent']:>8}{st['ok']:>8}{st['replies_per_s']:>8.1f}"
+                  f"{lat['p50']:>8.1f}{lat['p90']:>8.1f}{lat['p99']:>8.1f}{lat['max']:>8.1f}  {errs}")
+        extra = [f"{k}={g[k]}" for k in ("throttled", "behind", "utterances", "speech_timeouts") if g[k]]
+        extra += [f"{k}/s={v}" for k, v in g["pushes_per_s"].items()]
+        extra += [f"connect_errors={len(g['connect_errors'])}"] if g["connect_errors"] else []
+        if extra:
+            print(f"  {g['name']}: " + " ".join(extra))
+    a = res["audio"]
+    print(f"audio: underruns={a['underruns']} late={a['late']} dropped={a['dropped']} concealed_ms={a['concealed_ms']}")
+    for k, v in res["perf"].items():
+        print(f"perf {k}: count={v['count']} avg={v['avg']} us max={v['max']} us")
+
+
+def compare(a: dict, b: dict) -> None:
+    print(f"A: {a['label']} {a['device']['version']}   B: {b['label']} {b['device']['version']}")
+    print(f"{'group/cmd':<24}{'p50 A':>9}{'p50 B':>9}{'p99 A':>9}{'p99 B':>9}{'p99 %':>8}{'err A':>7}{'err B':>7}")
+    gb = {g["name"]: g for g in b["groups"]}
+    for g in a["groups"]:
+        for cmd, sa in g["cmds"].items():
+            sb = gb.get(g["name"], {}).get("cmds", {}).get(cmd)
+            if not sb:
+                continue
+            la, lb = sa["latency_ms"], sb["latency_ms"]
+            pct = (lb["p99"] - la["p99"]) * 100.0 / la["p99"] if la["p99"] else float("nan")
+            print(f"{g['name'] + '/' + cmd:<24}{la['p50']:>9.1f}{lb['p50']:>9.1f}{la['p99']:>9.1f}{lb['p99']:>9.1f}"
+                  f"{pct:>+8.1f}{sa['sent'] - sa['ok']:>7}{sb['sent'] - sb['ok']:>7}")
+    for k in ("underruns", "late", "dropped", "concealed_ms"):
+        print(f"audio {k}: {a['audio'].get(k)} -> {b['audio'].get(k)}")
+    for k in sorted(set(a["perf"]) & set(b["perf"])):
+        print(f"perf {k} avg/max us: {a['perf'][k]['avg']}/{a['perf'][k]['max']} -> "
+              f"{b['perf'][k]['avg']}/{b['perf'][k]['max']}")
+
+
+def adhoc_scenario(args) -> dict:
+    groups = [{"name": "control", "kind": "control", "count": args.clients, "rate_hz": args.rate,
+               "mix": {"gaze": 6, "mouth": 3, "blink": 1}}]
+    if args.observers:
+        groups.append({"name": "observers", "kind": "observer", "count": args.observers})
+    if args.speech:
+        groups.append({"name": "speech", "kind": "speech", "count": 1, "codec": args.codec})
+    return {"name": "adhoc", "duration_s": args.duration, "seed": args.seed, "stats_interval_s": 1, "groups": groups}
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--ip")
+    ap.add_argument("--scenario", help="scenario JSON file (see tools/scenarios/)")
+    ap.add_argument("--label", default="", help="tag stored with the results (e.g. the build under test)")
+    ap.add_argument("--json", help="write full results here")
+    ap.add_argument("--csv", help="write one row per group/command here")
+    ap.add_argument("--compare", nargs=2, metavar=("A.json", "B.json"), help="compare two result files and exit")
+    # Ad-hoc scenario when --scenario is not given.
+    ap.add_argument("--clients", type=int, default=1, help="control clients")
+    ap.add_argument("--rate", type=float, default=50, help="commands per second per control client (1..200)")
+    ap.add_argument("--observers", type=int, default=0)
+    ap.add_argument("--speech", action="store_true", help="stream speech in parallel")
+    ap.add_argument("--codec", choices=["pcm16", "adpcm", "opus"], default="adpcm")
+    ap.add_argument("--duration", type=float, default=20)
+    ap.add_argument("--seed", type=int, default=1)
+    args = ap.parse_args()
+
+    if args.compare:
+        with open(args.compare[0]) as fa, open(args.compare[1]) as fb:
+            compare(json.load(fa), json.load(fb))
+        return
+    if not args.ip:
+        ap.error("--ip is required")
+
+    if args.scenario:
+        with open(args.scenario) as f:
+            sc = json.load(f)
+    else:
+        sc = adhoc_scenario(args)
+    # One speech voice on the device: a second stream_id restarts the first on every chunk.
+    streams = sum(int(g.get("count", 1)) for g in sc["groups"] if g.get("kind") == "speech")
+    if streams > 1:
+        ap.error(f"scenario has {streams} speech streams; the device plays one at a time")
+
+    res = asyncio.run(run(args.ip, sc, args.label))
+    print_summary(res)
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(res, f, indent=2)
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            w = csv.DictWriter(f, fieldnames=CSV_FIELDS)
+            w.writeheader()
+            w.writerows(csv_rows(res))
+
+    fails = check_limits(res)
+    for msg in fails:
+        print(f"FAIL {msg}")
+    sys.exit(1 if fails else 0)
+
+
+if __name__ == "__main__":
+    main()